@@ -92,16 +92,30 @@
          if required to create a larger memory block.
 */
 
+#ifdef CLA_OFFLOAD
+/* Scratchpad the CLA compiler keeps task locals in (see cla_shared.h) */
+CLA_SCRATCHPAD_SIZE = 0x100;
+--undef_sym=__cla_scratchpad_end
+--undef_sym=__cla_scratchpad_start
+#endif
+
 MEMORY
 {
 PAGE 0 :   /* Program Memory */
            /* Memory (RAM/FLASH/OTP) blocks can be moved to PAGE1 for data allocation */
    RAML0       : origin = 0x008000, length = 0x000800     /* on-chip RAM block L0 */
+#ifdef CLA_OFFLOAD
+   RAML3       : origin = 0x009000, length = 0x001000     /* on-chip RAM block L3, CLA program RAM */
+#else
    RAML1       : origin = 0x008800, length = 0x000400     /* on-chip RAM block L1 */
+#endif
+#ifdef CONFIG_STORE
+   RAMM1       : origin = 0x000400, length = 0x000400     /* on-chip RAM block M1, Flash API (config_store.h) */
+#endif
    OTP         : origin = 0x3D7800, length = 0x000400     /* on-chip OTP */
 
-   FLASHH      : origin = 0x3D8000, length = 0x004000     /* on-chip FLASH */
-   FLASHG      : origin = 0x3DC000, length = 0x004000     /* on-chip FLASH */
+   FLASHH      : origin = 0x3D8000, length = 0x004000     /* on-chip FLASH, saved configuration (config_store.h) */
+   FLASHG      : origin = 0x3DC000, length = 0x004000     /* on-chip FLASH, saved configuration (config_store.h) */
    FLASHF      : origin = 0x3E0000, length = 0x004000     /* on-chip FLASH */
    FLASHE      : origin = 0x3E4000, length = 0x004000     /* on-chip FLASH */   
    FLASHD      : origin = 0x3E8000, length = 0x004000     /* on-chip FLASH */
@@ -126,8 +140,17 @@ PAGE 1 :   /* Data Memory */
 
    BOOT_RSVD   : origin = 0x000000, length = 0x000050     /* Part of M0, BOOT rom will use this for stack */
    RAMM0       : origin = 0x000050, length = 0x0003B0     /* on-chip RAM block M0 */
+#ifndef CONFIG_STORE
    RAMM1       : origin = 0x000400, length = 0x000400     /* on-chip RAM block M1 */
+#endif
+#ifdef CLA_OFFLOAD
+   CLA1_MSGRAMLOW  : origin = 0x001480, length = 0x000080 /* CLA to CPU message RAM */
+   CLA1_MSGRAMHIGH : origin = 0x001500, length = 0x000080 /* CPU to CLA message RAM */
+   RAML1       : origin = 0x008800, length = 0x000400     /* on-chip RAM block L1, CLA data RAM 0 */
+   RAML2       : origin = 0x008C00, length = 0x000400     /* on-chip RAM block L2, CLA data RAM 1 */
+#else
    RAML2_3     : origin = 0x008C00, length = 0x001400     /* on-chip RAM block L2 */
+#endif
    RAML4       : origin = 0x00A000, length = 0x002000     /* on-chip RAM block L4 */
    RAML5       : origin = 0x00C000, length = 0x002000     /* on-chip RAM block L5 */
    RAML6       : origin = 0x00E000, length = 0x002000     /* on-chip RAM block L6 */
@@ -159,13 +182,34 @@ SECTIONS
                          RUN_START(_RamfuncsRunStart),
                          PAGE = 0
 
+#ifdef CONFIG_STORE
+   /* Flash API, copied to RAM by config_init(), it cannot run from the flash it programs.
+      M1, so it does not compete with ramfuncs for L0 */
+   Flash28_API         :
+   {
+                         -lFlash2806x_API_V100.lib(.econst)
+                         -lFlash2806x_API_V100.lib(.text)
+                       } LOAD = FLASHD,
+                         RUN = RAMM1,
+                         LOAD_START(_Flash28_API_LoadStart),
+                         LOAD_END(_Flash28_API_LoadEnd),
+                         RUN_START(_Flash28_API_RunStart),
+                         PAGE = 0
+#endif
+
    csmpasswds          : > CSM_PWL_P0, PAGE = 0
    csm_rsvd            : > CSM_RSVD,   PAGE = 0
 
    /* Allocate uninitalized data sections: */
    .stack              : > RAMM0,      PAGE = 1
+#ifdef CLA_OFFLOAD
+   /* L2 and L3 belong to the CLA, L8 has room next to the PWM data */
+   .ebss               : > RAML8,      PAGE = 1
+   .esysmem            : > RAML8,      PAGE = 1
+#else
    .ebss               : > RAML2_3,    PAGE = 1
    .esysmem            : > RAML2_3,    PAGE = 1
+#endif
 
    /* Initalized sections to go in Flash */
    /* For SDFlash to program these, they must be allocated to page 0 */
@@ -184,6 +228,38 @@ SECTIONS
    DMARAML7	           : > RAML7,      PAGE = 1
    DMARAML8	           : > RAML8,      PAGE = 1   
 
+   /* Data read by the PWM ISR every period (sine table, waveform plans) */
+   pwmdata             : > RAML8,      PAGE = 1
+
+   /* Double buffered user waveform tables, 2 x 4096 Q15 samples fill L4 */
+   wavetables          : > RAML4,      PAGE = 1
+
+#ifdef CLA_OFFLOAD
+   /* CLA program and constants, copied to CLA RAM by cla_init() */
+   Cla1Prog            : LOAD = FLASHD,
+                         RUN = RAML3,
+                         LOAD_START(_Cla1funcsLoadStart),
+                         LOAD_SIZE(_Cla1funcsLoadSize),
+                         RUN_START(_Cla1funcsRunStart),
+                         PAGE = 0
+   .const_cla          : LOAD = FLASHD,
+                         RUN = RAML2,
+                         LOAD_START(_Cla1ConstLoadStart),
+                         LOAD_SIZE(_Cla1ConstLoadSize),
+                         RUN_START(_Cla1ConstRunStart),
+                         PAGE = 1
+
+   /* Sine table read by the CLA task and the ISR, CLA variables and the message RAMs */
+   ClaSineTable        : > RAML1,      PAGE = 1
+   CLAscratch          : { *.obj(CLAscratch)
+                           . += CLA_SCRATCHPAD_SIZE;
+                           *.obj(CLAscratch_end) } > RAML2, PAGE = 1
+   .scratchpad         : > RAML2,      PAGE = 1
+   .bss_cla            : > RAML2,      PAGE = 1
+   Cla1ToCpuMsgRAM     : > CLA1_MSGRAMLOW,  PAGE = 1
+   CpuToCla1MsgRAM     : > CLA1_MSGRAMHIGH, PAGE = 1
+#endif
+
   /* Uncomment the section below if calling the IQNexp() or IQexp()
       functions from the IQMath.lib library in order to utilize the
       relevant IQ Math table in Boot ROM (This saves space and Boot ROM
@@ -0,0 +1,139 @@
+/*
+ * benchmark.c
+ *
+ *  Host run of the waveform kernel benchmark (bench.h): boots the firmware built with KERNEL_BENCHMARK,
+ *  which runs the benchmark before its welcome screen, and writes the CSV lines it sent over SCI A.
+ *  The kernels run at host speed and are timed with the host's monotonic clock (hal_benchmark_ticks()),
+ *  so ns_per_sample is host time and cycles_per_sample stays empty. THD, SFDR, the frequency error and
+ *  the effective bits are computed by the same code as on the target. Fails if any of them is not a number.
+ *  The three phase kernels (BENCH3 lines) are summed up on standard error against sinf x3, the rotation
+ *  kernels replace three sinf calls per sample; fails if the sinf x3 line or a rotation kernel is missing.
+ *
+ *  kernel_benchmark [-o results.csv]
+ *    -o  CSV output, standard output if not given
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+#define BENCHMARK_DRAIN_SECONDS 60      // Simulated time the TX ring gets to send the last lines
+#define BENCHMARK_LINE_MAX 160          // Longer than any CSV line (bench.c formats them into 120 characters)
+#define BENCHMARK_THREE_PHASE_MAX 8     // BENCH3 kernels kept for the summary
+
+// Time per sample and error of one three phase kernel, from its BENCH3 line
+typedef struct
+{
+    char name[32];
+    double ns;
+    double maxError;
+} ThreePhaseResult;
+
+int main(int argc, char **argv)
+{
+    FILE *out = stdout;
+    const char *text, *line, *end;
+    Uint32 count, waited, invalid = 0;
+    ThreePhaseResult threePhase[BENCHMARK_THREE_PHASE_MAX];
+    Uint32 threePhaseCount = 0, i;
+    double sinfNs = 0;
+    int rotations = 0;
+
+    if (argc == 3 && strcmp(argv[1], "-o") == 0)
+    {
+        out = fopen(argv[2], "w");
+        if (!out)
+        {
+            perror(argv[2]);
+            return 1;
+        }
+    }
+    else if (argc != 1)
+    {
+        fprintf(stderr, "usage: kernel_benchmark [-o results.csv]\n");
+        return 1;
+    }
+
+    // The benchmark runs inside firmware_init(), the rest of its output drains from the TX ring after it
+    sim_boot();
+    for (waited = 0; !strstr(sim_sci_output(&count), "BENCH,done"); waited++)
+    {
+        if (waited == BENCHMARK_DRAIN_SECONDS)
+        {
+            fprintf(stderr, "kernel_benchmark: the benchmark did not finish\n");
+            return 1;
+        }
+        sim_run_seconds(1.0);
+    }
+
+    // Keep the BENCH lines, the welcome screen follows them
+    text = sim_sci_output(&count);
+    for (line = text; line < text + count; line = end + 1)
+    {
+        end = memchr(line, '\n', text + count - line);
+        if (!end)
+        {
+            end = text + count;
+        }
+        if (strncmp(line, "BENCH", 5) == 0)
+        {
+            char csv[BENCHMARK_LINE_MAX], fields[BENCHMARK_LINE_MAX];
+            int length = end - line - (end > line && end[-1] == '\r');
+            char *field;
+
+            snprintf(csv, sizeof(csv), "%.*s", length, line);
+            fprintf(out, "%s\n", csv);
+
+            // Every grid point the benchmark measures has to give numbers
+            strcpy(fields, csv);
+            for (field = strtok(fields, ","); field; field = strtok(NULL, ","))
+            {
+                if (strstr(field, "nan") == field + (*field == '-')
+                    || strstr(field, "inf") == field + (*field == '-'))
+                {
+                    fprintf(stderr, "kernel_benchmark: %s\n", csv);
+                    invalid++;
+                    break;
+                }
+            }
+
+            // BENCH3,kernel,cycles_per_sample,ns_per_sample,max_error_q15 after its header, the cycles are empty here
+            if (strncmp(csv, "BENCH3,", 7) == 0 && strncmp(csv + 7, "kernel,", 7) != 0
+                    && threePhaseCount < BENCHMARK_THREE_PHASE_MAX)
+            {
+                ThreePhaseResult *result = &threePhase[threePhaseCount++];
+                const char *comma = strchr(csv + 7, ',');
+                int nameLength = comma ? comma - (csv + 7) : 0;
+
+                snprintf(result->name, sizeof(result->name), "%.*s", nameLength, csv + 7);
+                comma = comma ? strchr(comma + 1, ',') : NULL;
+                result->ns = comma ? atof(comma + 1) : 0;
+                comma = comma ? strchr(comma + 1, ',') : NULL;
+                result->maxError = comma ? atof(comma + 1) : 0;
+                if (strcmp(result->name, "sinf_x3") == 0)
+                {
+                    sinfNs = result->ns;
+                }
+                rotations += strncmp(result->name, "rotation", 8) == 0;
+            }
+        }
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    // Three phase kernels against three sinf calls per sample
+    if (sinfNs <= 0 || rotations != 2)
+    {
+        fprintf(stderr, "kernel_benchmark: the three phase kernels are missing\n");
+        return 1;
+    }
+    for (i = 0; i < threePhaseCount; i++)
+    {
+        fprintf(stderr, "%-22s %6.1f ns per sample, %5.2f x sinf x3, max error %.3f Q15 steps\n",
+                threePhase[i].name, threePhase[i].ns, sinfNs / threePhase[i].ns, threePhase[i].maxError);
+    }
+    return invalid ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * flash_sim.c
+ *
+ *  Flash emulator for the host build of the saved configuration, see flash_sim.h.
+ */
+#include <string.h>
+#include "flash_sim.h"
+#include "Flash2806x_API_Library.h"
+
+Uint16 simFlashSectorG[CONFIG_SECTOR_WORDS];
+Uint16 simFlashSectorH[CONFIG_SECTOR_WORDS];
+jmp_buf simFlashPowerLoss;
+SimFlashStats simFlashStats;
+
+// Flash API variables config_init() sets
+Uint32 Flash_CPUScaleFactor;
+void (*Flash_CallbackPtr)(void);
+
+static long operationsLeft = -1;
+static Uint32 randomState = 1;
+
+// Linear congruential generator for the state a power loss leaves behind
+static Uint16 random_word(void)
+{
+    randomState = randomState * 1664525 + 1013904223;
+    return randomState >> 16;
+}
+
+void sim_flash_seed(Uint32 seed)
+{
+    randomState = seed;
+}
+
+void sim_flash_erase_all(void)
+{
+    memset(simFlashSectorG, 0xFF, sizeof(simFlashSectorG));
+    memset(simFlashSectorH, 0xFF, sizeof(simFlashSectorH));
+}
+
+void sim_flash_power_loss_after(long operations)
+{
+    operationsLeft = operations;
+}
+
+// Counts one word operation, returns 1 if the armed power loss hits it
+static int power_lost(void)
+{
+    if (operationsLeft < 0 || operationsLeft-- > 0)
+    {
+        return 0;
+    }
+    simFlashStats.powerLosses++;
+    return 1;
+}
+
+Uint16 Flash_Erase(Uint16 SectorMask, FLASH_ST *FEraseStat)
+{
+    Uint16 *sector = SectorMask == SECTORG ? simFlashSectorG : simFlashSectorH;
+    Uint32 i;
+
+    if (SectorMask != SECTORG && SectorMask != SECTORH)
+    {
+        return STATUS_FAIL_PROGRAM;
+    }
+    if (power_lost())
+    {
+        // The erase first programs every bit to 0 and then erases, cut anywhere in between
+        for (i = 0; i < CONFIG_SECTOR_WORDS; i++)
+        {
+            switch (random_word() & 3)
+            {
+            case 0:
+                sector[i] = 0xFFFF;
+                break;
+            case 1:
+                sector[i] &= random_word();
+                break;
+            case 2:
+                sector[i] = 0;
+                break;
+            default:
+                break;
+            }
+        }
+        longjmp(simFlashPowerLoss, 1);
+    }
+
+    memset(sector, 0xFF, CONFIG_SECTOR_WORDS * sizeof(Uint16));
+    simFlashStats.erases++;
+    return STATUS_SUCCESS;
+}
+
+Uint16 Flash_Program(Uint16 *FlashAddr, Uint16 *BufAddr, Uint32 Length, FLASH_ST *FProgStatus)
+{
+    Uint32 i;
+
+    simFlashStats.programs++;
+    for (i = 0; i < Length; i++)
+    {
+        if (power_lost())
+        {
+            FlashAddr[i] &= BufAddr[i] | random_word();
+            longjmp(simFlashPowerLoss, 1);
+        }
+        FlashAddr[i] &= BufAddr[i];
+        simFlashStats.words++;
+        if (FlashAddr[i] != BufAddr[i])
+        {
+            FProgStatus->FirstFailAddr = i;
+            FProgStatus->ExpectedData = BufAddr[i];
+            FProgStatus->ActualData = FlashAddr[i];
+            return STATUS_FAIL_PROGRAM;
+        }
+    }
+    return STATUS_SUCCESS;
+}
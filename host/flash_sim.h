@@ -0,0 +1,39 @@
+/*
+ * flash_sim.h
+ *
+ *  Flash emulator of the host build for the saved configuration (config_store.h, built with CONFIG_STORE).
+ *  Sectors G and H are word arrays. An erase sets every word of a sector to 0xFFFF, a program can only clear
+ *  bits, like the flash cells, and fails if a word does not read back as written.
+ *  A power loss can be armed to hit after a number of word operations (each programmed word, each erased
+ *  sector): the operation it hits is left half done (a program clears some of the word's bits, an erase
+ *  leaves a mix of erased, old and partly cleared words) and the emulator longjmps to simFlashPowerLoss,
+ *  where the test boots the store again.
+ */
+#include <setjmp.h>
+#include "DSP28x_Project.h"
+#include "config_store.h"
+
+#ifndef FLASH_SIM_H
+#define FLASH_SIM_H
+
+extern Uint16 simFlashSectorG[CONFIG_SECTOR_WORDS];
+extern Uint16 simFlashSectorH[CONFIG_SECTOR_WORDS];
+extern jmp_buf simFlashPowerLoss;       // Set by the test before a power loss is armed
+
+// Operation counts since the start
+typedef struct
+{
+    Uint32 erases;                      // Sectors erased
+    Uint32 programs;                    // Flash_Program() calls
+    Uint32 words;                       // Words programmed
+    Uint32 powerLosses;
+} SimFlashStats;
+
+extern SimFlashStats simFlashStats;
+
+// Function prototypes
+void sim_flash_erase_all(void);                     // Both sectors erased, as a new device
+void sim_flash_power_loss_after(long operations);   // Arms a power loss after that many word operations, -1 disarms
+void sim_flash_seed(Uint32 seed);                   // Seeds the random state of the half done operations
+
+#endif
@@ -0,0 +1,407 @@
+/*
+ * DSP28x_Project.h (host build)
+ *
+ *  Stands in for the F2806x device headers when the firmware is built for the host (host/CMakeLists.txt).
+ *  Declares only the registers, bits and support functions the firmware uses, with the F2806x names;
+ *  registers written through .all keep the F2806x bit layout. The simulator (host/sim.c) defines them
+ *  and models what the firmware relies on, see sim.h.
+ */
+#ifndef DSP28X_PROJECT_H
+#define DSP28X_PROJECT_H
+
+#include <stdint.h>
+
+// F2806x types, char and int are 16 bits on the C28x, the host keeps the sized ones
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+typedef uint16_t Uint16;
+typedef uint32_t Uint32;
+typedef uint64_t Uint64;
+typedef float float32;
+typedef long double float64;
+
+// Compiler intrinsics and interrupt masking, INTM is simulated
+extern volatile Uint16 simInterruptsMasked;
+#define __interrupt
+#define EALLOW
+#define EDIS
+#define DINT (simInterruptsMasked = 1)
+#define EINT (simInterruptsMasked = 0)
+#define ERTM
+#define ESTOP0
+
+// CPU interrupt enable and flag registers
+extern volatile Uint16 IER;
+extern volatile Uint16 IFR;
+#define M_INT1 0x0001
+#define M_INT3 0x0004
+#define M_INT7 0x0040
+#define M_INT8 0x0080
+#define M_INT9 0x0100
+
+// ePWM
+#define TB_COUNT_UPDOWN 0x2
+#define TB_DISABLE 0x0
+#define TB_ENABLE 0x1
+#define TB_SHADOW 0x0
+#define TB_IMMEDIATE 0x1
+#define TB_SYNC_IN 0x0
+#define TB_DIV1 0x0
+#define ET_CTR_ZERO 0x1
+#define ET_1ST 0x1
+#define CC_SHADOW 0x0
+#define CC_CTR_ZERO 0x0
+#define AQ_CLEAR 0x1
+#define AQ_SET 0x2
+
+struct TBCTL_BITS
+{
+    Uint16 CTRMODE:2;
+    Uint16 PHSEN:1;
+    Uint16 PRDLD:1;
+    Uint16 SYNCOSEL:2;
+    Uint16 SWFSYNC:1;
+    Uint16 HSPCLKDIV:3;
+    Uint16 CLKDIV:3;
+    Uint16 PHSDIR:1;
+    Uint16 FREE_SOFT:2;
+};
+
+struct TBSTS_BITS
+{
+    Uint16 CTRDIR:1;
+    Uint16 SYNCI:1;
+    Uint16 CTRMAX:1;
+    Uint16 rsvd1:13;
+};
+
+struct HRPWM_WORDS
+{
+    Uint16 low;         // CMPAHR, TBPHSHR or TBPRDHR
+    Uint16 high;
+};
+
+struct CMPA_HRPWM_GROUP
+{
+    Uint16 CMPAHR;
+    Uint16 CMPA;
+};
+
+struct TBPHS_HRPWM_GROUP
+{
+    Uint16 TBPHSHR;
+    Uint16 TBPHS;
+};
+
+struct CMPCTL_BITS
+{
+    Uint16 LOADAMODE:2;
+    Uint16 LOADBMODE:2;
+    Uint16 SHDWAMODE:1;
+    Uint16 rsvd1:1;
+    Uint16 SHDWBMODE:1;
+    Uint16 rsvd2:1;
+    Uint16 SHDWAFULL:1;
+    Uint16 SHDWBFULL:1;
+    Uint16 rsvd3:6;
+};
+
+struct AQCTL_BITS
+{
+    Uint16 ZRO:2;
+    Uint16 PRD:2;
+    Uint16 CAU:2;
+    Uint16 CAD:2;
+    Uint16 CBU:2;
+    Uint16 CBD:2;
+    Uint16 rsvd:4;
+};
+
+struct ETSEL_BITS
+{
+    Uint16 INTSEL:3;
+    Uint16 INTEN:1;
+    Uint16 rsvd1:4;
+    Uint16 SOCASEL:3;
+    Uint16 SOCAEN:1;
+    Uint16 SOCBSEL:3;
+    Uint16 SOCBEN:1;
+};
+
+struct ETPS_BITS
+{
+    Uint16 INTPRD:2;
+    Uint16 INTCNT:2;
+    Uint16 rsvd1:4;
+    Uint16 SOCAPRD:2;
+    Uint16 SOCACNT:2;
+    Uint16 SOCBPRD:2;
+    Uint16 SOCBCNT:2;
+};
+
+struct ETFLG_BITS
+{
+    Uint16 INT:1;
+    Uint16 rsvd1:1;
+    Uint16 SOCA:1;
+    Uint16 SOCB:1;
+    Uint16 rsvd2:12;
+};
+
+struct EPWM_REGS
+{
+    union { Uint16 all; struct TBCTL_BITS bit; } TBCTL;
+    union { Uint16 all; struct TBSTS_BITS bit; } TBSTS;
+    union { Uint32 all; struct TBPHS_HRPWM_GROUP half; } TBPHS;
+    Uint16 TBCTR;
+    Uint16 TBPRD;
+    Uint16 TBPRDHR;
+    union { Uint16 all; struct CMPCTL_BITS bit; } CMPCTL;
+    union { Uint32 all; struct CMPA_HRPWM_GROUP half; } CMPA;
+    Uint16 CMPB;
+    union { Uint16 all; struct AQCTL_BITS bit; } AQCTLA;
+    union { Uint16 all; struct AQCTL_BITS bit; } AQCTLB;
+    union { Uint16 all; struct ETSEL_BITS bit; } ETSEL;
+    union { Uint16 all; struct ETPS_BITS bit; } ETPS;
+    union { Uint16 all; struct ETFLG_BITS bit; } ETFLG;
+    union { Uint16 all; struct ETFLG_BITS bit; } ETCLR;
+    union { Uint32 all; struct HRPWM_WORDS half; } TBPRDM;
+};
+
+extern volatile struct EPWM_REGS EPwm1Regs, EPwm2Regs, EPwm3Regs, EPwm4Regs;
+extern volatile struct EPWM_REGS EPwm5Regs, EPwm6Regs, EPwm7Regs, EPwm8Regs;
+
+// SCI
+struct SCICCR_BITS
+{
+    Uint16 SCICHAR:3;
+    Uint16 ADDRIDLE_MODE:1;
+    Uint16 LOOPBKENA:1;
+    Uint16 PARITYENA:1;
+    Uint16 PARITY:1;
+    Uint16 STOPBITS:1;
+    Uint16 rsvd1:8;
+};
+
+struct SCICTL2_BITS
+{
+    Uint16 TXINTENA:1;
+    Uint16 RXBKINTENA:1;
+    Uint16 rsvd1:4;
+    Uint16 TXEMPTY:1;
+    Uint16 TXRDY:1;
+    Uint16 rsvd2:8;
+};
+
+struct SCIFFTX_BITS
+{
+    Uint16 TXFFIL:5;
+    Uint16 TXFFIENA:1;
+    Uint16 TXFFINTCLR:1;
+    Uint16 TXFFINT:1;
+    Uint16 TXFFST:5;
+    Uint16 TXFIFOXRESET:1;
+    Uint16 SCIFFENA:1;
+    Uint16 SCIRST:1;
+};
+
+struct SCIFFRX_BITS
+{
+    Uint16 RXFFIL:5;
+    Uint16 RXFFIENA:1;
+    Uint16 RXFFINTCLR:1;
+    Uint16 RXFFINT:1;
+    Uint16 RXFFST:5;
+    Uint16 RXFIFORESET:1;
+    Uint16 RXFFOVRCLR:1;
+    Uint16 RXFFOVF:1;
+};
+
+struct SCI_REGS
+{
+    union { Uint16 all; struct SCICCR_BITS bit; } SCICCR;
+    union { Uint16 all; } SCICTL1;
+    Uint16 SCIHBAUD;
+    Uint16 SCILBAUD;
+    union { Uint16 all; struct SCICTL2_BITS bit; } SCICTL2;
+    union { Uint16 all; } SCIRXST;
+    union { Uint16 all; } SCIRXEMU;
+    union { Uint16 all; } SCIRXBUF;
+    Uint16 SCITXBUF;
+    union { Uint16 all; struct SCIFFTX_BITS bit; } SCIFFTX;
+    union { Uint16 all; struct SCIFFRX_BITS bit; } SCIFFRX;
+    union { Uint16 all; } SCIFFCT;
+    union { Uint16 all; } SCIPRI;
+};
+
+extern volatile struct SCI_REGS SciaRegs;
+
+// PIE
+#define PIEACK_GROUP1 0x0001
+#define PIEACK_GROUP3 0x0004
+#define PIEACK_GROUP7 0x0040
+#define PIEACK_GROUP9 0x0100
+
+struct PIEIER_BITS
+{
+    Uint16 INTx1:1;
+    Uint16 INTx2:1;
+    Uint16 INTx3:1;
+    Uint16 INTx4:1;
+    Uint16 INTx5:1;
+    Uint16 INTx6:1;
+    Uint16 INTx7:1;
+    Uint16 INTx8:1;
+    Uint16 rsvd:8;
+};
+
+union PIEIER_REG
+{
+    Uint16 all;
+    struct PIEIER_BITS bit;
+};
+
+struct PIE_CTRL_REGS
+{
+    union { Uint16 all; } PIECTRL;
+    union { Uint16 all; } PIEACK;
+    union PIEIER_REG PIEIER1, PIEIFR1;
+    union PIEIER_REG PIEIER3, PIEIFR3;
+    union PIEIER_REG PIEIER7, PIEIFR7;
+    union PIEIER_REG PIEIER9, PIEIFR9;
+};
+
+extern volatile struct PIE_CTRL_REGS PieCtrlRegs;
+
+typedef void (*PINT)(void);
+
+struct PIE_VECT_TABLE
+{
+    PINT XINT1;
+    PINT EPWM1_INT;
+    PINT DINTCH1;
+    PINT SCIRXINTA;
+    PINT SCITXINTA;
+};
+
+extern struct PIE_VECT_TABLE PieVectTable;
+
+// System control and GPIO
+struct PCLKCR0_BITS
+{
+    Uint16 HRPWMENCLK:1;
+    Uint16 rsvd1:1;
+    Uint16 TBCLKSYNC:1;
+    Uint16 rsvd2:13;
+};
+
+struct PCLKCR3_BITS
+{
+    Uint16 rsvd1:11;
+    Uint16 DMAENCLK:1;
+    Uint16 rsvd2:2;
+    Uint16 CLA1ENCLK:1;
+    Uint16 rsvd3:1;
+};
+
+struct SYS_CTRL_REGS
+{
+    union { Uint16 all; struct PCLKCR0_BITS bit; } PCLKCR0;
+    union { Uint16 all; struct PCLKCR3_BITS bit; } PCLKCR3;
+    union { Uint16 all; struct { Uint16 CONFIG:1; Uint16 rsvd:15; } bit; } EPWMCFG;
+};
+
+extern volatile struct SYS_CTRL_REGS SysCtrlRegs;
+
+struct GPIO_CTRL_REGS
+{
+    union { Uint32 all; struct { Uint32 rsvd1:24; Uint32 GPIO12:2; Uint32 rsvd2:6; } bit; } GPAMUX1;
+    union { Uint32 all; struct { Uint32 rsvd1:12; Uint32 GPIO12:1; Uint32 rsvd2:19; } bit; } GPADIR;
+    union { Uint32 all; struct { Uint32 rsvd1:12; Uint32 GPIO12:1; Uint32 rsvd2:19; } bit; } GPAPUD;
+    union { Uint32 all; struct { Uint32 QUALPRD0:8; Uint32 QUALPRD1:8; Uint32 rsvd:16; } bit; } GPACTRL;
+    union { Uint32 all; struct { Uint32 rsvd1:24; Uint32 GPIO12:2; Uint32 rsvd2:6; } bit; } GPAQSEL1;
+};
+
+extern volatile struct GPIO_CTRL_REGS GpioCtrlRegs;
+
+struct GPIO_INT_REGS
+{
+    union { Uint16 all; struct { Uint16 GPIOSEL:5; Uint16 rsvd:11; } bit; } GPIOXINT1SEL;
+};
+
+extern volatile struct GPIO_INT_REGS GpioIntRegs;
+
+struct XINTRUPT_REGS
+{
+    union { Uint16 all; struct { Uint16 ENABLE:1; Uint16 rsvd1:1; Uint16 POLARITY:2; Uint16 rsvd2:12; } bit; } XINT1CR;
+};
+
+extern volatile struct XINTRUPT_REGS XIntruptRegs;
+
+// DMA, configured through the F2806x_Dma.c functions, started and halted through hal_dma_start() and hal_dma_halt()
+#define DMA_EPWM1A 18
+#define PERINT_ENABLE 1
+#define ONESHOT_DISABLE 0
+#define CONT_ENABLE 1
+#define SYNC_DISABLE 0
+#define SYNC_SRC 0
+#define OVRFLOW_DISABLE 0
+#define SIXTEEN_BIT 0
+#define CHINT_END 1
+#define CHINT_DISABLE 0
+#define CHINT_ENABLE 1
+
+// F2806x support functions (F2806x_SysCtrl.c, F2806x_PieCtrl.c, F2806x_Dma.c, ...)
+void InitSysCtrl(void);
+void InitFlash(void);
+void InitPieCtrl(void);
+void InitPieVectTable(void);
+void InitSciaGpio(void);
+void InitEPwm1Gpio(void);
+void InitEPwm2Gpio(void);
+void InitEPwm3Gpio(void);
+void InitEPwm4Gpio(void);
+void InitEPwm5Gpio(void);
+void InitEPwm6Gpio(void);
+void InitEPwm7Gpio(void);
+void InitEPwm8Gpio(void);
+void DMAInitialize(void);
+void DMACH1AddrConfig(volatile Uint16 *DMA_Dest, volatile Uint16 *DMA_Source);
+void DMACH1BurstConfig(Uint16 bsize, int16 srcbstep, int16 desbstep);
+void DMACH1TransferConfig(Uint16 tsize, int16 srctstep, int16 deststep);
+void DMACH1WrapConfig(Uint16 srcwsize, int16 srcwstep, Uint16 deswsize, int16 deswstep);
+void DMACH1ModeConfig(Uint16 persel, Uint16 perinte, Uint16 oneshot, Uint16 cont, Uint16 synce, Uint16 syncsel,
+                      Uint16 ovrinte, Uint16 datasize, Uint16 chintmode, Uint16 chinte);
+void DMACH2AddrConfig(volatile Uint16 *DMA_Dest, volatile Uint16 *DMA_Source);
+void DMACH2BurstConfig(Uint16 bsize, int16 srcbstep, int16 desbstep);
+void DMACH2TransferConfig(Uint16 tsize, int16 srctstep, int16 deststep);
+void DMACH2WrapConfig(Uint16 srcwsize, int16 srcwstep, Uint16 deswsize, int16 deswstep);
+void DMACH2ModeConfig(Uint16 persel, Uint16 perinte, Uint16 oneshot, Uint16 cont, Uint16 synce, Uint16 syncsel,
+                      Uint16 ovrinte, Uint16 datasize, Uint16 chintmode, Uint16 chinte);
+void DMACH3AddrConfig(volatile Uint16 *DMA_Dest, volatile Uint16 *DMA_Source);
+void DMACH3BurstConfig(Uint16 bsize, int16 srcbstep, int16 desbstep);
+void DMACH3TransferConfig(Uint16 tsize, int16 srctstep, int16 deststep);
+void DMACH3WrapConfig(Uint16 srcwsize, int16 srcwstep, Uint16 deswsize, int16 deswstep);
+void DMACH3ModeConfig(Uint16 persel, Uint16 perinte, Uint16 oneshot, Uint16 cont, Uint16 synce, Uint16 syncsel,
+                      Uint16 ovrinte, Uint16 datasize, Uint16 chintmode, Uint16 chinte);
+void DMACH4AddrConfig(volatile Uint16 *DMA_Dest, volatile Uint16 *DMA_Source);
+void DMACH4BurstConfig(Uint16 bsize, int16 srcbstep, int16 desbstep);
+void DMACH4TransferConfig(Uint16 tsize, int16 srctstep, int16 deststep);
+void DMACH4WrapConfig(Uint16 srcwsize, int16 srcwstep, Uint16 deswsize, int16 deswstep);
+void DMACH4ModeConfig(Uint16 persel, Uint16 perinte, Uint16 oneshot, Uint16 cont, Uint16 synce, Uint16 syncsel,
+                      Uint16 ovrinte, Uint16 datasize, Uint16 chintmode, Uint16 chinte);
+void DMACH5AddrConfig(volatile Uint16 *DMA_Dest, volatile Uint16 *DMA_Source);
+void DMACH5BurstConfig(Uint16 bsize, int16 srcbstep, int16 desbstep);
+void DMACH5TransferConfig(Uint16 tsize, int16 srctstep, int16 deststep);
+void DMACH5WrapConfig(Uint16 srcwsize, int16 srcwstep, Uint16 deswsize, int16 deswstep);
+void DMACH5ModeConfig(Uint16 persel, Uint16 perinte, Uint16 oneshot, Uint16 cont, Uint16 synce, Uint16 syncsel,
+                      Uint16 ovrinte, Uint16 datasize, Uint16 chintmode, Uint16 chinte);
+void DMACH6AddrConfig(volatile Uint16 *DMA_Dest, volatile Uint16 *DMA_Source);
+void DMACH6BurstConfig(Uint16 bsize, int16 srcbstep, int16 desbstep);
+void DMACH6TransferConfig(Uint16 tsize, int16 srctstep, int16 deststep);
+void DMACH6WrapConfig(Uint16 srcwsize, int16 srcwstep, Uint16 deswsize, int16 deswstep);
+void DMACH6ModeConfig(Uint16 persel, Uint16 perinte, Uint16 oneshot, Uint16 cont, Uint16 synce, Uint16 syncsel,
+                      Uint16 ovrinte, Uint16 datasize, Uint16 chintmode, Uint16 chinte);
+
+#endif
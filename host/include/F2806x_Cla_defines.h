@@ -0,0 +1,6 @@
+/*
+ * F2806x_Cla_defines.h (host build)
+ *
+ *  cla.c includes the CLA defines unconditionally, the host build never defines CLA_OFFLOAD,
+ *  so nothing from them is needed.
+ */
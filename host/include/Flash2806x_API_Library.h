@@ -0,0 +1,38 @@
+/*
+ * Flash2806x_API_Library.h (host build)
+ *
+ *  Stands in for the F2806x Flash API header when config_store.c is built for the host with CONFIG_STORE
+ *  (host/CMakeLists.txt). Declares what config_store.c uses with the Flash API names; the emulator in
+ *  host/flash_sim.c implements it on the sector arrays config_store.h points at, see flash_sim.h.
+ */
+#ifndef FLASH2806X_API_LIBRARY_H
+#define FLASH2806X_API_LIBRARY_H
+
+#include "DSP28x_Project.h"
+
+// Sector masks of Flash_Erase()
+#define SECTORG 0x0040
+#define SECTORH 0x0080
+
+// Return codes
+#define STATUS_SUCCESS 0
+#define STATUS_FAIL_PROGRAM 14         // A word did not read back as programmed (a 0 bit cannot turn into 1)
+
+#define SCALE_FACTOR 1
+
+// Where a call failed
+typedef struct
+{
+    Uint32 FirstFailAddr;
+    Uint16 ExpectedData;
+    Uint16 ActualData;
+} FLASH_ST;
+
+extern Uint32 Flash_CPUScaleFactor;
+extern void (*Flash_CallbackPtr)(void);
+
+// Function prototypes
+Uint16 Flash_Erase(Uint16 SectorMask, FLASH_ST *FEraseStat);
+Uint16 Flash_Program(Uint16 *FlashAddr, Uint16 *BufAddr, Uint32 Length, FLASH_ST *FProgStatus);
+
+#endif
@@ -0,0 +1,964 @@
+#include "DSP28x_Project.h"     // Host register shim
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+
+#define SIM_NEVER UINT64_MAX
+#define SIM_POLLS_PER_EVENT 4           // Main loop passes between two events, drains what arrived
+#define SIM_ISR_LIMIT 10000             // Interrupts taken in a row before the simulator gives up (flag never cleared)
+
+// Simulated registers (host DSP28x_Project.h)
+volatile Uint16 simInterruptsMasked = 1;    // INTM, set at reset
+volatile Uint16 IER;
+volatile Uint16 IFR;
+volatile struct EPWM_REGS EPwm1Regs, EPwm2Regs, EPwm3Regs, EPwm4Regs;
+volatile struct EPWM_REGS EPwm5Regs, EPwm6Regs, EPwm7Regs, EPwm8Regs;
+volatile struct SCI_REGS SciaRegs;
+volatile struct PIE_CTRL_REGS PieCtrlRegs;
+struct PIE_VECT_TABLE PieVectTable;
+volatile struct SYS_CTRL_REGS SysCtrlRegs;
+volatile struct GPIO_CTRL_REGS GpioCtrlRegs;
+volatile struct GPIO_INT_REGS GpioIntRegs;
+volatile struct XINTRUPT_REGS XIntruptRegs;
+
+// SYSCLKOUT cycles since boot
+static Uint64 now;
+
+// ePWM time base, every channel counts in lockstep with ePWM1
+static Uint16 epwmStarted;
+static Uint64 periodStart;              // Time of the last counter zero
+static Uint16 activePeriod;             // Active TBPRD
+static Uint16 activePrescale;
+static Uint16 activeCompare[HAL_EPWM_CHANNELS];
+static Uint32 periodCount;
+static Uint16 eventCount;               // Counter zeros since the last ePWM1 interrupt (ETPS INTCNT)
+static Uint32 isrCalls;
+static Uint16 inIsr;                    // Set while an ISR runs
+
+// DMA channels 1-6
+#define SIM_DMA_CHANNELS 6
+
+typedef struct
+{
+    volatile Uint16 *dest;
+    volatile Uint16 *source;
+    Uint16 length;                      // Words per transfer, the source restarts after them
+    Uint16 index;                       // Words moved in the current transfer
+    Uint16 running;
+    Uint16 interrupt;                   // Flags the PIE at the end of each transfer (channel 1 only, PIE 7.1)
+} SimDmaChannel;
+
+static SimDmaChannel dmaChannels[SIM_DMA_CHANNELS];
+
+// SCI A: bytes waiting to be sent to the RX line, the two FIFOs and the transmit shift register
+typedef struct
+{
+    Uint64 notBefore;                   // The byte's start bit is not sent before this time
+    Uint16 value;
+} SimRxByte;
+
+static SimRxByte *rxQueue;
+static Uint32 rxQueueHead, rxQueueCount, rxQueueCapacity;
+static Uint64 rxLineFree;               // End of the last received character
+static Uint16 rxFifo[SIM_SCI_FIFO_DEPTH];
+static Uint16 rxFifoCount;
+static Uint32 rxOverruns;
+static Uint16 txFifo[SIM_SCI_FIFO_DEPTH];
+static Uint16 txFifoCount;
+static Uint16 txShifting;
+static Uint16 txShiftValue;
+static Uint64 txDoneTime;
+static char *txOutput;
+static Uint32 txOutputCount, txOutputCapacity;
+
+// XINT1 edge waiting for its interrupt
+static Uint16 xintPending;
+
+// Logs
+static Uint16 logEnabled = 1;
+static SimCmpaWrite *cmpaWrites;
+static Uint32 cmpaWriteCount, cmpaWriteCapacity;
+static SimPeriod *periods;
+static Uint32 periodLogCount, periodLogCapacity;
+static void (*periodHook)(const SimPeriod *period);
+
+// Makes room for one more element of size bytes
+static void *sim_grow(void *buffer, Uint32 count, Uint32 *capacity, size_t size)
+{
+    if (count < *capacity)
+    {
+        return buffer;
+    }
+
+    *capacity = *capacity ? 2 * *capacity : 1024;
+    buffer = realloc(buffer, *capacity * size);
+    if (!buffer)
+    {
+        fprintf(stderr, "sim: out of memory\n");
+        abort();
+    }
+    return buffer;
+}
+
+static void sim_fail(const char *message)
+{
+    fprintf(stderr, "sim: %s at cycle %llu\n", message, (unsigned long long) now);
+    abort();
+}
+
+// TBCLK prescaler of a TBCTL, HSPCLKDIV code n divides by 2n (0 by 1), CLKDIV code n by 2^n
+static Uint16 timebase_prescale(Uint16 hspClkDiv, Uint16 clkDiv)
+{
+    return (hspClkDiv ? 2 * hspClkDiv : 1) << clkDiv;
+}
+
+static void log_cmpa_write(Uint16 channel, Uint16 value, Uint16 source)
+{
+    if (!logEnabled)
+    {
+        return;
+    }
+
+    cmpaWrites = sim_grow(cmpaWrites, cmpaWriteCount, &cmpaWriteCapacity, sizeof(SimCmpaWrite));
+    cmpaWrites[cmpaWriteCount].time = now;
+    cmpaWrites[cmpaWriteCount].period = periodCount;
+    cmpaWrites[cmpaWriteCount].channel = channel;
+    cmpaWrites[cmpaWriteCount].value = value;
+    cmpaWrites[cmpaWriteCount].source = source;
+    cmpaWriteCount++;
+}
+
+static void log_period(Uint16 isr)
+{
+    SimPeriod period;
+    Uint16 ch;
+
+    period.time = periodStart;
+    period.period = periodCount;
+    period.timerPeriod = activePeriod;
+    period.clockPrescale = activePrescale;
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        period.compare[ch] = activeCompare[ch];
+    }
+    period.isr = isr;
+
+    if (periodHook)
+    {
+        periodHook(&period);
+    }
+    if (logEnabled)
+    {
+        periods = sim_grow(periods, periodLogCount, &periodLogCapacity, sizeof(SimPeriod));
+        periods[periodLogCount++] = period;
+    }
+}
+
+// Time one character takes on the line, 10 bits at LSPCLK / ((BRR + 1) * 8)
+static Uint64 sci_char_time(void)
+{
+    Uint32 brr = ((Uint32) SciaRegs.SCIHBAUD << 8) | SciaRegs.SCILBAUD;
+    return 10ULL * 8 * (brr + 1) * SIM_LSPCLK_DIVIDER;
+}
+
+static void tx_start(void)
+{
+    Uint16 i;
+
+    if (txShifting || txFifoCount == 0)
+    {
+        return;
+    }
+
+    txShiftValue = txFifo[0];
+    for (i = 1; i < txFifoCount; i++)
+    {
+        txFifo[i - 1] = txFifo[i];
+    }
+    txFifoCount--;
+    txShifting = 1;
+    txDoneTime = now + sci_char_time();
+}
+
+static void call_isr(PINT isr)
+{
+    simInterruptsMasked = 1;    // The CPU sets INTM on entry, the firmware's ISRs do not nest
+    inIsr = 1;
+    isr();
+    inIsr = 0;
+    simInterruptsMasked = 0;
+}
+
+/*
+ * Takes every interrupt that is flagged and enabled, highest PIE group first as the CPU would.
+ * Returns the number of ISRs that ran.
+ */
+static Uint32 service_interrupts(void)
+{
+    Uint32 taken = 0;
+
+    while (!simInterruptsMasked)
+    {
+        if (EPwm1Regs.ETCLR.bit.INT)
+        {
+            EPwm1Regs.ETFLG.bit.INT = 0;
+            EPwm1Regs.ETCLR.bit.INT = 0;
+        }
+
+        if (xintPending && XIntruptRegs.XINT1CR.bit.ENABLE && (IER & M_INT1) && PieCtrlRegs.PIEIER1.bit.INTx4)
+        {
+            xintPending = 0;
+            call_isr(PieVectTable.XINT1);
+        }
+        else if (EPwm1Regs.ETFLG.bit.INT && (IER & M_INT3) && PieCtrlRegs.PIEIER3.bit.INTx1)
+        {
+            isrCalls++;
+            call_isr(PieVectTable.EPWM1_INT);
+        }
+        else if (PieCtrlRegs.PIEIFR7.bit.INTx1 && (IER & M_INT7) && PieCtrlRegs.PIEIER7.bit.INTx1)
+        {
+            PieCtrlRegs.PIEIFR7.bit.INTx1 = 0;
+            call_isr(PieVectTable.DINTCH1);
+        }
+        else if (SciaRegs.SCIFFRX.bit.RXFFIENA && rxFifoCount != 0 && rxFifoCount >= SciaRegs.SCIFFRX.bit.RXFFIL
+                 && (IER & M_INT9) && PieCtrlRegs.PIEIER9.bit.INTx1)
+        {
+            call_isr(PieVectTable.SCIRXINTA);
+        }
+        else if (SciaRegs.SCIFFTX.bit.TXFFIENA && txFifoCount <= SciaRegs.SCIFFTX.bit.TXFFIL
+                 && (IER & M_INT9) && PieCtrlRegs.PIEIER9.bit.INTx2)
+        {
+            call_isr(PieVectTable.SCITXINTA);
+        }
+        else
+        {
+            break;
+        }
+
+        if (++taken > SIM_ISR_LIMIT)
+        {
+            sim_fail("interrupt flag never cleared");
+        }
+    }
+    return taken;
+}
+
+// Starts the time base once Init_Epwmm() has configured ePWM1, the counter starts at 0 counting up
+static void epwm_start_if_configured(void)
+{
+    Uint16 ch;
+
+    if (epwmStarted || EPwm1Regs.TBPRD == 0 || EPwm1Regs.TBCTL.bit.CTRMODE != TB_COUNT_UPDOWN)
+    {
+        return;
+    }
+
+    epwmStarted = 1;
+    periodStart = now;
+    periodCount = 0;
+    activePeriod = EPwm1Regs.TBPRD;
+    activePrescale = timebase_prescale(EPwm1Regs.TBCTL.bit.HSPCLKDIV, EPwm1Regs.TBCTL.bit.CLKDIV);
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        activeCompare[ch] = halEpwmChannels[ch].regs->CMPA.half.CMPA;
+    }
+    log_period(0);
+}
+
+// One word per running DMA channel into its destination (SOCA), the DMA reaches the ePWM registers only
+// once hal_system_init() has moved them to peripheral frame 3 (EPWMCFG)
+static void dma_trigger(void)
+{
+    Uint16 i, ch;
+
+    for (i = 0; i < SIM_DMA_CHANNELS; i++)
+    {
+        SimDmaChannel *channel = &dmaChannels[i];
+
+        if (!channel->running || channel->length == 0)
+        {
+            continue;
+        }
+
+        *channel->dest = channel->source[channel->index];
+        for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+        {
+            if (channel->dest == &halEpwmChannels[ch].regs->CMPA.half.CMPA)
+            {
+                if (!SysCtrlRegs.EPWMCFG.bit.CONFIG)
+                {
+                    sim_fail("DMA write to the ePWM registers on peripheral frame 1");
+                }
+                log_cmpa_write(ch, *channel->dest, SIM_WRITE_DMA);
+            }
+        }
+        channel->index = (channel->index + 1) % channel->length;
+        if (channel->index == 0 && channel->interrupt)
+        {
+            PieCtrlRegs.PIEIFR7.bit.INTx1 = 1;
+        }
+    }
+}
+
+/*
+ * Counter zero: the shadowed period and compares load, SOCA moves the DMA words (they load at the next
+ * zero) and the interrupt is flagged every INTPRD events.
+ */
+static void counter_zero(void)
+{
+    Uint16 ch;
+    Uint32 callsBefore = isrCalls;
+
+    now = periodStart + 2ULL * activePeriod * activePrescale;
+    periodStart = now;
+    periodCount++;
+
+    if (EPwm1Regs.TBCTL.bit.PRDLD == TB_SHADOW)
+    {
+        activePeriod = EPwm1Regs.TBPRD;
+    }
+    activePrescale = timebase_prescale(EPwm1Regs.TBCTL.bit.HSPCLKDIV, EPwm1Regs.TBCTL.bit.CLKDIV);
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        volatile struct EPWM_REGS *regs = halEpwmChannels[ch].regs;
+        activeCompare[ch] = regs->CMPA.half.CMPA;
+        regs->TBCTR = 0;
+        regs->TBSTS.bit.CTRDIR = 1;
+    }
+
+    if (EPwm1Regs.ETSEL.bit.SOCAEN)
+    {
+        dma_trigger();
+    }
+
+    if (EPwm1Regs.ETCLR.bit.INT)
+    {
+        EPwm1Regs.ETFLG.bit.INT = 0;
+        EPwm1Regs.ETCLR.bit.INT = 0;
+    }
+    if (EPwm1Regs.ETSEL.bit.INTEN && EPwm1Regs.ETPS.bit.INTPRD && ++eventCount >= EPwm1Regs.ETPS.bit.INTPRD)
+    {
+        eventCount = 0;
+        EPwm1Regs.ETFLG.bit.INT = 1;
+    }
+
+    // The ISR can still switch the prescaler of this period (hal_epwm_write_prescaler())
+    service_interrupts();
+    log_period(isrCalls != callsBefore);
+}
+
+static void rx_arrival(void)
+{
+    SimRxByte *byte = &rxQueue[rxQueueHead];
+
+    if (rxFifoCount < SIM_SCI_FIFO_DEPTH)
+    {
+        rxFifo[rxFifoCount++] = byte->value;
+    }
+    else
+    {
+        SciaRegs.SCIFFRX.bit.RXFFOVF = 1;
+        rxOverruns++;
+    }
+    rxLineFree = now;
+    rxQueueHead++;
+    rxQueueCount--;
+}
+
+static void tx_done(void)
+{
+    txOutput = sim_grow(txOutput, txOutputCount + 1, &txOutputCapacity, 1);
+    txOutput[txOutputCount++] = (char) txShiftValue;
+    txOutput[txOutputCount] = '\0';
+    txShifting = 0;
+    tx_start();
+}
+
+/*
+ * Moves time on to the next event if it is due by limit and handles it with its interrupts.
+ * Returns 0 if no event is due by then.
+ */
+static int next_event(Uint64 limit)
+{
+    Uint64 zeroTime = SIM_NEVER, rxTime = SIM_NEVER, txTime = SIM_NEVER;
+
+    epwm_start_if_configured();
+    if (epwmStarted)
+    {
+        zeroTime = periodStart + 2ULL * activePeriod * activePrescale;
+    }
+    if (rxQueueCount)
+    {
+        Uint64 start = rxQueue[rxQueueHead].notBefore > rxLineFree ? rxQueue[rxQueueHead].notBefore : rxLineFree;
+        rxTime = start + sci_char_time();
+    }
+    if (txShifting)
+    {
+        txTime = txDoneTime;
+    }
+
+    if (zeroTime <= rxTime && zeroTime <= txTime && zeroTime <= limit)
+    {
+        counter_zero();
+    }
+    else if (txTime <= rxTime && txTime <= limit)
+    {
+        now = txTime;
+        tx_done();
+    }
+    else if (rxTime <= limit)
+    {
+        now = rxTime;
+        rx_arrival();
+    }
+    else
+    {
+        return 0;
+    }
+
+    service_interrupts();
+    return 1;
+}
+
+// A few main loop passes, each followed by the interrupts it enabled or flagged
+static void run_main_loop(void)
+{
+    Uint16 i;
+
+    service_interrupts();
+    for (i = 0; i < SIM_POLLS_PER_EVENT; i++)
+    {
+        firmware_poll();
+        service_interrupts();
+    }
+}
+
+void sim_boot(void)
+{
+    memset((void *) &EPwm1Regs, 0, sizeof(EPwm1Regs));
+    memset((void *) &EPwm2Regs, 0, sizeof(EPwm2Regs));
+    memset((void *) &EPwm3Regs, 0, sizeof(EPwm3Regs));
+    memset((void *) &SciaRegs, 0, sizeof(SciaRegs));
+    memset((void *) &PieCtrlRegs, 0, sizeof(PieCtrlRegs));
+    memset((void *) &SysCtrlRegs, 0, sizeof(SysCtrlRegs));
+    memset(dmaChannels, 0, sizeof(dmaChannels));
+    SciaRegs.SCICTL2.bit.TXEMPTY = 1;
+    simInterruptsMasked = 1;
+    IER = 0;
+    IFR = 0;
+    now = 0;
+    epwmStarted = 0;
+
+    firmware_init();
+    service_interrupts();
+}
+
+void sim_run(Uint64 cycles)
+{
+    Uint64 end = now + cycles;
+
+    do
+    {
+        run_main_loop();
+    } while (next_event(end));
+    now = end;
+}
+
+void sim_run_seconds(double seconds)
+{
+    sim_run((Uint64) (seconds * SIM_SYSCLK_HZ + 0.5));
+}
+
+void sim_run_periods(Uint32 count)
+{
+    Uint32 target;
+
+    run_main_loop();
+    epwm_start_if_configured();
+    if (!epwmStarted)
+    {
+        sim_fail("sim_run_periods() before the outputs started");
+    }
+
+    target = periodCount + count;
+    while (periodCount < target)
+    {
+        next_event(SIM_NEVER);
+        run_main_loop();
+    }
+}
+
+Uint64 sim_time(void)
+{
+    return now;
+}
+
+Uint32 sim_periods(void)
+{
+    return periodCount;
+}
+
+Uint32 sim_isr_calls(void)
+{
+    return isrCalls;
+}
+
+// Queues one byte for the RX line, sent from time notBefore on
+static void rx_queue_byte(Uint64 notBefore, Uint16 value)
+{
+    // Reuse the space of bytes already received
+    if (rxQueueHead && rxQueueCount == 0)
+    {
+        rxQueueHead = 0;
+    }
+    rxQueue = sim_grow(rxQueue, rxQueueHead + rxQueueCount, &rxQueueCapacity, sizeof(SimRxByte));
+    rxQueue[rxQueueHead + rxQueueCount].notBefore = notBefore;
+    rxQueue[rxQueueHead + rxQueueCount].value = value & 0xFF;
+    rxQueueCount++;
+}
+
+void sim_sci_send(const char *bytes, Uint32 count)
+{
+    Uint32 i;
+
+    for (i = 0; i < count; i++)
+    {
+        rx_queue_byte(now, (unsigned char) bytes[i]);
+    }
+}
+
+void sim_sci_send_string(const char *text)
+{
+    sim_sci_send(text, strlen(text) + 1);
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/*
+ * Queues an SCI input script. Each line is "<ms> <text>": the text is sent from that many milliseconds
+ * after boot on (or right after the line before it). The text runs to the end of the line and takes the
+ * escapes \0 \r \n \t \\ and \xHH, a line ending in '\0' is what HTerm sends for a terminated command.
+ * Empty lines and lines starting with '#' are skipped.
+ * Returns 1 if the whole script was queued, 0 (with nothing queued from the bad line on) on a syntax error.
+ */
+int sim_sci_script(const char *script)
+{
+    const char *line = script;
+    Uint32 lineNumber = 0;
+
+    while (*line)
+    {
+        const char *end = strchr(line, '\n');
+        const char *p = line;
+        double ms;
+        char *afterNumber;
+        Uint64 notBefore;
+
+        if (!end)
+        {
+            end = line + strlen(line);
+        }
+        lineNumber++;
+
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        {
+            p++;
+        }
+        if (p == end || *p == '#')
+        {
+            line = *end ? end + 1 : end;
+            continue;
+        }
+
+        ms = strtod(p, &afterNumber);
+        if (afterNumber == p || afterNumber >= end || *afterNumber != ' ' || ms < 0)
+        {
+            fprintf(stderr, "sim: script line %lu: expected \"<ms> <text>\"\n", (unsigned long) lineNumber);
+            return 0;
+        }
+        notBefore = (Uint64) (ms * (SIM_SYSCLK_HZ / 1000) + 0.5);
+
+        for (p = afterNumber + 1; p < end && !(*p == '\r' && p + 1 == end); p++)
+        {
+            Uint16 value = (unsigned char) *p;
+
+            if (*p == '\\' && p + 1 < end)
+            {
+                p++;
+                switch (*p)
+                {
+                case '0': value = 0; break;
+                case 'r': value = '\r'; break;
+                case 'n': value = '\n'; break;
+                case 't': value = '\t'; break;
+                case '\\': value = '\\'; break;
+                case 'x':
+                    if (p + 2 < end && hex_digit(p[1]) >= 0 && hex_digit(p[2]) >= 0)
+                    {
+                        value = hex_digit(p[1]) * 16 + hex_digit(p[2]);
+                        p += 2;
+                        break;
+                    }
+                    // Fall through
+                default:
+                    fprintf(stderr, "sim: script line %lu: unknown escape\n", (unsigned long) lineNumber);
+                    return 0;
+                }
+            }
+            rx_queue_byte(notBefore, value);
+        }
+        line = *end ? end + 1 : end;
+    }
+    return 1;
+}
+
+const char *sim_sci_output(Uint32 *count)
+{
+    if (count)
+    {
+        *count = txOutputCount;
+    }
+    return txOutput ? txOutput : "";
+}
+
+void sim_sci_output_clear(void)
+{
+    txOutputCount = 0;
+    if (txOutput)
+    {
+        txOutput[0] = '\0';
+    }
+}
+
+Uint32 sim_sci_rx_overruns(void)
+{
+    return rxOverruns;
+}
+
+void sim_trigger_edge(void)
+{
+    xintPending = 1;
+    service_interrupts();
+}
+
+void sim_log_enable(Uint16 enable)
+{
+    logEnabled = enable;
+}
+
+const SimCmpaWrite *sim_cmpa_writes(Uint32 *count)
+{
+    *count = cmpaWriteCount;
+    return cmpaWrites;
+}
+
+const SimPeriod *sim_cmpa_periods(Uint32 *count)
+{
+    *count = periodLogCount;
+    return periods;
+}
+
+void sim_log_clear(void)
+{
+    cmpaWriteCount = 0;
+    periodLogCount = 0;
+}
+
+void sim_set_period_hook(void (*hook)(const SimPeriod *period))
+{
+    periodHook = hook;
+}
+
+// HAL accessors (hal.h), same register effects as the target versions
+
+void hal_system_init(void)
+{
+    Uint16 i;
+
+    InitSysCtrl();
+    InitFlash();
+#ifndef CLA_OFFLOAD
+    EALLOW;
+    SysCtrlRegs.EPWMCFG.bit.CONFIG = 1;
+    EDIS;
+#endif
+    InitSciaGpio();
+    for (i = 0; i < HAL_EPWM_CHANNELS; i++)
+    {
+        halEpwmChannels[i].initGpio();
+    }
+}
+
+void hal_epwm_write_compare(Uint16 channel, Uint16 value)
+{
+    halEpwmChannels[channel].regs->CMPA.half.CMPA = value;
+    log_cmpa_write(channel, value, SIM_WRITE_CPU);
+}
+
+void hal_epwm_write_period(Uint16 channel, Uint16 value)
+{
+    halEpwmChannels[channel].regs->TBPRD = value;
+}
+
+// Takes effect at once: the period running since the last counter zero counts with the new prescaler
+void hal_epwm_write_prescaler(Uint16 channel, Uint16 hspClkDiv, Uint16 clkDiv)
+{
+    volatile struct EPWM_REGS *regs = halEpwmChannels[channel].regs;
+
+    regs->TBCTL.bit.HSPCLKDIV = hspClkDiv;
+    regs->TBCTL.bit.CLKDIV = clkDiv;
+    if (channel == 0 && epwmStarted)
+    {
+        activePrescale = timebase_prescale(hspClkDiv, clkDiv);
+    }
+}
+
+void hal_epwm_write_interrupt_divisor(Uint16 divisor)
+{
+    EPwm1Regs.ETPS.bit.INTPRD = divisor;
+}
+
+void hal_epwm_write_compare_hr(Uint16 channel, Uint32 value)
+{
+    halEpwmChannels[channel].regs->CMPA.all = value;
+    log_cmpa_write(channel, value >> 16, SIM_WRITE_CPU);
+}
+
+void hal_epwm_write_period_hr(Uint16 channel, Uint32 value)
+{
+    halEpwmChannels[channel].regs->TBPRDM.all = value;
+    halEpwmChannels[channel].regs->TBPRD = value >> 16;
+}
+
+void hal_epwm_ack_interrupt(void)
+{
+    EPwm1Regs.ETFLG.bit.INT = 0;
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP3;
+}
+
+Uint16 hal_scia_rx_level(void)
+{
+    return rxFifoCount;
+}
+
+Uint16 hal_scia_read(void)
+{
+    Uint16 value, i;
+
+    if (rxFifoCount == 0)
+    {
+        return 0;
+    }
+
+    value = rxFifo[0];
+    for (i = 1; i < rxFifoCount; i++)
+    {
+        rxFifo[i - 1] = rxFifo[i];
+    }
+    rxFifoCount--;
+    return value;
+}
+
+Uint16 hal_scia_rx_overflowed(void)
+{
+    if (SciaRegs.SCIFFRX.bit.RXFFOVF)
+    {
+        SciaRegs.SCIFFRX.bit.RXFFOVF = 0;
+        return 1;
+    }
+    return 0;
+}
+
+Uint16 hal_scia_tx_level(void)
+{
+    return txFifoCount;
+}
+
+void hal_scia_write(Uint16 value)
+{
+    if (txFifoCount < SIM_SCI_FIFO_DEPTH)
+    {
+        txFifo[txFifoCount++] = value & 0xFF;
+    }
+    tx_start();
+}
+
+Uint16 hal_scia_tx_idle(void)
+{
+    return txFifoCount == 0 && !txShifting;
+}
+
+void hal_scia_set_baud_register(Uint16 brr)
+{
+    SciaRegs.SCIHBAUD = brr >> 8;
+    SciaRegs.SCILBAUD = brr & 0xFF;
+}
+
+void hal_scia_tx_interrupt_enable(Uint16 enable)
+{
+    SciaRegs.SCIFFTX.bit.TXFFIENA = enable;
+}
+
+void hal_scia_ack_rx_interrupt(void)
+{
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP9;
+}
+
+void hal_scia_ack_tx_interrupt(void)
+{
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP9;
+}
+
+// The next SOCA moves the first word of the new source, the destination stays as configured
+void hal_dma_start(Uint16 channel, const Uint16 *source, Uint16 size)
+{
+    dmaChannels[channel].source = (volatile Uint16 *) source;
+    dmaChannels[channel].length = size;
+    dmaChannels[channel].index = 0;
+    dmaChannels[channel].running = 1;
+}
+
+void hal_dma_halt(Uint16 channel)
+{
+    dmaChannels[channel].running = 0;
+}
+
+Uint16 hal_dma_transfer_position(Uint16 channel)
+{
+    return dmaChannels[channel].index;
+}
+
+void hal_dma_ack_interrupt(void)
+{
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP7;
+}
+
+// CPU timer 0 of the target, the simulated time wraps the same way
+Uint32 hal_cycle_count(void)
+{
+    return (Uint32) now;
+}
+
+// The benchmark times the kernels as the host runs them, not in simulated time
+Uint32 hal_benchmark_ticks(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (Uint32) (time.tv_sec * 1000000000ULL + time.tv_nsec);
+}
+
+// A loop waiting for an interrupt: take the interrupts already flagged, or move on to the next event
+void hal_busy_wait(void)
+{
+    if (service_interrupts() == 0 && !next_event(SIM_NEVER))
+    {
+        sim_fail("busy wait with no event left");
+    }
+}
+
+// F2806x support functions
+
+static void sim_unexpected_interrupt(void)
+{
+    sim_fail("unexpected interrupt");
+}
+
+void InitSysCtrl(void)
+{
+}
+
+void InitFlash(void)
+{
+}
+
+void InitPieCtrl(void)
+{
+    DINT;
+    PieCtrlRegs.PIEIER1.all = 0;
+    PieCtrlRegs.PIEIER3.all = 0;
+    PieCtrlRegs.PIEIER7.all = 0;
+    PieCtrlRegs.PIEIER9.all = 0;
+    PieCtrlRegs.PIEIFR1.all = 0;
+    PieCtrlRegs.PIEIFR3.all = 0;
+    PieCtrlRegs.PIEIFR7.all = 0;
+    PieCtrlRegs.PIEIFR9.all = 0;
+}
+
+void InitPieVectTable(void)
+{
+    PieVectTable.XINT1 = sim_unexpected_interrupt;
+    PieVectTable.EPWM1_INT = sim_unexpected_interrupt;
+    PieVectTable.DINTCH1 = sim_unexpected_interrupt;
+    PieVectTable.SCIRXINTA = sim_unexpected_interrupt;
+    PieVectTable.SCITXINTA = sim_unexpected_interrupt;
+}
+
+void InitSciaGpio(void)
+{
+}
+
+#define SIM_EPWM_GPIO(n) void InitEPwm##n##Gpio(void) { }
+SIM_EPWM_GPIO(1)
+SIM_EPWM_GPIO(2)
+SIM_EPWM_GPIO(3)
+SIM_EPWM_GPIO(4)
+SIM_EPWM_GPIO(5)
+SIM_EPWM_GPIO(6)
+SIM_EPWM_GPIO(7)
+SIM_EPWM_GPIO(8)
+
+// The DMA support functions run from flash and reset or reconfigure whole channels, not from an ISR
+static void dma_config_check(void)
+{
+    if (inIsr)
+    {
+        sim_fail("DMA configured from an ISR");
+    }
+}
+
+void DMAInitialize(void)
+{
+    dma_config_check();
+    memset(dmaChannels, 0, sizeof(dmaChannels));
+}
+
+// The simulated channels only need the addresses and the transfer size, one word per SOCA
+#define SIM_DMA_CHANNEL(n) \
+void DMACH##n##AddrConfig(volatile Uint16 *DMA_Dest, volatile Uint16 *DMA_Source) \
+{ \
+    dma_config_check(); \
+    dmaChannels[n - 1].dest = DMA_Dest; \
+    dmaChannels[n - 1].source = DMA_Source; \
+} \
+void DMACH##n##BurstConfig(Uint16 bsize, int16 srcbstep, int16 desbstep) \
+{ \
+} \
+void DMACH##n##TransferConfig(Uint16 tsize, int16 srctstep, int16 deststep) \
+{ \
+    dmaChannels[n - 1].length = tsize + 1; \
+} \
+void DMACH##n##WrapConfig(Uint16 srcwsize, int16 srcwstep, Uint16 deswsize, int16 deswstep) \
+{ \
+} \
+void DMACH##n##ModeConfig(Uint16 persel, Uint16 perinte, Uint16 oneshot, Uint16 cont, Uint16 synce, \
+                          Uint16 syncsel, Uint16 ovrinte, Uint16 datasize, Uint16 chintmode, Uint16 chinte) \
+{ \
+    dma_config_check(); \
+    dmaChannels[n - 1].interrupt = (chinte == CHINT_ENABLE); \
+}
+
+SIM_DMA_CHANNEL(1)
+SIM_DMA_CHANNEL(2)
+SIM_DMA_CHANNEL(3)
+SIM_DMA_CHANNEL(4)
+SIM_DMA_CHANNEL(5)
+SIM_DMA_CHANNEL(6)
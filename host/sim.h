@@ -0,0 +1,79 @@
+/*
+ * sim.h
+ *
+ *  Host simulator of the F28069M peripherals the firmware uses, for the host build (host/CMakeLists.txt).
+ *  It defines the registers of the host DSP28x_Project.h, implements the HAL accessors of hal.h on them
+ *  and models:
+ *   - one ePWM time base (the channels count in lockstep with ePWM1) in up/down count mode, TBPRD and
+ *     CMPA load from their shadow registers at counter zero, hal_epwm_write_prescaler() switches at once
+ *   - the ePWM1 interrupt every ETPS INTPRD counter zeros, and DMA channels 1-6 moving one word from
+ *     their source into CMPA on every SOCA (counter zero) after the shadow load, channel 1 flagging its
+ *     interrupt (PIE 7.1) at the end of each transfer; configuring the DMA from an ISR or writing the
+ *     ePWM registers before EPWMCFG moved them to the DMA's peripheral frame fails the run
+ *   - SCI A with 4 level RX and TX FIFOs, one character every 10 bit times at the programmed baud rate
+ *   - XINT1 on a simulated trigger edge
+ *  Time is counted in SYSCLKOUT cycles and only moves in sim_run() and in the firmware's busy waits
+ *  (hal_busy_wait()), ISRs run at the instant of their event and take no time, so every run is
+ *  deterministic. The main loop (firmware_poll()) runs between events.
+ *  The firmware keeps its state in statics, so a process boots it once.
+ */
+#include "DSP28x_Project.h"
+#include "main.h"
+
+#ifndef SIM_H
+#define SIM_H
+
+#define SIM_SYSCLK_HZ 90000000.0
+#define SIM_LSPCLK_DIVIDER 4            // LSPCLK = SYSCLKOUT / 4 = 22.5 MHz
+#define SIM_SCI_FIFO_DEPTH 4
+
+// CMPA write sources
+#define SIM_WRITE_CPU 0                 // hal_epwm_write_compare() or hal_epwm_write_compare_hr()
+#define SIM_WRITE_DMA 1                 // A DMA channel on SOCA
+
+// One write to a CMPA shadow register
+typedef struct
+{
+    Uint64 time;                        // SYSCLKOUT cycles since boot
+    Uint32 period;                      // Counter zeros since the outputs started, the write loads at period + 1
+    Uint16 channel;
+    Uint16 value;
+    Uint16 source;                      // SIM_WRITE_CPU or SIM_WRITE_DMA
+} SimCmpaWrite;
+
+// One PWM period with the period and compares loaded at its counter zero
+typedef struct
+{
+    Uint64 time;                        // SYSCLKOUT cycles since boot at the counter zero
+    Uint32 period;                      // Counter zeros since the outputs started, 1 for the first period after the start
+    Uint16 timerPeriod;                 // Active TBPRD
+    Uint16 clockPrescale;               // TBCLK = SYSCLKOUT / clockPrescale
+    Uint16 compare[HAL_EPWM_CHANNELS];  // Active CMPA of every channel
+    Uint16 isr;                         // 1 if the ePWM1 interrupt ran at this counter zero
+} SimPeriod;
+
+// Function prototypes
+void sim_boot(void);                    // Resets the simulated peripherals and runs firmware_init()
+void sim_run(Uint64 cycles);            // Runs the main loop and the ISRs for the given SYSCLKOUT cycles
+void sim_run_seconds(double seconds);
+void sim_run_periods(Uint32 periods);   // Runs until that many more PWM periods have started
+Uint64 sim_time(void);                  // SYSCLKOUT cycles since boot
+Uint32 sim_periods(void);               // PWM periods started since the outputs started
+Uint32 sim_isr_calls(void);             // ePWM1 interrupts taken
+
+void sim_sci_send(const char *bytes, Uint32 count); // Queues bytes for the RX line, they arrive at the baud rate
+void sim_sci_send_string(const char *text);         // Queues a string with its terminating '\0', as HTerm sends a line
+int sim_sci_script(const char *script); // Queues a script, one "<ms> <text>" line per transfer, returns 0 on a syntax error
+const char *sim_sci_output(Uint32 *count); // Everything the TX line sent since the last sim_sci_output_clear()
+void sim_sci_output_clear(void);
+Uint32 sim_sci_rx_overruns(void);       // Characters lost because the RX FIFO was full
+
+void sim_trigger_edge(void);            // Falling edge on the preset trigger input (XINT1)
+
+void sim_log_enable(Uint16 enable);     // Records CMPA writes and periods (on after boot)
+const SimCmpaWrite *sim_cmpa_writes(Uint32 *count);
+const SimPeriod *sim_cmpa_periods(Uint32 *count);
+void sim_log_clear(void);
+void sim_set_period_hook(void (*hook)(const SimPeriod *period)); // Called for every period, also with the log off
+
+#endif
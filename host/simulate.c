@@ -0,0 +1,155 @@
+/*
+ * simulate.c
+ *
+ *  Command line driver of the host simulator: boots the firmware, feeds it an SCI input script
+ *  (see sim_sci_script()) and writes what came out.
+ *
+ *  firmware_sim [-s script] [-t seconds] [-w writes.csv] [-p periods.csv] [-o output.txt]
+ *    -s  SCI input script, none leaves the firmware idle at its welcome screen
+ *    -t  Simulated run time in seconds (default 1)
+ *    -w  Every CMPA write as CSV: time in SYSCLKOUT cycles, period, channel, value, source (cpu / dma)
+ *    -p  Every PWM period as CSV: time, period, TBPRD, prescaler, the loaded CMPA of each channel, isr
+ *    -o  Text the SCI sent, standard output if not given
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+static char *read_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    char *text;
+    long size;
+
+    if (!file)
+    {
+        perror(path);
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    text = malloc(size + 1);
+    if (!text || fread(text, 1, size, file) != (size_t) size)
+    {
+        fprintf(stderr, "%s: read failed\n", path);
+        fclose(file);
+        free(text);
+        return 0;
+    }
+    text[size] = '\0';
+    fclose(file);
+    return text;
+}
+
+static int write_cmpa_writes(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    const SimCmpaWrite *writes;
+    Uint32 count, i;
+
+    if (!file)
+    {
+        perror(path);
+        return 0;
+    }
+    writes = sim_cmpa_writes(&count);
+    fprintf(file, "time,period,channel,value,source\n");
+    for (i = 0; i < count; i++)
+    {
+        fprintf(file, "%llu,%lu,%u,%u,%s\n", (unsigned long long) writes[i].time, (unsigned long) writes[i].period,
+                writes[i].channel, writes[i].value, writes[i].source == SIM_WRITE_DMA ? "dma" : "cpu");
+    }
+    fclose(file);
+    return 1;
+}
+
+static int write_cmpa_periods(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    const SimPeriod *periods;
+    Uint32 count, i;
+    Uint16 ch;
+
+    if (!file)
+    {
+        perror(path);
+        return 0;
+    }
+    periods = sim_cmpa_periods(&count);
+    fprintf(file, "time,period,tbprd,prescale");
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        fprintf(file, ",cmpa%u", ch + 1);
+    }
+    fprintf(file, ",isr\n");
+    for (i = 0; i < count; i++)
+    {
+        fprintf(file, "%llu,%lu,%u,%u", (unsigned long long) periods[i].time, (unsigned long) periods[i].period,
+                periods[i].timerPeriod, periods[i].clockPrescale);
+        for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+        {
+            fprintf(file, ",%u", periods[i].compare[ch]);
+        }
+        fprintf(file, ",%u\n", periods[i].isr);
+    }
+    fclose(file);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *scriptPath = 0, *writesPath = 0, *periodsPath = 0, *outputPath = 0;
+    double seconds = 1;
+    const char *output;
+    Uint32 outputCount;
+    FILE *outputFile = stdout;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (i + 1 < argc && !strcmp(argv[i], "-s")) scriptPath = argv[++i];
+        else if (i + 1 < argc && !strcmp(argv[i], "-t")) seconds = atof(argv[++i]);
+        else if (i + 1 < argc && !strcmp(argv[i], "-w")) writesPath = argv[++i];
+        else if (i + 1 < argc && !strcmp(argv[i], "-p")) periodsPath = argv[++i];
+        else if (i + 1 < argc && !strcmp(argv[i], "-o")) outputPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [-s script] [-t seconds] [-w writes.csv] [-p periods.csv] [-o output.txt]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    sim_boot();
+    if (scriptPath)
+    {
+        char *script = read_file(scriptPath);
+        int queued = script && sim_sci_script(script);
+        free(script);
+        if (!queued)
+        {
+            return 1;
+        }
+    }
+    sim_run_seconds(seconds);
+
+    if ((writesPath && !write_cmpa_writes(writesPath)) || (periodsPath && !write_cmpa_periods(periodsPath)))
+    {
+        return 1;
+    }
+
+    if (outputPath && !(outputFile = fopen(outputPath, "w")))
+    {
+        perror(outputPath);
+        return 1;
+    }
+    output = sim_sci_output(&outputCount);
+    fwrite(output, 1, outputCount, outputFile);
+    if (outputFile != stdout)
+    {
+        fclose(outputFile);
+    }
+    return 0;
+}
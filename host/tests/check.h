@@ -0,0 +1,46 @@
+/*
+ * check.h
+ *
+ *  Minimal assertions for the host tests: CHECK() reports a failed condition and carries on,
+ *  check_result() is the test's exit code.
+ */
+#include <math.h>
+#include <stdio.h>
+
+#ifndef CHECK_H
+#define CHECK_H
+
+static int checkFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            checkFailures++; \
+        } \
+    } while (0)
+
+// Same with the two values printed, for numeric comparisons within a tolerance
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        double checkActual = (actual), checkExpected = (expected); \
+        if (!(fabs(checkActual - checkExpected) <= (tolerance))) \
+        { \
+            fprintf(stderr, "%s:%d: CHECK_NEAR failed: %s = %g, expected %g +- %g\n", __FILE__, __LINE__, \
+                    #actual, checkActual, checkExpected, (double) (tolerance)); \
+            checkFailures++; \
+        } \
+    } while (0)
+
+static int check_result(void)
+{
+    if (checkFailures)
+    {
+        fprintf(stderr, "%d check(s) failed\n", checkFailures);
+        return 1;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * cla_kernel.c
+ *
+ *  compare_values() as CLA task 1 sees it, for test_cla_kernel.c: this file is compiled with
+ *  __TMS320C28XX_CLA__ (host/CMakeLists.txt), so pwm.h gives the CLA's WaveformPlan, whose table slot
+ *  is a Uint32, and PLAN_TABLE() reads the sine table.
+ */
+#include <stddef.h>
+#include <string.h>
+#include "pwm.h"
+
+/*
+ * Copies a C28x plan from its tableShift field on into a CLA plan, as the CLA reads it from the message
+ * RAM, and calculates the compares at phase. Returns 0 if the fields after the table slot do not have the
+ * same size in both layouts.
+ */
+int cla_kernel_compare_values(const void *planFromTableShift, size_t length, Uint32 phase, Uint16 *compare)
+{
+    WaveformPlan plan;
+    size_t claLength = sizeof(plan) - offsetof(WaveformPlan, tableShift);
+
+    // The C28x plan may carry more padding at its end, the host pointer is 8 bytes
+    if (claLength > length || length - claLength >= sizeof(void *))
+    {
+        return 0;
+    }
+
+    memset(&plan, 0, sizeof(plan));
+    memcpy(&plan.tableShift, planFromTableShift, claLength);
+    compare_values(&plan, phase, compare);
+    return 1;
+}
@@ -0,0 +1,87 @@
+/*
+ * test_cla_kernel.c
+ *
+ *  CLA_OFFLOAD shares the compare kernel between the ISR and CLA task 1 (cla_shared.h). The kernel is
+ *  compiled a second time with the CLA's view of the headers (cla_kernel.c), and both have to give the
+ *  same compares for random sine plans, the ones the CLA takes, at random phases in every modulation mode.
+ *  The plan reaches the CLA copy as bytes after the table slot, like through the message RAM.
+ */
+#include <stddef.h>
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+
+#define PLANS 20000
+#define PHASES 64           // Random phases per plan
+
+int cla_kernel_compare_values(const void *planFromTableShift, size_t length, Uint32 phase, Uint16 *compare);
+
+static Uint32 randomState = 2024;
+
+// Linear congruential generator, the same sequence on every run
+static Uint32 random_next(void)
+{
+    randomState = randomState * 1664525 + 1013904223;
+    return randomState;
+}
+
+// Random float from 0 to 1
+static float random_unit(void)
+{
+    return (random_next() >> 8) * (1.0f / 16777216.0f);
+}
+
+int main(void)
+{
+    EPwmParams params;
+    WaveformPlan plan;
+    Uint32 i, compared = 0, mismatches = 0;
+    Uint16 k, ch;
+
+    dds_init_sine_table();
+
+    for (i = 0; i < PLANS; i++)
+    {
+        memset(&params, 0, sizeof(params));
+        params.pwmWavFreq = PWMWAVFREQ_MIN + random_unit() * (PWMWAVFREQ_MAX - PWMWAVFREQ_MIN);
+        params.sinWavFreq = random_unit() * SINWAVFREQ_MAX;
+        params.modulationMode = random_next() % (MODULATION_SVPWM + 1);
+        params.modulation_depth = random_unit() * modulation_depth_max(&params);
+        params.offset = (2 * random_unit() - 1) * offset_limit(&params);
+        for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+        {
+            params.phaseLead[ch] = MIN_ANGLE + random_unit() * (MAX_ANGLE - MIN_ANGLE);
+        }
+        params.waveform = WAVEFORM_SINE;
+        if (!params_valid(&params))
+        {
+            continue;   // Sine frequency not below half the PWM frequency
+        }
+        compile_waveform_plan(&params, &plan);
+
+        for (k = 0; k < PHASES; k++)
+        {
+            Uint32 phase = random_next();
+            Uint16 cpu[HAL_EPWM_CHANNELS], cla[HAL_EPWM_CHANNELS];
+
+            compare_values(&plan, phase, cpu);
+            if (!cla_kernel_compare_values(&plan.tableShift, sizeof(plan) - offsetof(WaveformPlan, tableShift),
+                                           phase, cla))
+            {
+                fprintf(stderr, "WaveformPlan layouts differ after the table slot\n");
+                return 1;
+            }
+            if (memcmp(cpu, cla, sizeof(cpu)))
+            {
+                mismatches++;
+            }
+            compared++;
+        }
+    }
+
+    printf("%lu compare sets, %lu differ\n", (unsigned long) compared, (unsigned long) mismatches);
+    CHECK(compared > PLANS * PHASES / 2);
+    CHECK(mismatches == 0);
+
+    return check_result();
+}
@@ -0,0 +1,247 @@
+/*
+ * test_command_parser.c
+ *
+ *  ASCII command parser on its own: known commands give the expected values or errors, a million
+ *  random commands never get a parameter set through that params_valid() rejects and always leave the
+ *  parser ready for the next one, and a million random valid commands parse to the values they were
+ *  printed from. The valid commands are timed for the parser's throughput in characters per second.
+ */
+#include <string.h>
+#include <time.h>
+#include "check.h"
+#include "sim.h"
+#include "command_parser.h"
+
+#define FUZZ_COMMANDS 1000000
+#define VALID_COMMANDS 1000000
+#define FUZZ_MAX_LENGTH 24
+#define THROUGHPUT_SET 1024     // Different commands the throughput loop cycles through
+
+static EPwmParams baseParams;
+static Uint32 randomState = 12345;
+
+// Linear congruential generator, the same sequence on every run
+static Uint32 random_next(void)
+{
+    randomState = randomState * 1664525 + 1013904223;
+    return randomState >> 8;
+}
+
+// Random integer from 0 to range - 1
+static Uint32 random_below(Uint32 range)
+{
+    return random_next() % range;
+}
+
+/*
+ * Feeds text and its terminator. Between the characters the parser may only answer pending or, once,
+ * failed; returns the answer to the terminator and counts the characters fed.
+ */
+static Uint16 parse(CommandParser *parser, const char *text, Uint32 *characters)
+{
+    Uint16 result, failed = 0;
+    const char *c;
+
+    command_parser_reset(parser, &baseParams);
+    for (c = text; *c; c++)
+    {
+        result = command_parser_feed(parser, *c);
+        if (result == COMMAND_FAILED)
+        {
+            CHECK(!failed);
+            failed = 1;
+        }
+        else if (result != COMMAND_PENDING)
+        {
+            CHECK(result == COMMAND_PENDING);
+            return result;
+        }
+    }
+    if (characters)
+    {
+        *characters += strlen(text) + 1;
+    }
+
+    result = command_parser_feed(parser, COMMAND_TERMINATOR);
+    CHECK(result == COMMAND_INVALID || (result == COMMAND_VALID && !failed));
+    CHECK(command_parser_idle(parser));
+    return result;
+}
+
+// Parses a command that has to fail with the given error
+static void check_error(const char *text, Uint16 error)
+{
+    CommandParser parser;
+
+    if (parse(&parser, text, 0) != COMMAND_INVALID || parser.error != error)
+    {
+        fprintf(stderr, "\"%s\": error %u, expected %u\n", text, parser.error, error);
+        CHECK(0);
+    }
+}
+
+static void check_known_commands(void)
+{
+    CommandParser parser;
+
+    CHECK(parse(&parser, "P 2500, S 60,M .13, A2 120", 0) == COMMAND_VALID);
+    CHECK(parser.params.pwmWavFreq == 2500);
+    CHECK(parser.params.sinWavFreq == 60);
+    CHECK_NEAR(parser.params.modulation_depth, .13, 1e-6);
+    CHECK(parser.params.phaseLead[1] == 120);
+    CHECK(parser.params.offset == baseParams.offset);
+
+    CHECK(parse(&parser, "v2 m1.1 o-.02", 0) == COMMAND_VALID);
+    CHECK(parser.params.modulationMode == MODULATION_SVPWM);
+    CHECK_NEAR(parser.params.modulation_depth, 1.1, 1e-6);
+    CHECK_NEAR(parser.params.offset, -.02, 1e-6);
+
+    check_error("", COMMAND_ERROR_EMPTY);
+    check_error(" , ", COMMAND_ERROR_EMPTY);
+    check_error("X 5", COMMAND_ERROR_CHARACTER);
+    check_error("A9 10", COMMAND_ERROR_CHANNEL);
+    check_error("S", COMMAND_ERROR_NO_VALUE);
+    check_error("S ,P 1000", COMMAND_ERROR_NO_VALUE);
+    check_error("M .1234567890", COMMAND_ERROR_DIGITS);
+    check_error("M .1.2", COMMAND_ERROR_DECIMAL_POINTS);
+    check_error("S 301", COMMAND_ERROR_RANGE);
+    check_error("P 200000", COMMAND_ERROR_RANGE);
+    check_error("M 1.1", COMMAND_ERROR_DEPTH);
+    check_error("M 1, O .1", COMMAND_ERROR_OFFSET);
+    check_error("P 100, S 50", COMMAND_ERROR_NYQUIST);
+    check_error("V 1.5", COMMAND_ERROR_NOT_INTEGER);
+    check_error("V 1.", COMMAND_ERROR_NOT_INTEGER);
+    check_error("V .5", COMMAND_ERROR_NOT_INTEGER);
+    check_error("V 3", COMMAND_ERROR_RANGE);
+}
+
+// Random characters, mostly ones the parser knows so that commands get deep into the states
+static void fuzz(void)
+{
+    static const char alphabet[] = "PSMVOAaps0123456789012345678901234567890.-, \t";
+    CommandParser parser;
+    char text[FUZZ_MAX_LENGTH + 1];
+    Uint32 i, valid = 0;
+    Uint16 k, length;
+
+    for (i = 0; i < FUZZ_COMMANDS; i++)
+    {
+        length = random_below(FUZZ_MAX_LENGTH + 1);
+        for (k = 0; k < length; k++)
+        {
+            // One in sixteen is any byte but the terminator
+            text[k] = random_below(16) ? alphabet[random_below(sizeof(alphabet) - 1)] : (char) (1 + random_below(255));
+        }
+        text[length] = 0;
+
+        if (parse(&parser, text, 0) == COMMAND_VALID)
+        {
+            valid++;
+            if (!params_valid(&parser.params))
+            {
+                fprintf(stderr, "\"%s\" accepted with invalid parameters\n", text);
+                CHECK(0);
+            }
+        }
+        else
+        {
+            CHECK(parser.error != COMMAND_ERROR_NONE);
+        }
+    }
+    printf("fuzz: %u random commands, %lu valid\n", FUZZ_COMMANDS, (unsigned long) valid);
+    CHECK(valid > 0);
+}
+
+// A random command within all limits, printed with the precision its values are compared to
+typedef struct
+{
+    char text[64];
+    Uint32 pwmFreq;
+    Uint32 sinFreq;             // Hundredths of a Hz, below 300 Hz < pwmFreq / 2
+    Uint32 mode;
+    Uint32 depth;               // Thousandths
+    int angle;
+    Uint16 ch;
+} ValidCommand;
+
+static void make_valid_command(ValidCommand *command)
+{
+    command->pwmFreq = 1000 + random_below(PWMWAVFREQ_MAX - 1000 + 1);
+    command->sinFreq = random_below(SINWAVFREQ_MAX * 100);
+    command->mode = random_below(MODULATION_SVPWM + 1);
+    command->depth = random_below(1001);
+    command->angle = (int) random_below(MAX_ANGLE - MIN_ANGLE + 1) + MIN_ANGLE;
+    command->ch = random_below(HAL_EPWM_CHANNELS);
+
+    sprintf(command->text, "P %lu, S %lu.%02lu,V%lu M %lu.%03lu A%u %d", (unsigned long) command->pwmFreq,
+            (unsigned long) command->sinFreq / 100, (unsigned long) command->sinFreq % 100,
+            (unsigned long) command->mode, (unsigned long) command->depth / 1000,
+            (unsigned long) command->depth % 1000, command->ch + 1, command->angle);
+}
+
+static void valid_commands(void)
+{
+    CommandParser parser;
+    ValidCommand command;
+    Uint32 i;
+
+    for (i = 0; i < VALID_COMMANDS; i++)
+    {
+        make_valid_command(&command);
+        if (parse(&parser, command.text, 0) != COMMAND_VALID)
+        {
+            fprintf(stderr, "\"%s\" rejected: %s\n", command.text, command_parser_error_message(parser.error));
+            CHECK(0);
+            continue;
+        }
+        CHECK(parser.params.pwmWavFreq == command.pwmFreq);
+        CHECK(fabs(parser.params.sinWavFreq - command.sinFreq / 100.0) <= 1e-5 * SINWAVFREQ_MAX);
+        CHECK(parser.params.modulationMode == command.mode);
+        CHECK(fabs(parser.params.modulation_depth - command.depth / 1000.0) <= 1e-6);
+        CHECK(parser.params.phaseLead[command.ch] == command.angle);
+    }
+}
+
+// Parses a set of valid commands over and over, only the parser is timed
+static void throughput(void)
+{
+    static ValidCommand commands[THROUGHPUT_SET];
+    CommandParser parser;
+    Uint32 i, characters = 0, valid = 0;
+    clock_t start;
+    double seconds;
+
+    for (i = 0; i < THROUGHPUT_SET; i++)
+    {
+        make_valid_command(&commands[i]);
+    }
+
+    start = clock();
+    for (i = 0; i < VALID_COMMANDS; i++)
+    {
+        valid += parse(&parser, commands[i % THROUGHPUT_SET].text, &characters) == COMMAND_VALID;
+    }
+    seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    printf("throughput: %u commands, %lu characters in %.3f s, %.1f M characters/s\n", VALID_COMMANDS,
+           (unsigned long) characters, seconds, seconds > 0 ? characters / seconds / 1e6 : 0);
+    CHECK(valid == VALID_COMMANDS);
+}
+
+int main(void)
+{
+    memset(&baseParams, 0, sizeof(baseParams));
+    init_phase_leads(&baseParams);
+    baseParams.pwmWavFreq = 5000;
+    baseParams.sinWavFreq = 50;
+    baseParams.modulation_depth = .5;
+    baseParams.waveform = WAVEFORM_SINE;
+    CHECK(params_valid(&baseParams));
+
+    check_known_commands();
+    fuzz();
+    valid_commands();
+    throughput();
+
+    return check_result();
+}
@@ -0,0 +1,233 @@
+/*
+ * test_config_store.c
+ *
+ *  Saved configuration (config_store.h) on the flash emulator (flash_sim.h), built with CONFIG_STORE.
+ *  Record format: a record fits its slot, a damaged record is skipped for the one before it. Power loss:
+ *  thousands of boots, each followed by a random run of saves, a third of them cut by a power loss at a
+ *  random word operation, some of them cut during the boot itself. After every boot each key has to
+ *  come back with its last completed save, or with the save the power loss interrupted. Sectors are only
+ *  erased at boot, and saves are skipped only while both sectors are full. Background saves: the live
+ *  parameters are written once they have settled, a save that failed shows in config_status().
+ */
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+#include "flash_sim.h"
+
+#define ROUNDS 1500
+#define MAX_SAVES 700           // Per boot, more than the two sectors hold
+#define CUT_OPERATIONS 30       // Word operations per save, roughly, to spread the power losses over a run
+
+static Uint32 randomState = 7;
+
+// Linear congruential generator, the same sequence on every run
+static Uint32 random_below(Uint32 range)
+{
+    randomState = randomState * 1664525 + 1013904223;
+    return (randomState >> 8) % range;
+}
+
+// Random parameters within all limits
+static void random_params(EPwmParams *params)
+{
+    memset(params, 0, sizeof(*params));
+    init_phase_leads(params);
+    params->pwmWavFreq = 1000 + random_below(19000);
+    params->sinWavFreq = random_below(30000) / 100.0f;
+    params->modulation_depth = random_below(1001) / 1000.0f;
+    params->modulationMode = random_below(MODULATION_SVPWM + 1);
+    params->phaseLead[1] = random_below(721) - 360.0f;
+    params->waveform = random_below(4) ? WAVEFORM_SINE : WAVEFORM_TABLE;   // A table comes back as the sine
+}
+
+// Compares restored parameters with saved ones, the waveform comes back as the sine
+static int same_params(const EPwmParams *restored, const EPwmParams *saved)
+{
+    EPwmParams expected = *saved;
+
+    expected.waveform = WAVEFORM_SINE;
+    return memcmp(restored, &expected, sizeof(expected)) == 0;
+}
+
+// A record damaged after it was written is skipped, the key falls back to its record before
+static void check_record_format(void)
+{
+    EPwmParams first, second, restored;
+    Uint16 slot;
+
+    CHECK(CONFIG_RECORD_WORDS <= CONFIG_SLOT_WORDS);
+
+    sim_flash_erase_all();
+    config_init();
+    random_params(&first);
+    random_params(&second);
+    CHECK(config_save(CONFIG_KEY_LIVE, &first));
+    CHECK(config_save(CONFIG_KEY_LIVE, &second));
+    CHECK(config_save(CONFIG_KEY_LIVE, &second));     // Unchanged, nothing written
+
+    // Both blank, the records go to sector G from slot 0 on
+    for (slot = 0; slot < 2; slot++)
+    {
+        const ConfigRecord *record = (const ConfigRecord *) &simFlashSectorG[slot * CONFIG_SLOT_WORDS];
+        CHECK(record->magic == CONFIG_RECORD_MAGIC && record->length == CONFIG_RECORD_WORDS);
+        CHECK(record->key == CONFIG_KEY_LIVE && record->sequence == slot + 1u);
+        CHECK(record->crc == config_record_crc(record));
+    }
+    CHECK(simFlashSectorG[2 * CONFIG_SLOT_WORDS] == CONFIG_ERASED);
+    CHECK(simFlashSectorH[0] == CONFIG_ERASED);
+
+    config_init();
+    CHECK(config_get(CONFIG_KEY_LIVE, &restored) && same_params(&restored, &second));
+
+    // The high word of the second record's PWM frequency lost (programmed to 0)
+    ((ConfigRecord *) &simFlashSectorG[CONFIG_SLOT_WORDS])->params.pwmWavFreq = 0;
+    config_init();
+    CHECK(config_get(CONFIG_KEY_LIVE, &restored) && same_params(&restored, &first));
+    CHECK(!config_get(CONFIG_KEY_PRESET(0), &restored));
+}
+
+static void check_power_loss(void)
+{
+    static EPwmParams saved[CONFIG_KEYS];
+    static Uint16 haveSaved[CONFIG_KEYS];
+    // Static, so a longjmp of the emulator leaves them as they are
+    static EPwmParams inFlight;
+    static int inFlightKey;
+    static Uint32 round, saves, skipped, runtimeErases, mismatches, inFlightRestored;
+    Uint16 key;
+
+    sim_flash_erase_all();
+    sim_flash_seed(99);
+    inFlightKey = -1;
+
+    for (round = 0; round < ROUNDS; round++)
+    {
+        Uint32 count, erases, i;
+
+        // Boot, a power loss may hit the erase of a full sector
+        sim_flash_power_loss_after(random_below(8) == 0 ? (long) random_below(3) : -1);
+        if (setjmp(simFlashPowerLoss))
+        {
+            sim_flash_power_loss_after(-1);
+        }
+        config_init();
+        sim_flash_power_loss_after(-1);
+
+        for (key = 0; key < CONFIG_KEYS; key++)
+        {
+            EPwmParams restored;
+            int found = config_get(key, &restored);
+
+            if (found && key == inFlightKey && same_params(&restored, &inFlight))
+            {
+                inFlightRestored++;
+            }
+            else if (found != haveSaved[key] || (found && !same_params(&restored, &saved[key])))
+            {
+                if (mismatches++ < 5)
+                {
+                    fprintf(stderr, "round %lu key %u: found %d, saved %u\n", (unsigned long) round, key, found,
+                            haveSaved[key]);
+                }
+            }
+            if (found)
+            {
+                saved[key] = restored;
+                haveSaved[key] = 1;
+            }
+        }
+        inFlightKey = -1;
+
+        // A run of saves, a third of the runs end in a power loss
+        count = random_below(MAX_SAVES);
+        erases = simFlashStats.erases;
+        if (setjmp(simFlashPowerLoss))
+        {
+            sim_flash_power_loss_after(-1);
+            continue;
+        }
+        sim_flash_power_loss_after(random_below(3) == 0 ? (long) random_below(CUT_OPERATIONS * count + 1) : -1);
+        for (i = 0; i < count; i++)
+        {
+            key = random_below(3) ? CONFIG_KEY_LIVE : random_below(CONFIG_KEYS);
+            random_params(&inFlight);
+            inFlightKey = key;
+            if (config_save(key, &inFlight))
+            {
+                saved[key] = inFlight;
+                haveSaved[key] = 1;
+                saves++;
+            }
+            else
+            {
+                skipped++;
+            }
+            inFlightKey = -1;
+        }
+        sim_flash_power_loss_after(-1);
+        runtimeErases += simFlashStats.erases - erases;
+    }
+
+    printf("%lu boots, %lu saves, %lu skipped with both sectors full, %lu erases, %lu power losses, "
+           "%lu interrupted saves restored\n", (unsigned long) round, (unsigned long) saves, (unsigned long) skipped,
+           (unsigned long) simFlashStats.erases, (unsigned long) simFlashStats.powerLosses,
+           (unsigned long) inFlightRestored);
+    CHECK(mismatches == 0);
+    CHECK(runtimeErases == 0);
+    CHECK(saves > ROUNDS * MAX_SAVES / 4);
+    CHECK(skipped > 0);
+    CHECK(simFlashStats.powerLosses > ROUNDS / 4);
+    CHECK(inFlightRestored > 0);
+}
+
+// config_service() saves the live parameters only after CONFIG_SAVE_SETTLE without a new change
+static void check_background_save(void)
+{
+    EPwmParams params, restored;
+    Uint32 saves;
+
+    sim_boot();
+    sim_flash_erase_all();
+    config_init();
+
+    random_params(&liveEpwmParams);
+    config_request_save();
+    sim_run_seconds(1.5);
+    random_params(&liveEpwmParams);
+    config_request_save();      // A second change restarts the wait
+    sim_run_seconds(1.5);
+    config_service();
+    CHECK(simFlashSectorG[0] == CONFIG_ERASED);
+    CHECK(config_status() == CONFIG_STATUS_SAVE_PENDING);
+
+    sim_run_seconds(1.0);
+    config_service();
+    CHECK(config_status() == 0);
+    CHECK(config_get(CONFIG_KEY_LIVE, &restored) && same_params(&restored, &liveEpwmParams));
+    CHECK(simFlashSectorG[CONFIG_SLOT_WORDS] == CONFIG_ERASED);
+
+    // Fill both sectors, the next save fails until the next boot
+    for (saves = 0; saves < 2 * CONFIG_SLOTS; saves++)
+    {
+        random_params(&params);
+        config_save(CONFIG_KEY_PRESET(0), &params);
+    }
+    CHECK(config_status() == CONFIG_STATUS_SAVE_FAILED);
+    random_params(&liveEpwmParams);
+    config_request_save();
+    sim_run_seconds(2.5);
+    config_service();
+    CHECK(config_status() == CONFIG_STATUS_SAVE_FAILED);
+
+    config_init();
+    CHECK(config_status() == 0);
+}
+
+int main(void)
+{
+    check_record_format();
+    check_power_loss();
+    check_background_save();
+
+    return check_result();
+}
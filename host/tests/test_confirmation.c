@@ -0,0 +1,76 @@
+/*
+ * test_confirmation.c
+ *
+ *  ASCII command flow: the rest of the Y/N answer line up to its terminator is no new command,
+ *  and an empty command is rejected instead of asking for confirmation.
+ */
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+
+// Counts the occurrences of text in the SCI output since the last clear
+static Uint32 output_count(const char *text)
+{
+    const char *output = sim_sci_output(0);
+    Uint32 count = 0;
+
+    while ((output = strstr(output, text)) != 0)
+    {
+        count++;
+        output += strlen(text);
+    }
+    return count;
+}
+
+int main(void)
+{
+    sim_boot();
+    sim_run_seconds(1.5);
+
+    // Command and answer each sent with the terminator, as HTerm does
+    sim_sci_output_clear();
+    sim_sci_send_string("P 5000, S 50");
+    sim_run_seconds(0.3);
+    CHECK(output_count("PLEASE CONFIRM") == 1);
+    sim_sci_output_clear();
+    sim_sci_send_string("Y");
+    sim_run_seconds(1.5);
+    CHECK(output_count("Values confirmed and set.") == 1);
+    CHECK(output_count("You sent:") == 0);
+    CHECK(output_count("PLEASE CONFIRM") == 0);
+    CHECK(sim_periods() > 0);
+
+    // The answer line may carry more than the letter
+    sim_sci_output_clear();
+    sim_sci_send_string("S 40");
+    sim_run_seconds(0.3);
+    sim_sci_send_string("yes");
+    sim_run_seconds(1.5);
+    CHECK(output_count("Values confirmed and set.") == 1);
+    CHECK(output_count("PLEASE CONFIRM") == 1);
+
+    // A lone terminator is an empty command
+    sim_sci_output_clear();
+    sim_sci_send_string("");
+    sim_run_seconds(1.5);
+    CHECK(output_count("Empty command") == 1);
+    CHECK(output_count("PLEASE CONFIRM") == 0);
+
+    // Only separators is empty too
+    sim_sci_output_clear();
+    sim_sci_send_string(" , ");
+    sim_run_seconds(1.5);
+    CHECK(output_count("Empty command") == 1);
+    CHECK(output_count("PLEASE CONFIRM") == 0);
+
+    // The next command is read normally
+    sim_sci_output_clear();
+    sim_sci_send_string("M .5");
+    sim_run_seconds(0.3);
+    CHECK(output_count("PLEASE CONFIRM") == 1);
+    sim_sci_send_string("N");
+    sim_run_seconds(1.5);
+    CHECK(output_count("Values reset to:") == 1);
+
+    return check_result();
+}
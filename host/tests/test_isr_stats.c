@@ -0,0 +1,86 @@
+/*
+ * test_isr_stats.c
+ *
+ *  PWM ISR profiling (isr_stats.h), built with ISR_PROFILING. The simulator enters the ISR right at the
+ *  counter zero and runs it in no time, so the statistics are exact: every call counted, no execution
+ *  cycles, no entry latency and no CPU load. Interrupts held off for whole periods have to show up as
+ *  missed updates, with the ISR running every period and while it decimates.
+ */
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+
+// Sends a command, confirms it and lets the new values run for a while
+static void command(const char *text)
+{
+    sim_sci_send_string(text);
+    sim_run_seconds(0.3);
+    sim_sci_send_string("Y");
+    sim_run_seconds(0.5);
+}
+
+// Clears the statistics, runs a while and checks them against the simulator's own count of ISR calls
+static void check_clean_run(void)
+{
+    Uint32 calls;
+    Uint16 bin;
+
+    isr_stats_reset();
+    calls = sim_isr_calls();
+    sim_run_seconds(0.5);
+    calls = sim_isr_calls() - calls;
+
+    CHECK(calls > 100);
+    CHECK(isrStats.calls == calls);
+    CHECK(isrStats.cyclesMin == 0 && isrStats.cyclesMax == 0 && isrStats.cyclesSum == 0);
+    CHECK(isrStats.latencyMax == 0 && isrStats.latencySum == 0);
+    CHECK(isrStats.latencyHistogram[0] == calls);
+    for (bin = 1; bin < ISR_STATS_LATENCY_BINS; bin++)
+    {
+        CHECK(isrStats.latencyHistogram[bin] == 0);
+    }
+    CHECK(isrStats.missed == 0);
+    CHECK(isr_stats_cpu_load() == 0);
+}
+
+/*
+ * Holds the ePWM interrupt off for a number of PWM periods from right after an ISR call, every interrupt
+ * event in them but the one taken late is missed
+ */
+static void check_missed(Uint32 periods, Uint32 divisor)
+{
+    Uint32 missed, calls;
+
+    isr_stats_reset();
+    sim_run_periods(2 * divisor);
+    calls = sim_isr_calls();
+    while (sim_isr_calls() == calls)
+    {
+        sim_run_periods(1);
+    }
+    missed = isrStats.missed;
+
+    IER &= ~M_INT3;
+    sim_run_periods(periods);
+    IER |= M_INT3;
+    sim_run_periods(2 * divisor);
+
+    CHECK(isrStats.missed - missed == periods / divisor - 1);
+}
+
+int main(void)
+{
+    sim_boot();
+    sim_run_seconds(1.5);
+
+    command("P 5000, S 50, M .9");
+    check_clean_run();
+    check_missed(10, 1);
+
+    command("P 20000, S 10");       // ISR every 3rd period
+    check_clean_run();
+    check_missed(30, 3);
+
+    printf("%lu calls, %lu missed\n", (unsigned long) isrStats.calls, (unsigned long) isrStats.missed);
+    return check_result();
+}
@@ -0,0 +1,106 @@
+/*
+ * test_modulation.c
+ *
+ *  Modulation modes: over one sine period the CMPA values of the plan stay within 0 - TBPRD (no clipping)
+ *  up to the highest depth of each mode, and the line to line duty (channel 1 - channel 2) of the sine,
+ *  third harmonic and min-max modes is the same sine of amplitude depth * sqrt(3) / 2, the common mode
+ *  the injected modes add cancels.
+ */
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+
+#define SAMPLES 4096        // Phase steps per sine period
+#define HARMONICS 16        // Harmonics of the line to line duty added up for the distortion
+
+// Duty of each channel over one sine period, from the compare counts of compare_counts()
+static double duty[HAL_EPWM_CHANNELS][SAMPLES];
+
+// Amplitude of harmonic k of a signal sampled over one period
+static double harmonic(const double *signal, Uint16 k)
+{
+    double re = 0, im = 0;
+    Uint32 i;
+
+    for (i = 0; i < SAMPLES; i++)
+    {
+        re += signal[i] * cos(2 * M_PI * k * i / SAMPLES);
+        im += signal[i] * sin(2 * M_PI * k * i / SAMPLES);
+    }
+    return 2 * sqrt(re * re + im * im) / SAMPLES;
+}
+
+// Runs one mode at one depth and checks the compare range, line to line amplitude and distortion
+static void check_mode(Uint16 mode, double depth)
+{
+    EPwmParams params;
+    WaveformPlan plan;
+    double lineToLine[SAMPLES], distortion = 0, fundamental, minimum = 1e9, maximum = -1e9;
+    Uint16 compareMax = 0;
+    Uint32 i;
+    Uint16 ch, k;
+
+    memset(&params, 0, sizeof(params));
+    init_phase_leads(&params);
+    params.pwmWavFreq = 5000;
+    params.sinWavFreq = 50;
+    params.modulation_depth = depth;
+    params.modulationMode = mode;
+    params.waveform = WAVEFORM_SINE;
+    CHECK(params_valid(&params));
+    compile_waveform_plan(&params, &plan);
+
+    for (i = 0; i < SAMPLES; i++)
+    {
+        Uint32 phase = (Uint32) (i * (4294967296.0 / SAMPLES));
+        float counts[HAL_EPWM_CHANNELS];
+        Uint16 compare[HAL_EPWM_CHANNELS];
+
+        compare_counts(&plan, phase, counts);
+        compare_values(&plan, phase, compare);
+        for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+        {
+            if (compare[ch] > compareMax) compareMax = compare[ch];
+            if (counts[ch] < minimum) minimum = counts[ch];
+            if (counts[ch] > maximum) maximum = counts[ch];
+            duty[ch][i] = 1.0 - (double) counts[ch] / plan.timerPeriod;
+        }
+        lineToLine[i] = duty[0][i] - duty[1][i];
+    }
+
+    fundamental = harmonic(lineToLine, 1);
+    for (k = 2; k <= HARMONICS; k++)
+    {
+        double amplitude = harmonic(lineToLine, k);
+        distortion += amplitude * amplitude;
+    }
+    distortion = sqrt(distortion) / fundamental;
+
+    printf("mode %u depth %.4f: compares %.2f - %.2f of %u, line to line %.5f, distortion %.2e\n", mode, depth,
+           minimum, maximum, plan.timerPeriod, fundamental, distortion);
+    // At the highest depth the peaks touch 0 and TBPRD, the table's rounding may pass them by a fraction of a count
+    CHECK(minimum > -1 && maximum < plan.timerPeriod + 1);
+    CHECK(compareMax <= plan.timerPeriod);
+    CHECK_NEAR(fundamental, .5 * depth * sqrt(3.0), 1e-3 * depth + 1e-4);
+    CHECK(distortion < 1e-3);
+}
+
+int main(void)
+{
+    static const double depths[] = { .1, .5, .9, 1.0, MODULATION_DEPTH_INJECTED_MAX };
+    Uint16 i;
+
+    dds_init_sine_table();
+
+    for (i = 0; i < sizeof(depths) / sizeof(depths[0]); i++)
+    {
+        if (depths[i] <= MODULATION_DEPTH_MAX)
+        {
+            check_mode(MODULATION_SINE, depths[i]);
+        }
+        check_mode(MODULATION_THIRD_HARMONIC, depths[i]);
+        check_mode(MODULATION_SVPWM, depths[i]);
+    }
+
+    return check_result();
+}
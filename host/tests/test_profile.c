@@ -0,0 +1,71 @@
+/*
+ * test_profile.c
+ *
+ *  Profile ramps with ISR decimation: a profile that starts while the ISR runs every 3rd period and ramps
+ *  the sine frequency up has to lower the decimation first, so the interpolated compares of the periods
+ *  between ISR calls keep the sine's amplitude all through the ramp.
+ */
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+
+#define DEPTH 0.9
+
+static Uint32 checkedPeriods;
+static double worstAmplitudeError;
+
+// Recovers the amplitude from the three compares 120 degrees apart, as test_retune.c
+static void period_hook(const SimPeriod *period)
+{
+    double duty[HAL_EPWM_CHANNELS], alpha, beta, error;
+    Uint16 ch;
+
+    if (profileState != PROFILE_RUNNING || period->timerPeriod == 0)
+    {
+        return;
+    }
+
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        duty[ch] = (2.0 * (1.0 - (double) period->compare[ch] / period->timerPeriod) - 1.0) / DEPTH;
+    }
+    alpha = duty[0];
+    beta = (duty[1] - duty[2]) / sqrt(3.0);
+    error = fabs(sqrt(alpha * alpha + beta * beta) - 1.0) * .5 * DEPTH * period->timerPeriod;
+    if (error > worstAmplitudeError) worstAmplitudeError = error;
+    checkedPeriods++;
+}
+
+int main(void)
+{
+    ProfileSegment segment = { 290, DEPTH, 500, 100 };
+    Uint32 isrCalls, periods;
+
+    sim_boot();
+    sim_run_seconds(1.5);
+    sim_sci_send_string("P 20000, S 10, M .9");
+    sim_run_seconds(0.3);
+    sim_sci_send_string("Y");
+    sim_run_seconds(1.5);
+    CHECK(liveWaveformPlan.interruptDivisor == 3);
+
+    sim_set_period_hook(period_hook);
+    sim_log_enable(0);
+    CHECK(profile_load_segment(0, &segment));
+    CHECK(profile_start(0));
+    CHECK(plan_update_pending());       // The lower decimation is scheduled, profile_start() does not wait for it
+
+    isrCalls = sim_isr_calls();
+    periods = sim_periods();
+    sim_run_seconds(0.3);
+    CHECK(liveWaveformPlan.interruptDivisor == 1);
+    CHECK(sim_isr_calls() - isrCalls + 3 >= sim_periods() - periods);
+
+    sim_run_seconds(1.0);
+    printf("%lu periods, worst amplitude error %g counts\n", (unsigned long) checkedPeriods, worstAmplitudeError);
+    CHECK(profileState == PROFILE_IDLE);
+    CHECK(checkedPeriods > 10000);
+    CHECK(worstAmplitudeError <= DECIMATION_MAX_ERROR + 2);
+
+    return check_result();
+}
@@ -0,0 +1,144 @@
+/*
+ * test_protocol.c
+ *
+ *  Binary protocol next to the ASCII interface: a reply requested while the TX ring buffer is full of
+ *  ASCII text goes out complete, a frame whose rest never comes is dropped so ASCII works again, and a
+ *  binary parameter change cancels a pending ASCII confirmation instead of being overwritten by it.
+ *  Commands that need the running plan answer busy while a scheduled update is pending instead of waiting.
+ */
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+#include "protocol.h"
+#include "sci.h"
+
+// Sends a frame with the given opcode and payload, adds the CRC
+static void send_frame(Uint16 opcode, const char *payload, Uint16 length)
+{
+    char frame[PROTOCOL_MAX_FRAME];
+    Uint16 crc = 0xFFFF, i;
+
+    frame[0] = (char) PROTOCOL_SYNC;
+    frame[1] = length;
+    frame[2] = opcode;
+    memcpy(&frame[3], payload, length);
+    for (i = 1; i < length + 3; i++)
+    {
+        crc = crc16_update(crc, (unsigned char) frame[i]);
+    }
+    frame[length + 3] = crc >> 8;
+    frame[length + 4] = crc & 0xFF;
+    sim_sci_send(frame, length + 5);
+}
+
+/*
+ * Finds the first complete reply frame to the request opcode in the SCI output with a valid CRC.
+ * Returns its payload length (request opcode included) and points payload at it, -1 if there is none.
+ */
+static int find_reply(Uint16 reply, Uint16 request, const unsigned char **payload)
+{
+    Uint32 count, i;
+    const unsigned char *output = (const unsigned char *) sim_sci_output(&count);
+
+    for (i = 0; i + 5 <= count; i++)
+    {
+        Uint16 length = output[i + 1], crc = 0xFFFF, k;
+        if (output[i] != PROTOCOL_SYNC || output[i + 2] != reply || i + 5 + length > count
+                || length == 0 || output[i + 3] != request)
+        {
+            continue;
+        }
+        for (k = 1; k < length + 3; k++)
+        {
+            crc = crc16_update(crc, output[i + k]);
+        }
+        if (output[i + length + 3] == (crc >> 8) && output[i + length + 4] == (crc & 0xFF))
+        {
+            *payload = &output[i + 3];
+            return length;
+        }
+    }
+    return -1;
+}
+
+int main(void)
+{
+    const unsigned char *payload;
+    char setSinFreq[6] = { PARAM_SIN_FREQ, 0 };
+    char scheduleSinFreq[12] = { PLAN_APPLY_AT_CYCLE, 0 };
+    float sinFreq = 30;
+    Uint32 cycle;
+    int length;
+
+    sim_boot();
+    sim_run_seconds(1.5);
+    sim_sci_send_string("P 5000, S 50");
+    sim_run_seconds(0.3);
+    sim_sci_send_string("Y");
+    sim_run_seconds(2.0);
+
+    // Two rejected commands fill the TX ring buffer with welcome screens, GET_PARAMS waits for room for its reply
+    sim_sci_output_clear();
+    sim_sci_send("Q\0Q\0", 4);
+    sim_run_seconds(0.01);
+    CHECK(scia_tx_free() < PROTOCOL_MAX_FRAME);
+    send_frame(OPCODE_GET_PARAMS, "", 0);
+    sim_run_seconds(0.01);
+    CHECK(protocol_reply_pending());
+    sim_run_seconds(5.0);
+    length = find_reply(OPCODE_ACK, OPCODE_GET_PARAMS, &payload);
+    CHECK(length == 1 + 4 * PARAM_COUNT);
+
+    // A frame cut short after its length byte, the next line is an ASCII command again
+    sim_sci_output_clear();
+    sim_sci_send("\xA5\x05\x01", 3);
+    sim_run_seconds(0.5);
+    CHECK(!protocol_busy());
+    sim_sci_send_string("M .5");
+    sim_run_seconds(0.3);
+    CHECK(strstr(sim_sci_output(0), "PLEASE CONFIRM") != 0);
+    sim_sci_send_string("N");
+    sim_run_seconds(2.0);
+
+    // SET_PARAMS while the ASCII interface waits for Y/N: the confirmation is cancelled
+    sim_sci_output_clear();
+    sim_sci_send_string("S 40");
+    sim_run_seconds(0.3);
+    CHECK(strstr(sim_sci_output(0), "PLEASE CONFIRM") != 0);
+    memcpy(&setSinFreq[2], &sinFreq, 4);
+    send_frame(OPCODE_SET_PARAMS, setSinFreq, 6);
+    sim_run_seconds(0.5);
+    CHECK(find_reply(OPCODE_ACK, OPCODE_SET_PARAMS, &payload) == 1);
+    CHECK(strstr(sim_sci_output(0), "confirmation cancelled") != 0);
+    sim_sci_send_string("Y");
+    sim_run_seconds(2.0);
+    CHECK(strstr(sim_sci_output(0), "Values confirmed") == 0);
+    CHECK(liveEpwmParams.sinWavFreq == 30);
+    CHECK(bufferEpwmParams.sinWavFreq == 30);
+
+    // An update scheduled two seconds ahead: GET_ACHIEVED and PROFILE_START answer busy, the loop keeps running
+    sim_sci_output_clear();
+    cycle = carrierCycleCount + 10000;
+    sinFreq = 35;
+    memcpy(&scheduleSinFreq[2], &cycle, 4);
+    memcpy(&scheduleSinFreq[6], setSinFreq, 2);
+    memcpy(&scheduleSinFreq[8], &sinFreq, 4);
+    send_frame(OPCODE_SCHEDULE_PARAMS, scheduleSinFreq, 12);
+    sim_run_seconds(0.1);
+    CHECK(find_reply(OPCODE_ACK, OPCODE_SCHEDULE_PARAMS, &payload) == 3);
+    send_frame(OPCODE_GET_ACHIEVED, "", 0);
+    send_frame(OPCODE_PROFILE_START, "\0\0", 2);
+    sim_run_seconds(0.1);
+    CHECK(find_reply(OPCODE_NACK, OPCODE_GET_ACHIEVED, &payload) == 2 && payload[1] == NACK_BUSY);
+    CHECK(find_reply(OPCODE_NACK, OPCODE_PROFILE_START, &payload) == 2 && payload[1] == NACK_BUSY);
+    CHECK(plan_update_pending());
+    sim_run_seconds(2.5);
+    CHECK(!plan_update_pending());
+    send_frame(OPCODE_GET_ACHIEVED, "", 0);
+    sim_run_seconds(0.1);
+    CHECK(find_reply(OPCODE_ACK, OPCODE_GET_ACHIEVED, &payload) == 15);
+    memcpy(&sinFreq, &payload[5], 4);
+    CHECK_NEAR(sinFreq, 35, .01);
+
+    return check_result();
+}
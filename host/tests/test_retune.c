@@ -0,0 +1,152 @@
+/*
+ * test_retune.c
+ *
+ *  Glitch free retune: parameter updates arrive while the outputs run (a sine frequency change, a period
+ *  change, a prescaler change and updates while the ISR decimates) and the CMPA sequence must carry on
+ *  without a jump. Every period the phase and amplitude are recovered from the loaded compares of the
+ *  three channels (120 degrees apart): the amplitude must stay at the modulation depth and the phase
+ *  must advance by the old or the new step, never by anything else. The carrier cycle count has to follow
+ *  the counter zeros throughout. Built with DMA_TABLE_MODE (test_retune_dma_table) the DMA streams the
+ *  ratios that fit a table, the handovers in both directions must not show either.
+ */
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+
+#define DEPTH 0.9
+
+// Phase step per period before and after the update in progress, radians
+static double oldStep, newStep;
+static double lastPhase;
+static Uint16 havePhase;
+static Uint32 checkedPeriods, phaseErrors, amplitudeErrors, cycleErrors;
+#ifdef DMA_TABLE_MODE
+static Uint32 tableRetunes;     // Retunes the DMA took over
+#endif
+static double worstPhaseError, worstAmplitudeError;
+
+// Achieved carrier frequency of a PWM frequency, the phase step follows from it
+static double carrier_freq(double pwmFreq)
+{
+    EPwmParams params = liveEpwmParams;
+    WaveformPlan plan;
+
+    params.pwmWavFreq = pwmFreq;
+    compile_waveform_plan(&params, &plan);
+    return plan.carrierFreq;
+}
+
+static void period_hook(const SimPeriod *period)
+{
+    double duty[HAL_EPWM_CHANNELS], alpha, beta, phase, amplitude, step, error;
+    Uint16 ch;
+
+    if (period->period < 2 || period->timerPeriod == 0)
+    {
+        return;     // The first compares are the 0 of Init_Epwmm()
+    }
+
+    // compare = (1 - duty) * TBPRD, duty = .5 + .5 * depth * sin(phase + lead)
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        duty[ch] = (2.0 * (1.0 - (double) period->compare[ch] / period->timerPeriod) - 1.0) / DEPTH;
+    }
+    alpha = duty[0];
+    beta = (duty[1] - duty[2]) / sqrt(3.0);
+    amplitude = sqrt(alpha * alpha + beta * beta);
+    phase = atan2(alpha, beta);
+
+    // Compares are truncated to whole counts, plus the interpolation error of a decimated ISR
+    error = fabs(amplitude - 1.0);
+    if (error > worstAmplitudeError) worstAmplitudeError = error;
+    if (error > 6.0 / (DEPTH * period->timerPeriod))
+    {
+        amplitudeErrors++;
+    }
+
+    if (havePhase)
+    {
+        step = fabs(remainder(phase - lastPhase, 2 * M_PI));
+        error = fmin(fabs(step - oldStep), fabs(step - newStep));
+        if (error > worstPhaseError) worstPhaseError = error;
+        if (error > 12.0 / (DEPTH * period->timerPeriod))
+        {
+            phaseErrors++;
+            fprintf(stderr, "period %lu: phase step %g, expected %g or %g\n", (unsigned long) period->period, step,
+                    oldStep, newStep);
+        }
+    }
+    lastPhase = phase;
+    havePhase = 1;
+    checkedPeriods++;
+}
+
+// Carrier cycles the firmware has counted, the ISR does not count while the DMA streams the tables
+static Uint32 cycle_count(void)
+{
+#ifdef DMA_TABLE_MODE
+    if (dmaTableModeActive)
+    {
+        return dma_table_cycle_count();
+    }
+#endif
+    return carrierCycleCount;
+}
+
+// Sends a command, confirms it and lets the new values run for a while
+static void retune(const char *command, double pwmFreq, double sinFreq)
+{
+    newStep = 2 * M_PI * sinFreq / carrier_freq(pwmFreq);
+    sim_sci_send_string(command);
+    sim_run_seconds(0.3);
+    sim_sci_send_string("Y");
+    sim_run_seconds(1.5);
+    oldStep = newStep;
+
+#ifdef DMA_TABLE_MODE
+    tableRetunes += dmaTableModeActive;
+#endif
+    if (cycle_count() != sim_periods())
+    {
+        cycleErrors++;
+        fprintf(stderr, "%s: cycle count %lu after %lu periods\n", command, (unsigned long) cycle_count(),
+                (unsigned long) sim_periods());
+    }
+}
+
+int main(void)
+{
+    Uint32 isrCalls, periods;
+
+    sim_boot();
+    sim_run_seconds(1.5);
+
+    // Start the outputs, the first plan is not a retune
+    retune("P 5000, S 50, M .9", 5000, 50);
+    sim_set_period_hook(period_hook);
+    sim_log_enable(0);
+
+    retune("S 73.3", 5000, 73.3);                       // Sine frequency
+    retune("P 7000", 7000, 73.3);                       // Period, same prescaler
+    retune("P 300", 300, 73.3);                         // Prescaler change
+    retune("P 2500, S 12", 2500, 12);                   // Back to the undivided clock
+    retune("P 20000, S 10", 20000, 10);                 // Into decimation (ISR every 3rd period)
+    retune("S 20", 20000, 20);                          // While decimating
+    isrCalls = sim_isr_calls();
+    periods = sim_periods();
+    sim_run_seconds(0.1);
+    CHECK(3 * (sim_isr_calls() - isrCalls) <= sim_periods() - periods + 3);
+    retune("P 5000, S 50", 5000, 50);                   // Out of decimation
+
+    printf("%lu periods, worst phase error %g rad, worst amplitude error %g\n", (unsigned long) checkedPeriods,
+           worstPhaseError, worstAmplitudeError);
+    CHECK(checkedPeriods > 50000);
+    CHECK(phaseErrors == 0);
+    CHECK(amplitudeErrors == 0);
+    CHECK(cycleErrors == 0);
+#ifdef DMA_TABLE_MODE
+    CHECK(tableRetunes == 3);          // P 20000, S 10 / S 20 / P 5000, S 50
+#endif
+
+    return check_result();
+}
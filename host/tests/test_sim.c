@@ -0,0 +1,71 @@
+/*
+ * test_sim.c
+ *
+ *  Smoke test of the host simulator: boots the firmware, starts the outputs with an ASCII command and
+ *  checks the carrier, the sine frequency and the ISR rate in the CMPA log.
+ */
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+
+// Falling crossings of channel 1's compare through mid period (rising duty) within the log
+static Uint32 count_crossings(const SimPeriod *periods, Uint32 count)
+{
+    Uint32 i, crossings = 0;
+
+    for (i = 1; i < count; i++)
+    {
+        Uint16 mid = periods[i].timerPeriod / 2;
+        if (periods[i - 1].compare[0] >= mid && periods[i].compare[0] < mid)
+        {
+            crossings++;
+        }
+    }
+    return crossings;
+}
+
+int main(void)
+{
+    const SimPeriod *periods;
+    Uint32 count, writeCount, isrCalls, i;
+    Uint16 minimum = 0xFFFF, maximum = 0;
+
+    sim_boot();
+    sim_run_seconds(1.5);
+    CHECK(strstr(sim_sci_output(0), "P = PWM frequency (in Hz, ACCEPTABLE INPUTS: 10 - 100000)") != 0);
+    CHECK(strstr(sim_sci_output(0), "ACCEPTABLE INPUTS: 0 - 300, below half the PWM frequency") != 0);
+    CHECK(strstr(sim_sci_output(0), "up to 1.154 in modulation mode 1 or 2") != 0);
+    CHECK(strstr(sim_sci_output(0), "+-(1 - M) / 2, +-(1 - M * 0.866) / 2 in modulation mode 1 or 2") != 0);
+    CHECK(sim_periods() == 0);      // The outputs wait for the first confirmed command
+
+    sim_sci_output_clear();
+    sim_sci_send_string("P 5000, S 50");
+    sim_run_seconds(0.1);
+    CHECK(strstr(sim_sci_output(0), "PLEASE CONFIRM") != 0);
+    sim_sci_send_string("Y");
+    sim_run_seconds(0.5);
+    CHECK(sim_periods() > 0);
+
+    // One second of steady output
+    sim_log_clear();
+    isrCalls = sim_isr_calls();
+    sim_run_seconds(1.0);
+    periods = sim_cmpa_periods(&count);
+    sim_cmpa_writes(&writeCount);
+
+    CHECK_NEAR(count, 5000, 2);
+    CHECK_NEAR(count_crossings(periods, count), 50, 1);
+    for (i = 0; i < count; i++)
+    {
+        CHECK(periods[i].timerPeriod == 9000 && periods[i].clockPrescale == 1);
+        if (periods[i].compare[0] < minimum) minimum = periods[i].compare[0];
+        if (periods[i].compare[0] > maximum) maximum = periods[i].compare[0];
+    }
+    CHECK(minimum < 100 && maximum > 8900);     // Full modulation depth
+
+    // Every period's compares come from the ISR or, while it decimates, from the DMA
+    CHECK_NEAR(writeCount, HAL_EPWM_CHANNELS * count, 2 * HAL_EPWM_CHANNELS);
+    CHECK(sim_isr_calls() - isrCalls <= count + 1);
+
+    return check_result();
+}
@@ -0,0 +1,144 @@
+/*
+ * test_telemetry.c
+ *
+ *  Telemetry stream across parameter updates: the records queue up faster than the serial port sends
+ *  them while the sine frequency changes every 30 ms, so records of a sequence are still waiting when
+ *  the outputs run a newer one. Every record has to follow the parameter frame of its own sequence, and
+ *  that frame has to carry the sine frequency the record's tuning word produces; records whose
+ *  parameters are gone are dropped instead.
+ */
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+#include "protocol.h"
+
+#define UPDATES 12
+
+// Sends a frame with the given opcode and payload, adds the CRC
+static void send_frame(Uint16 opcode, const char *payload, Uint16 length)
+{
+    char frame[PROTOCOL_MAX_FRAME];
+    Uint16 crc = 0xFFFF, i;
+
+    frame[0] = (char) PROTOCOL_SYNC;
+    frame[1] = length;
+    frame[2] = opcode;
+    memcpy(&frame[3], payload, length);
+    for (i = 1; i < length + 3; i++)
+    {
+        crc = crc16_update(crc, (unsigned char) frame[i]);
+    }
+    frame[length + 3] = crc >> 8;
+    frame[length + 4] = crc & 0xFF;
+    sim_sci_send(frame, length + 5);
+}
+
+static Uint16 get_u16(const unsigned char *bytes)
+{
+    return bytes[0] | (bytes[1] << 8);
+}
+
+static Uint32 get_u32(const unsigned char *bytes)
+{
+    return get_u16(bytes) | ((Uint32) get_u16(bytes + 2) << 16);
+}
+
+static float get_float(const unsigned char *bytes)
+{
+    Uint32 bits = get_u32(bytes);
+    float value;
+    memcpy(&value, &bits, 4);
+    return value;
+}
+
+int main(void)
+{
+    char setSinFreq[6] = { PARAM_SIN_FREQ, 0 };
+    char periods[2] = { 1, 0 };
+    const unsigned char *output;
+    Uint32 count, i, records = 0, paramFrames = 0, dropped = 0, mismatches = 0;
+    Uint16 haveParams = 0, paramsSequence = 0;
+    float paramsCarrier = 0, paramsSine = 0;
+    Uint16 k;
+
+    sim_boot();
+    sim_run_seconds(1.5);
+    sim_sci_send_string("P 5000, S 50");
+    sim_run_seconds(0.3);
+    sim_sci_send_string("Y");
+    sim_run_seconds(2.0);
+
+    // A record every period, far more than the port sends, and a new sine frequency every 30 ms
+    sim_sci_output_clear();
+    send_frame(OPCODE_TELEMETRY, periods, 2);
+    sim_run_seconds(0.01);
+    for (k = 0; k < UPDATES; k++)
+    {
+        float sinFreq = 30 + k;
+        memcpy(&setSinFreq[2], &sinFreq, 4);
+        send_frame(OPCODE_SET_PARAMS, setSinFreq, 6);
+        sim_run_seconds(0.03);
+    }
+    sim_run_seconds(3.0);
+    periods[0] = 0;
+    send_frame(OPCODE_TELEMETRY, periods, 2);
+    sim_run_seconds(0.5);
+
+    // Walk the telemetry frames with a valid CRC
+    output = (const unsigned char *) sim_sci_output(&count);
+    for (i = 0; i + 5 <= count; i++)
+    {
+        Uint16 length = output[i + 1], opcode = output[i + 2], crc = 0xFFFF;
+        const unsigned char *payload = &output[i + 3];
+
+        if (output[i] != PROTOCOL_SYNC || i + 5 + length > count
+                || (opcode != OPCODE_TELEMETRY_PARAMS && opcode != OPCODE_TELEMETRY_SAMPLE))
+        {
+            continue;
+        }
+        for (k = 1; k < length + 3; k++)
+        {
+            crc = crc16_update(crc, output[i + k]);
+        }
+        if (output[i + length + 3] != (crc >> 8) || output[i + length + 4] != (crc & 0xFF))
+        {
+            continue;
+        }
+
+        if (opcode == OPCODE_TELEMETRY_PARAMS)
+        {
+            paramsSequence = get_u16(payload);
+            paramsCarrier = get_float(payload + 2);
+            paramsSine = get_float(payload + 6);
+            haveParams = 1;
+            paramFrames++;
+        }
+        else
+        {
+            Uint32 tuningWord = get_u32(payload + 8);
+            Uint16 sequence = get_u16(payload + 12);
+            double sine = tuningWord / 4294967296.0 * paramsCarrier;
+
+            if (!haveParams || sequence != paramsSequence || fabs(sine - paramsSine) > 1e-3)
+            {
+                if (mismatches++ < 5)
+                {
+                    fprintf(stderr, "record of sequence %u at %g Hz after parameters of sequence %u at %g Hz\n",
+                            sequence, sine, paramsSequence, paramsSine);
+                }
+            }
+            dropped += get_u16(payload + 14);
+            records++;
+        }
+        i += length + 4;
+    }
+
+    printf("%lu records, %lu parameter frames, %lu records dropped\n", (unsigned long) records,
+           (unsigned long) paramFrames, (unsigned long) dropped);
+    CHECK(records > 60);
+    CHECK(paramFrames >= 2);
+    CHECK(dropped > 0);
+    CHECK(mismatches == 0);
+
+    return check_result();
+}
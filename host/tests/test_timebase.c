@@ -0,0 +1,53 @@
+/*
+ * test_timebase.c
+ *
+ *  Time base planner and the Nyquist limit: over the PWM frequency range the plan takes the smallest
+ *  TBCLK prescaler TBPRD fits with (the finest duty resolution), the carrier error stays within half a
+ *  count, and a sine frequency at or above half the PWM frequency is rejected by params_valid() and
+ *  by the ASCII parser.
+ */
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+
+int main(void)
+{
+    EPwmParams params;
+    WaveformPlan plan;
+    CommandParser parser;
+    const char *command = "P 100, S 50";
+    double freq;
+    Uint16 result = COMMAND_PENDING;
+
+    memset(&params, 0, sizeof(params));
+    init_phase_leads(&params);
+    params.sinWavFreq = 1;
+    params.modulation_depth = .5;
+    params.waveform = WAVEFORM_SINE;
+
+    for (freq = PWMWAVFREQ_MIN; freq <= PWMWAVFREQ_MAX; freq *= 1.01)
+    {
+        params.pwmWavFreq = freq;
+        compile_waveform_plan(&params, &plan);
+        CHECK(plan.timerPeriod >= 450);
+        // A larger prescaler only when the period does not fit TBPRD with a smaller one
+        CHECK(plan.clockPrescale == 1 || plan.timerPeriod >= TBPRD_MAX / 4);
+        CHECK(fabs(plan.carrierFreq - freq) <= 0.6 * freq / plan.timerPeriod);
+    }
+
+    // Nyquist: the sine has to stay below half the carrier
+    params.pwmWavFreq = 100;
+    params.sinWavFreq = 49.9;
+    CHECK(params_valid(&params));
+    params.sinWavFreq = 50;
+    CHECK(!params_valid(&params));
+
+    command_parser_reset(&parser, &params);
+    do
+    {
+        result = command_parser_feed(&parser, *command);
+    } while (*command++ && result == COMMAND_PENDING);
+    CHECK(result == COMMAND_INVALID && parser.error == COMMAND_ERROR_NYQUIST);
+
+    return check_result();
+}
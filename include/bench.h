@@ -0,0 +1,34 @@
+/*
+ * bench.h
+ *
+ *  Waveform kernel benchmark, built only with KERNEL_BENCHMARK defined.
+ *  Times each sine kernel (sinf, nearest table entry, interpolated table in float and in Q15 integer math,
+ *  several table sizes)
+ *  in SYSCLKOUT cycles (hal_benchmark_ticks(), CPU timer 0) and measures the distortion of the CMPA stream
+ *  it generates across the PWMWAVFREQ x SINWAVFREQ grid. Results are sent over SCI A as CSV lines starting
+ *  with "BENCH,". The host build (host/benchmark.c) runs the same code and times it in host ns.
+ *  The three phase kernels (sinf x3, table x3 in float and Q15, sine / cosine rotation, incremental rotation) are timed
+ *  per sample of all three channels and checked against sinf, lines start with "BENCH3,".
+ */
+#include "DSP28x_Project.h"
+#include "pwm.h"
+
+#ifndef BENCH_H
+#define BENCH_H
+
+// Uncomment to run the kernel benchmark at boot, before the welcome screen
+//#define KERNEL_BENCHMARK
+
+#define BENCH_TABLE_BITS_MAX 11         // Largest table size benchmarked (2^11 entries)
+#define BENCH_TIMING_SAMPLES 1000       // Samples timed per kernel
+#define BENCH_HARMONICS 10              // THD and SFDR use harmonics 2..BENCH_HARMONICS
+#define BENCH_MIN_SAMPLES 2000          // Minimum CMPA samples analyzed per grid point
+#define BENCH_MIN_PERIODS 4             // Minimum sine periods analyzed, the Hann window leaks into harmonic 2 below that
+#define BENCH_THREE_PHASE_SAMPLES 20000 // Samples of each three phase kernel checked against sinf
+#define BENCH_THREE_PHASE_PWM 10000     // Carrier and sine frequency the three phase kernels step the phase for
+#define BENCH_THREE_PHASE_SIN 60
+
+// Function prototypes
+void kernel_benchmark_run(void);        // Runs every kernel over the grid and prints the results
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * cla_shared.h
+ *
+ *  Optional CLA offload, built only with CLA_OFFLOAD defined.
+ *  The ePWM1 interrupt (counter zero) triggers CLA task 1 instead of the C28x ISR. The task calculates
+ *  the compares of every channel with the same compare_values() kernel as the ISR (pwm.h, dds.h) and
+ *  writes them to the ePWM modules, so the C28x only runs the serial protocol, profiles and instrumentation.
+ *  The plan reaches the CLA as a WaveformPlan in the CPU to CLA message RAM, the CLA reports its phase
+ *  and carrier cycle count back through the CLA to CPU message RAM.
+ *
+ *  Like the DMA tables (pwm_dma.h) the CLA only takes plans it can run: the sine table is in CLA data RAM
+ *  (RAML1), uploaded waveform tables are not, and HRPWM_MODE, running profiles and scheduled updates stay
+ *  on the ISR. Every plan change goes through the ISR: it takes the outputs back, switches to the new plan
+ *  and hands its phase to the CLA again at a counter zero, so the sine stays continuous.
+ *  The ePWM registers then stay on peripheral frame 1, which the DMA cannot reach: no DMA_TABLE_MODE and no
+ *  ISR decimation with CLA_OFFLOAD.
+ *
+ *  Building: also pass --define=CLA_OFFLOAD to the linker (F28069M.cmd maps the CLA memory with it), and
+ *  keep optimization on for the .cla file so the static inline kernels are inlined into the task.
+ */
+#include "DSP28x_Project.h"
+#include "pwm.h"
+
+#ifndef CLA_SHARED_H
+#define CLA_SHARED_H
+
+// Uncomment to let the CLA write the compare values
+//#define CLA_OFFLOAD
+
+#ifdef CLA_OFFLOAD
+
+// CPU to CLA message RAM, written by the CPU only while CLA task 1 is stopped
+typedef struct
+{
+    WaveformPlan plan;                          // Plan the CLA runs
+    Uint32 phase;                               // Phase word of the first compare the CLA writes
+    Uint32 cycleCount;                          // carrierCycleCount at the handover
+    Uint16 epwmAddress[HAL_EPWM_CHANNELS];      // Register block of each channel (CLA pointers are 16 bits)
+} ClaCommand;
+
+// CLA to CPU message RAM, written by the CLA after every task
+typedef struct
+{
+    Uint32 phase;                               // Phase word of the next compare
+    Uint32 cycleCount;                          // Carrier cycles (counter zeros) so far, continues carrierCycleCount
+} ClaStatus;
+
+extern ClaCommand claCommand;
+extern ClaStatus claStatus;
+
+// CLA tasks (cla_tasks.cla)
+__interrupt void Cla1Task1(void);               // ePWM1 counter zero: writes the compares of every channel
+__interrupt void Cla1Task8(void);               // Forced by the CPU: takes over the phase and cycle count
+
+#ifndef __TMS320C28XX_CLA__
+
+// CLA program and constants load and run addresses (F28069M.cmd)
+extern Uint16 Cla1funcsLoadStart;
+extern Uint16 Cla1funcsLoadSize;
+extern Uint16 Cla1funcsRunStart;
+extern Uint16 Cla1ConstLoadStart;
+extern Uint16 Cla1ConstLoadSize;
+extern Uint16 Cla1ConstRunStart;
+
+extern Uint16 claActive;
+extern volatile Uint16 claStartPending;
+extern Uint16 claResumePending;
+extern Uint32 claResumePhase;
+
+// Function prototypes
+void cla_init(void);                            // Loads the CLA program and maps its memory, call before the ePWM interrupt is enabled
+Uint16 cla_params_supported(const EPwmParams *params); // Returns 1 if the CLA can run the parameters
+void cla_start(void);                           // Hands the outputs from the ISR to the CLA at the next ISR call
+void cla_stop(void);                            // Stops the CLA, the ISR carries on from its phase
+void cla_take_over(Uint32 phase, Uint32 cycleCount); // Called from the ISR, the CLA writes the compares from the next counter zero
+
+#endif
+
+#endif
+
+#endif
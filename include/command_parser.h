@@ -0,0 +1,63 @@
+/*
+ * command_parser.h
+ *
+ *  Streaming parser for the ASCII parameter commands ("P 2500, S 60,M .13, A2 120").
+ *  Fed one character at a time as it arrives: numbers are accumulated as fixed point (integer mantissa
+ *  and decimal places, no atof() and no line buffer), every character is checked the moment it arrives
+ *  and each value is range checked as soon as it is complete. When the terminator arrives the parameter
+ *  set is already complete and validated. Uses no hardware: the host build (host/) compiles it into the
+ *  firmware library, where host/tests/test_command_parser.c fuzzes it and measures its throughput.
+ */
+#include "DSP28x_Project.h"
+#include "pwm.h"
+
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#define COMMAND_TERMINATOR '\0'
+#define COMMAND_MAX_DIGITS 9            // Digits per number, 10^9 still fits the Uint32 mantissa
+
+// Results of command_parser_feed()
+#define COMMAND_PENDING 0               // Keep feeding
+#define COMMAND_FAILED 1                // This character made the command invalid, see parser->error
+#define COMMAND_VALID 2                 // Terminator, parser->params holds the validated parameter set
+#define COMMAND_INVALID 3               // Terminator of a command that has failed
+
+// Errors, see command_parser_error_message()
+#define COMMAND_ERROR_NONE 0
+#define COMMAND_ERROR_CHARACTER 1       // Character not allowed at this point
+#define COMMAND_ERROR_CHANNEL 2         // A not followed by a channel number
+#define COMMAND_ERROR_NO_VALUE 3        // Parameter letter without a number
+#define COMMAND_ERROR_DIGITS 4          // Number has too many digits
+#define COMMAND_ERROR_DECIMAL_POINTS 5  // Number has more than one decimal point
+#define COMMAND_ERROR_RANGE 6           // Value out of bound
+#define COMMAND_ERROR_DEPTH 7           // Modulation depth out of range for the modulation mode
+#define COMMAND_ERROR_OFFSET 8          // Offset out of range for the modulation depth
+#define COMMAND_ERROR_EMPTY 9           // Terminator without a parameter
+#define COMMAND_ERROR_NYQUIST 10        // Sine frequency not below half the PWM frequency
+#define COMMAND_ERROR_NOT_INTEGER 11    // Decimal point in a value that has to be a whole number (V)
+
+typedef struct
+{
+    Uint16 state;               // Parser state, see command_parser.c
+    float *field;               // Parameter the number being read goes to
+    float min;                  // Range of that parameter
+    float max;
+    Uint16 negative;            // Number has a minus sign
+    Uint32 mantissa;            // Digits read so far as an integer
+    Uint16 digits;              // Digits in the mantissa
+    Uint16 decimals;            // Digits after the decimal point, 0xFFFF before the point
+    float mode;                 // Modulation mode as read, copied to params once in range
+    Uint16 values;              // Parameters the command has set so far
+    Uint16 error;               // COMMAND_ERROR_ of the failed command
+    char errorChar;             // Character the command failed at, the terminator for errors found at the end
+    EPwmParams params;          // Parameter set being built, starts as a copy of the given parameters
+} CommandParser;
+
+// Function prototypes
+void command_parser_reset(CommandParser *parser, const EPwmParams *params); // Starts a new command on top of params
+Uint16 command_parser_feed(CommandParser *parser, char c);  // Parses one character, returns COMMAND_PENDING, _FAILED, _VALID or _INVALID
+Uint16 command_parser_idle(const CommandParser *parser);    // Returns 1 if no character of a command has been fed yet
+const char *command_parser_error_message(Uint16 error);     // Text for a COMMAND_ERROR_ code
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * config_store.h
+ *
+ *  Saved configuration, built only with CONFIG_STORE defined.
+ *  Every confirmed parameter set (key CONFIG_KEY_LIVE) and every stored preset slot (CONFIG_KEY_PRESET())
+ *  is appended as a CRC checked record to the flash sectors G and H, which nothing else uses. Records fill
+ *  one sector slot by slot; when it is full the newest record of every key is carried over to the other
+ *  sector, erased at boot, and the full one is erased at the next boot, before the outputs start.
+ *  At boot the valid record with the highest sequence number of each key is loaded, the outputs start with
+ *  the live one. A record cut short by a power loss fails its CRC and is skipped, the one before it stays
+ *  in place, and an interrupted erase leaves a sector that is erased again at the next boot.
+ *
+ *  Flash erase and program must not run code or read data from flash. The PWM and DMA table ISRs run from
+ *  RAM with their data in RAM, so they keep running while a record is programmed (about 1 ms); the other
+ *  interrupts wait until it is done. A sector erase takes far longer, so it only runs at boot: once both
+ *  sectors have filled up since the last boot (2 * CONFIG_SLOTS saves), further saves are skipped until the
+ *  next one. The live parameters are saved once they have stayed unchanged for CONFIG_SAVE_SETTLE, so a
+ *  profile ramp or a host stepping the frequency does not wear the flash with every step.
+ *
+ *  Building: add the F2806x Flash API (Flash2806x_API_V100.lib and its include folder from C2000Ware) to
+ *  the project, set CPU_RATE to 11.111L (90 MHz) in Flash2806x_API_Config.h and pass --define=CONFIG_STORE
+ *  to the linker (F28069M.cmd runs the Flash API from RAMM1 with it).
+ *  The host build replaces the Flash API and the sectors with an emulator (host/flash_sim.c).
+ */
+#include "DSP28x_Project.h"
+#include "pwm.h"
+#include "preset.h"
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+// Uncomment to save confirmed parameters in flash and restore them at boot
+//#define CONFIG_STORE
+
+#define CONFIG_SECTOR_WORDS 0x4000          // Flash sectors G and H, see F28069M.cmd
+#ifdef HAL_HOST
+extern Uint16 simFlashSectorG[], simFlashSectorH[];
+#define CONFIG_SECTOR_G_START simFlashSectorG
+#define CONFIG_SECTOR_H_START simFlashSectorH
+#else
+#define CONFIG_SECTOR_G_START 0x3DC000
+#define CONFIG_SECTOR_H_START 0x3D8000
+#endif
+#define CONFIG_SLOT_WORDS 64                // One record per slot, fits up to 8 channels
+#define CONFIG_SLOTS (CONFIG_SECTOR_WORDS / CONFIG_SLOT_WORDS)
+#define CONFIG_RECORD_MAGIC 0xC5A2          // Changes with the record layout, older records are ignored then
+#define CONFIG_ERASED 0xFFFF                // Flash word after an erase
+
+#define CONFIG_KEY_LIVE 0                   // Last confirmed parameter set, started at boot
+#define CONFIG_KEY_PRESET(slot) (1 + (slot)) // Preset slots
+#define CONFIG_KEYS (1 + PRESET_SLOTS)
+
+#define CONFIG_SAVE_SETTLE 180000000        // SYSCLKOUT cycles (2 s) the live parameters stay unchanged before they are saved
+
+// config_status() bits, sent in the OPCODE_PLAN_STATUS reply
+#define CONFIG_STATUS_SAVE_PENDING 0x0001   // A confirmed change waits to be saved
+#define CONFIG_STATUS_SAVE_FAILED 0x0002    // The last save failed (both sectors full until the next boot, or programming failed)
+
+#ifdef CONFIG_STORE
+
+// Record as stored in a slot, the CRC16 (as protocol.h) covers every word before it, low byte first
+typedef struct
+{
+    Uint16 magic;               // CONFIG_RECORD_MAGIC
+    Uint16 length;              // CONFIG_RECORD_WORDS, guards against a changed EPwmParams layout
+    Uint16 key;                 // CONFIG_KEY_LIVE or CONFIG_KEY_PRESET()
+    Uint32 sequence;            // Counts the saves, the highest valid one of a key is its current parameters
+    EPwmParams params;          // Confirmed parameters
+    Uint16 crc;
+} ConfigRecord;
+
+#define CONFIG_RECORD_WORDS (sizeof(ConfigRecord) / sizeof(Uint16))
+
+// Function prototypes
+void config_init(void);                         // Copies the Flash API to RAM and finds the saved records, call after hal_system_init()
+int config_get(Uint16 key, EPwmParams *params); // Loads the saved parameters of a key, returns 1 if a valid record was found
+int config_save(Uint16 key, const EPwmParams *params);  // Saves the parameters of a key now, returns 1 if saved or unchanged
+void config_request_save(void);                 // Saves the live parameters from the main loop once they are applied and settled
+void config_service(void);                      // Background save for the main loop
+Uint16 config_status(void);                     // CONFIG_STATUS_... bits
+Uint16 config_record_crc(const ConfigRecord *record); // CRC16 of a record's words before the CRC
+
+#endif
+
+#endif
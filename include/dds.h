@@ -0,0 +1,139 @@
+/*
+ * dds.h
+ *
+ *  Direct digital synthesis (DDS) of the sine wave: a 32-bit phase accumulator
+ *  indexes a Q15 sine lookup table with its top SINE_TABLE_BITS bits.
+ *  A full 2^32 phase word is one sine period, so the accumulator wraps exactly
+ *  and the output frequency does not drift.
+ */
+#include "DSP28x_Project.h"
+
+#ifndef DDS_H
+#define DDS_H
+
+#define SINE_TABLE_BITS 10                              // Table holds 2^SINE_TABLE_BITS samples of one sine period
+#define SINE_TABLE_SIZE (1 << SINE_TABLE_BITS)
+#define SINE_TABLE_MASK (SINE_TABLE_SIZE - 1)
+#define SINE_TABLE_SHIFT (32 - SINE_TABLE_BITS)         // Phase word shift that leaves the table index
+#define SINE_TABLE_AMPLITUDE 32767                      // Q15 full scale
+#define DDS_PHASE_FULL_SCALE 4294967296.0L              // 2^32, one full sine period in phase word units
+
+// Linearly interpolate between neighbouring table entries, comment out to use the nearest lower entry
+#define DDS_INTERPOLATE
+
+// Uncomment to evaluate a sine plan from one sine / cosine pair of the base phase, rotated by the precomputed
+// sine and cosine of each channel's phase lead (two multiply-adds per channel instead of a table sample)
+//#define DDS_ROTATION
+
+// Uncomment (with DDS_ROTATION) to let the ISR advance the pair by a fixed rotation each period instead of
+// reading it from the table, see dds_rotator_sine_cosine()
+//#define DDS_ROTATION_INCREMENTAL
+
+#ifdef DDS_ROTATION_INCREMENTAL
+#define DDS_ROTATION                                    // The incremental rotation builds on the rotation
+#endif
+
+#define DDS_QUARTER_PERIOD 0x40000000UL                 // 90 degrees as a phase word
+#define DDS_ROTATOR_RENORMALIZE 16                      // Rotations between magnitude corrections
+#define DDS_ROTATOR_RESYNC 256                          // Rotations before the pair is read from the table again
+
+// Sine / cosine pair advanced one rotation per call
+typedef struct
+{
+    Uint32 phase;               // Phase word of the pair
+    float sine;                 // Q15 scale, like dds_sample()
+    float cosine;
+    Uint16 count;               // Rotations since the pair was read from the table
+} DdsRotator;
+
+extern int16 sineTable[SINE_TABLE_SIZE];
+
+// Function prototypes
+void dds_init_sine_table(void);                         // Fills the sine lookup table, call once at boot
+Uint32 dds_tuning_word(float sinWavFreq, float pwmWavFreq); // Phase increment per ISR call (at pwmWavFreq calls per second) for the given sine frequency
+Uint32 dds_phase_word(float degrees);                   // Converts a phase angle in degrees to a phase word
+
+// ramfuncs is a C28x section, the CLA compiles these into its program RAM (cla_shared.h)
+
+/*
+ * Looks up the table sample (Q15 scale, +-SINE_TABLE_AMPLITUDE) at the given phase word.
+ * The table holds 2^(32 - shift) samples of one period, mask is its size - 1, so the sine table
+ * and user waveform tables (see waveform.h) take the same path at the same cost.
+ * Inlined into the ISR so the hot path has no call overhead, kept in RAM when it is not inlined.
+ */
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(dds_sample, "ramfuncs");
+#endif
+static inline float dds_sample(const int16 *table, Uint16 shift, Uint16 mask, Uint32 phase)
+{
+    Uint16 index = (Uint16) (phase >> shift);
+    float sample = (float) table[index];
+
+#ifdef DDS_INTERPOLATE
+    // Fraction between this entry and the next one, from the 16 bits below the index
+    float fraction = (float) ((Uint16) (phase >> (shift - 16))) * (1.0f / 65536.0f);
+    sample += ((float) table[(index + 1) & mask] - sample) * fraction;
+#endif
+
+    return sample;
+}
+
+// Sine of the given phase word, between -1 and 1
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(dds_sine, "ramfuncs");
+#endif
+static inline float dds_sine(Uint32 phase)
+{
+    return dds_sample(sineTable, SINE_TABLE_SHIFT, SINE_TABLE_MASK, phase) * (1.0f / SINE_TABLE_AMPLITUDE);
+}
+
+// Sine and cosine of the given phase word from the sine table, Q15 scale
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(dds_sine_cosine, "ramfuncs");
+#endif
+static inline void dds_sine_cosine(Uint32 phase, float *sine, float *cosine)
+{
+    *sine = dds_sample(sineTable, SINE_TABLE_SHIFT, SINE_TABLE_MASK, phase);
+    *cosine = dds_sample(sineTable, SINE_TABLE_SHIFT, SINE_TABLE_MASK, phase + DDS_QUARTER_PERIOD);
+}
+
+/*
+ * Sine and cosine of the given phase word (Q15 scale). When phase is exactly step past the previous call,
+ * the pair is rotated by stepSine / stepCosine (sine and cosine of step, unit scale), four multiply-adds.
+ * Float rounding grows the magnitude and phase error with each rotation, so every DDS_ROTATOR_RENORMALIZE
+ * rotations the magnitude is pulled back to SINE_TABLE_AMPLITUDE (one Newton step) and every
+ * DDS_ROTATOR_RESYNC rotations, or on any other phase, the pair is read from the table again.
+ */
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(dds_rotator_sine_cosine, "ramfuncs");
+#endif
+static inline void dds_rotator_sine_cosine(DdsRotator *rotator, Uint32 phase, Uint32 step,
+                                           float stepSine, float stepCosine, float *sine, float *cosine)
+{
+    if (phase - rotator->phase == step && rotator->count < DDS_ROTATOR_RESYNC)
+    {
+        float s = rotator->sine * stepCosine + rotator->cosine * stepSine;
+        float c = rotator->cosine * stepCosine - rotator->sine * stepSine;
+
+        if (++rotator->count % DDS_ROTATOR_RENORMALIZE == 0)
+        {
+            float gain = 1.5f - .5f * (s * s + c * c)
+                    * (1.0f / ((float) SINE_TABLE_AMPLITUDE * SINE_TABLE_AMPLITUDE));
+            s *= gain;
+            c *= gain;
+        }
+        rotator->sine = s;
+        rotator->cosine = c;
+    }
+    else
+    {
+        dds_sine_cosine(phase, &rotator->sine, &rotator->cosine);
+        rotator->count = 0;
+    }
+
+    rotator->phase = phase;
+    *sine = rotator->sine;
+    *cosine = rotator->cosine;
+}
+
+#endif
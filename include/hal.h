@@ -0,0 +1,284 @@
+/*
+ * hal.h
+ *
+ *  Thin hardware abstraction layer for the register accesses the firmware makes while running
+ *  (ISRs, SCI ring buffers) and for the system start up. The functions below map straight onto
+ *  the F2806x register structs and inline to the same code as a direct register access.
+ *  Peripheral configuration (Init_Epwmm(), dma_init()) still writes the registers directly.
+ *  The host build (HAL_HOST, see host/) declares the same functions and implements them on the
+ *  simulated registers of host/sim.c, so the firmware runs unchanged against a simulated ePWM and SCI.
+ */
+#include "DSP28x_Project.h"
+
+#ifndef HAL_H
+#define HAL_H
+
+#define HAL_EPWM_CHANNELS 3     // ePWM modules driven by the generator, one entry each in halEpwmChannels (hal.c)
+#define HAL_EPWM_GROUPS 1       // Channel groups, e.g. 2 for two independent three phase sets (six phase)
+
+/*
+ * Channel descriptor, one per ePWM module the generator drives (up to the eight of the F28069M).
+ * Index 0 has to be ePWM1: its interrupt and SOCA pace all channels, the DMA modes need ePWM1-3 at index 0-2.
+ * Channels of a group are listed next to each other; a group is a three phase set that shares one common
+ * mode signal (see compare_counts()), groups of one or two channels (auxiliary outputs) get none.
+ */
+typedef struct
+{
+    volatile struct EPWM_REGS *regs;    // Register block of the module
+    void (*initGpio)(void);             // Muxes the module's output pins
+    Uint16 group;                       // 0 to HAL_EPWM_GROUPS - 1
+    float phaseLead;                    // Phase lead in degrees at power up
+} HalEpwmChannel;
+
+extern HalEpwmChannel halEpwmChannels[HAL_EPWM_CHANNELS];
+
+// Function prototypes
+void hal_system_init(void);     // Clocks, flash wait states, ramfuncs copy and GPIO muxing
+
+#ifdef HAL_HOST
+
+// Host build, the simulator implements these on its register model (see the target versions below)
+void hal_epwm_write_compare(Uint16 channel, Uint16 value);
+void hal_epwm_write_period(Uint16 channel, Uint16 value);
+void hal_epwm_write_prescaler(Uint16 channel, Uint16 hspClkDiv, Uint16 clkDiv);
+void hal_epwm_write_interrupt_divisor(Uint16 divisor);
+void hal_epwm_write_compare_hr(Uint16 channel, Uint32 value);
+void hal_epwm_write_period_hr(Uint16 channel, Uint32 value);
+void hal_epwm_ack_interrupt(void);
+void hal_dma_start(Uint16 channel, const Uint16 *source, Uint16 size);
+void hal_dma_halt(Uint16 channel);
+Uint16 hal_dma_transfer_position(Uint16 channel);
+void hal_dma_ack_interrupt(void);
+Uint16 hal_scia_rx_level(void);
+Uint16 hal_scia_read(void);
+Uint16 hal_scia_rx_overflowed(void);
+Uint16 hal_scia_tx_level(void);
+void hal_scia_write(Uint16 value);
+Uint16 hal_scia_tx_idle(void);
+void hal_scia_set_baud_register(Uint16 brr);
+void hal_scia_tx_interrupt_enable(Uint16 enable);
+void hal_scia_ack_rx_interrupt(void);
+void hal_scia_ack_tx_interrupt(void);
+Uint32 hal_cycle_count(void);   // Simulated SYSCLKOUT cycles
+void hal_busy_wait(void);       // Moves simulated time on to the next event
+
+// The kernel benchmark (bench.h) runs at host speed, timed with the monotonic clock in ns
+#define HAL_BENCHMARK_TICK_NS 1.0
+Uint32 hal_benchmark_ticks(void);
+
+#else
+
+// Called on every pass of a loop that waits for an interrupt, nothing to do on the target
+static inline void hal_busy_wait(void)
+{
+}
+
+// ePWM (cla_tasks.cla sees these through pwm.h, ramfuncs only applies to the C28x)
+
+// Writes the compare A shadow register of a channel, loads at the next counter zero
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(hal_epwm_write_compare, "ramfuncs");
+#endif
+static inline void hal_epwm_write_compare(Uint16 channel, Uint16 value)
+{
+    halEpwmChannels[channel].regs->CMPA.half.CMPA = value;
+}
+
+// Writes the period shadow register of a channel, loads at the next counter zero
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(hal_epwm_write_period, "ramfuncs");
+#endif
+static inline void hal_epwm_write_period(Uint16 channel, Uint16 value)
+{
+    halEpwmChannels[channel].regs->TBPRD = value;
+}
+
+// Switches the time base prescaler of a channel, TBCTL is not shadowed so it takes effect at once;
+// call right after the counter zero at which the period for the new prescaler has loaded
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(hal_epwm_write_prescaler, "ramfuncs");
+#endif
+static inline void hal_epwm_write_prescaler(Uint16 channel, Uint16 hspClkDiv, Uint16 clkDiv)
+{
+    volatile struct EPWM_REGS *regs = halEpwmChannels[channel].regs;
+
+    regs->TBCTL.bit.HSPCLKDIV = hspClkDiv;
+    regs->TBCTL.bit.CLKDIV = clkDiv;
+}
+
+// Sets how many PWM periods pass between ePWM1 interrupts (1 to 3)
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(hal_epwm_write_interrupt_divisor, "ramfuncs");
+#endif
+static inline void hal_epwm_write_interrupt_divisor(Uint16 divisor)
+{
+    EPwm1Regs.ETPS.bit.INTPRD = divisor;
+}
+
+// Writes CMPA:CMPAHR of a channel as 16.16 fixed point counts, high resolution compare (HRPWM_MODE)
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(hal_epwm_write_compare_hr, "ramfuncs");
+#endif
+static inline void hal_epwm_write_compare_hr(Uint16 channel, Uint32 value)
+{
+    halEpwmChannels[channel].regs->CMPA.all = value;
+}
+
+// Writes TBPRD:TBPRDHR of a channel as 16.16 fixed point counts through the mirror register (HRPWM_MODE)
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(hal_epwm_write_period_hr, "ramfuncs");
+#endif
+static inline void hal_epwm_write_period_hr(Uint16 channel, Uint32 value)
+{
+    halEpwmChannels[channel].regs->TBPRDM.all = value;
+}
+
+// Clears the ePWM1 interrupt flag and acknowledges PIE group 3
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(hal_epwm_ack_interrupt, "ramfuncs");
+#endif
+static inline void hal_epwm_ack_interrupt(void)
+{
+    EPwm1Regs.ETCLR.bit.INT = 1;
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP3;
+}
+
+// DMA channels, index 0 is channel 1; the channel register blocks follow each other
+
+/*
+ * Points a DMA channel at size words from source and runs it, the destination, trigger and mode stay as
+ * dma_init() configured them. A transfer in progress is dropped, the next trigger starts one from source,
+ * in continuous mode it starts over from source after size words.
+ */
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(hal_dma_start, "ramfuncs");
+#endif
+static inline void hal_dma_start(Uint16 channel, const Uint16 *source, Uint16 size)
+{
+    volatile struct CH_REGS *regs = &DmaRegs.CH1 + channel;
+
+    EALLOW;
+    regs->CONTROL.bit.HALT = 1;
+    regs->CONTROL.bit.SOFTRESET = 1;        // Transfer and burst counts to 0, the next trigger loads the shadows
+    regs->SRC_BEG_ADDR_SHADOW = (Uint32) source;
+    regs->SRC_ADDR_SHADOW = (Uint32) source;
+    regs->TRANSFER_SIZE = size - 1;
+    regs->CONTROL.bit.PERINTCLR = 1;        // A trigger latched while the channel was halted
+    regs->CONTROL.bit.RUN = 1;
+    EDIS;
+}
+
+// Stops a DMA channel, a word transfer in progress completes
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(hal_dma_halt, "ramfuncs");
+#endif
+static inline void hal_dma_halt(Uint16 channel)
+{
+    EALLOW;
+    (&DmaRegs.CH1 + channel)->CONTROL.bit.HALT = 1;
+    EDIS;
+}
+
+// Words a DMA channel has moved in its current transfer, 0 between transfers
+static inline Uint16 hal_dma_transfer_position(Uint16 channel)
+{
+    volatile struct CH_REGS *regs = &DmaRegs.CH1 + channel;
+
+    return regs->CONTROL.bit.TRANSFERSTS ? (Uint16) (regs->SRC_ADDR_ACTIVE - regs->SRC_BEG_ADDR_ACTIVE) : 0;
+}
+
+// Acknowledges PIE group 7 after the DMA channel 1 interrupt, the PIE clears its flag when the CPU takes it
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(hal_dma_ack_interrupt, "ramfuncs");
+#endif
+static inline void hal_dma_ack_interrupt(void)
+{
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP7;
+}
+
+// Free running SYSCLKOUT cycle count from CPU timer 0 (started by hal_system_init()), wraps every 47.7 s
+static inline Uint32 hal_cycle_count(void)
+{
+    return ~CpuTimer0Regs.TIM.all;  // The timer counts down from 0xFFFFFFFF
+}
+
+// Time base of the kernel benchmark (bench.h), SYSCLKOUT cycles at 90 MHz
+#define HAL_BENCHMARK_TICK_NS (1000.0 / 90)
+static inline Uint32 hal_benchmark_ticks(void)
+{
+    return hal_cycle_count();
+}
+
+// SCI A
+
+// Number of characters waiting in the RX FIFO
+static inline Uint16 hal_scia_rx_level(void)
+{
+    return SciaRegs.SCIFFRX.bit.RXFFST;
+}
+
+// Reads one character from the RX FIFO
+static inline Uint16 hal_scia_read(void)
+{
+    return SciaRegs.SCIRXBUF.all;
+}
+
+// Returns 1 and clears the flag if the RX FIFO overflowed (characters were lost)
+static inline Uint16 hal_scia_rx_overflowed(void)
+{
+    if (SciaRegs.SCIFFRX.bit.RXFFOVF)
+    {
+        SciaRegs.SCIFFRX.bit.RXFFOVRCLR = 1;
+        return 1;
+    }
+    return 0;
+}
+
+// Number of characters waiting in the TX FIFO
+static inline Uint16 hal_scia_tx_level(void)
+{
+    return SciaRegs.SCIFFTX.bit.TXFFST;
+}
+
+// Writes one character to the TX FIFO
+static inline void hal_scia_write(Uint16 value)
+{
+    SciaRegs.SCITXBUF = value;
+}
+
+// Returns 1 once the TX FIFO and the transmit shift register are both empty
+static inline Uint16 hal_scia_tx_idle(void)
+{
+    return SciaRegs.SCIFFTX.bit.TXFFST == 0 && SciaRegs.SCICTL2.bit.TXEMPTY;
+}
+
+// Writes the 16-bit baud rate register (BRR = LSPCLK / (baud * 8) - 1)
+static inline void hal_scia_set_baud_register(Uint16 brr)
+{
+    SciaRegs.SCIHBAUD = brr >> 8;
+    SciaRegs.SCILBAUD = brr & 0xFF;
+}
+
+// Enables or disables the TX FIFO empty interrupt
+static inline void hal_scia_tx_interrupt_enable(Uint16 enable)
+{
+    SciaRegs.SCIFFTX.bit.TXFFIENA = enable;
+}
+
+// Clears the RX FIFO interrupt flag and acknowledges PIE group 9
+static inline void hal_scia_ack_rx_interrupt(void)
+{
+    SciaRegs.SCIFFRX.bit.RXFFINTCLR = 1;
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP9;
+}
+
+// Clears the TX FIFO interrupt flag and acknowledges PIE group 9
+static inline void hal_scia_ack_tx_interrupt(void)
+{
+    SciaRegs.SCIFFTX.bit.TXFFINTCLR = 1;
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP9;
+}
+
+#endif // HAL_HOST
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * hrpwm.h
+ *
+ *  Optional high resolution PWM, built only with HRPWM_MODE defined.
+ *  At high carrier frequencies TBPRD is only a few hundred counts (450 at 100 kHz), so the integer
+ *  compare leaves a visible quantization floor. With HRPWM the fractional part of each compare goes
+ *  into CMPAHR and the fractional period into TBPRDHR; the micro edge positioner (MEP) places the
+ *  edge in steps of about 180 ps. The MEP step is calibrated by TI's SFO library (SFO_TI_Build_V6.lib,
+ *  add it and SFO_V6.h from C2000Ware to the build), with automatic conversion (AUTOCONV) the
+ *  hardware scales the 8-bit fraction to MEP steps itself.
+ */
+#include "DSP28x_Project.h"
+
+#ifndef HRPWM_H
+#define HRPWM_H
+
+// Uncomment to drive the ePWM channels with high resolution compare and period
+//#define HRPWM_MODE
+
+#define HRPWM_MIN_EDGE 3                // The MEP needs the compare at least 3 TBCLK away from 0 and TBPRD
+#define HRPWM_TYPICAL_MEP_STEPS 60      // MEP steps per TBCLK at 90 MHz (datasheet typical), used by the benchmark
+#define HRPWM_FRACTION_SCALE 65536.0f   // CMPA:CMPAHR and TBPRD:TBPRDHR are written as 16.16 fixed point
+
+#ifdef HRPWM_MODE
+
+#include "SFO_V6.h"
+
+#define PWM_CH 4                        // Entries of the ePWM[] array the SFO library uses, index 0 is unused
+
+extern int MEP_ScaleFactor;             // MEP steps per TBCLK, updated by SFO()
+
+// Function prototypes
+void hrpwm_init(void);          // Calibrates the MEP and enables HRPWM on every channel, call once the timers are configured
+void hrpwm_service(void);       // Recalibrates the MEP step for temperature and voltage drift, call from the main loop
+
+/*
+ * Converts a compare value in timer counts to CMPA:CMPAHR (16.16), clamped to the range the MEP supports.
+ * Runs in the ISR, kept in RAM when it is not inlined.
+ */
+#pragma CODE_SECTION(hrpwm_compare, "ramfuncs");
+static inline Uint32 hrpwm_compare(float counts, Uint16 timerPeriod)
+{
+    if (counts < HRPWM_MIN_EDGE)
+        counts = HRPWM_MIN_EDGE;
+    if (counts > timerPeriod - HRPWM_MIN_EDGE)
+        counts = timerPeriod - HRPWM_MIN_EDGE;
+    return (Uint32) (counts * HRPWM_FRACTION_SCALE);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * isr_stats.h
+ *
+ *  PWM ISR profiling, built only with ISR_PROFILING defined.
+ *  The SYSCLKOUT cycle count of CPU timer 0 (hal_cycle_count()) timestamps every entry to and exit from
+ *  the ePWM1 ISR.
+ *  Kept per ISR call: execution cycles (min / avg / max), the entry latency after the ePWM1 counter
+ *  zero (avg / max and a histogram), and a count of PWM interrupts that came too late to be taken
+ *  (missed updates). The main loop turns the cycles spent in the ISR (entry to exit, the latency is
+ *  time the CPU spent elsewhere) into a CPU load estimate over LOAD_WINDOW cycles.
+ *  The binary protocol dumps the statistics (OPCODE_ISR_STATS).
+ */
+#include "DSP28x_Project.h"
+#include <string.h>
+#include "pwm.h"
+
+#ifndef ISR_STATS_H
+#define ISR_STATS_H
+
+// Uncomment to profile the PWM ISR, leave commented out for production builds
+//#define ISR_PROFILING
+
+#define ISR_STATS_LATENCY_BINS 16
+#define ISR_STATS_LATENCY_BIN_CYCLES 8          // Entry latency covered by one histogram bin, the last bin takes the rest
+#define ISR_STATS_LOAD_WINDOW 9000000           // SYSCLKOUT cycles per CPU load estimate (100 ms)
+
+#ifdef ISR_PROFILING
+
+typedef struct
+{
+    Uint32 calls;               // ISR calls since the last reset
+    Uint32 cyclesMin;           // Cycles from ISR entry to exit
+    Uint32 cyclesMax;
+    Uint64 cyclesSum;
+    Uint32 missed;              // Interrupt events that passed while the previous one was still pending
+    Uint32 latencyMax;          // Cycles from counter zero to ISR entry
+    Uint64 latencySum;
+    Uint16 latencyHistogram[ISR_STATS_LATENCY_BINS]; // Same latency binned, saturates at 0xFFFF
+} IsrStats;
+
+extern IsrStats isrStats;
+extern volatile Uint16 isrStatsResetPending;
+extern volatile Uint32 isrBusyCycles;   // Running total of ISR entry to exit cycles, wraps, for the CPU load
+extern Uint32 isrStatsEntry;            // Timestamp of the ISR entry being profiled
+
+// Function prototypes
+void isr_stats_init(void);              // Clears the statistics, call after hal_system_init() started the timestamp timer
+void isr_stats_reset(void);             // Clears the statistics at the next ISR call
+void isr_stats_service(void);           // Background CPU load estimate for the main loop
+float isr_stats_cpu_load(void);         // Share of the CPU the PWM ISR used in the last full window (0-1)
+
+/*
+ * Called first thing in the PWM ISR. Records how long after the ePWM1 counter zero the ISR was entered
+ * and counts the interrupt events that were lost because the previous call was still running.
+ */
+#pragma CODE_SECTION(isr_stats_enter, "ramfuncs");
+static inline void isr_stats_enter(const WaveformPlan *plan)
+{
+    static Uint32 lastEntry = 0;
+    static Uint32 lastInterval = 0;     // Expected cycles between calls, 0 until known
+    Uint32 entry = hal_cycle_count();
+    Uint32 interval = (Uint32) 2 * plan->timerPeriod * plan->clockPrescale * EPwm1Regs.ETPS.bit.INTPRD;
+    Uint32 counter = EPwm1Regs.TBCTR;
+    Uint32 latency;
+    Uint32 bin;
+
+    if (isrStatsResetPending)
+    {
+        memset(&isrStats, 0, sizeof(isrStats));
+        isrStats.cyclesMin = 0xFFFFFFFF;
+        lastInterval = 0;
+        isrStatsResetPending = 0;
+    }
+
+    // The counter is still counting up in the period the interrupt belongs to, unless the ISR is very late
+    if (!EPwm1Regs.TBSTS.bit.CTRDIR)
+    {
+        counter = 2 * (Uint32) plan->timerPeriod - counter;
+    }
+    latency = counter * plan->clockPrescale;
+    bin = latency / ISR_STATS_LATENCY_BIN_CYCLES;
+    if (bin >= ISR_STATS_LATENCY_BINS)
+    {
+        bin = ISR_STATS_LATENCY_BINS - 1;
+    }
+    if (isrStats.latencyHistogram[bin] != 0xFFFF)
+    {
+        isrStats.latencyHistogram[bin]++;
+    }
+    if (latency > isrStats.latencyMax)
+    {
+        isrStats.latencyMax = latency;
+    }
+    isrStats.latencySum += latency;
+
+    // Late by more than half an interval means whole intervals went by without a call,
+    // the first interval after a time base or decimation change is not checked
+    if (lastInterval == interval && entry - lastEntry > interval + interval / 2)
+    {
+        isrStats.missed += (entry - lastEntry + interval / 2) / interval - 1;
+    }
+    lastInterval = interval;
+    lastEntry = entry;
+
+    isrStatsEntry = entry;
+}
+
+// Called last thing in the PWM ISR, adds the execution time of this call
+#pragma CODE_SECTION(isr_stats_exit, "ramfuncs");
+static inline void isr_stats_exit(void)
+{
+    Uint32 cycles = hal_cycle_count() - isrStatsEntry;
+
+    if (cycles < isrStats.cyclesMin)
+    {
+        isrStats.cyclesMin = cycles;
+    }
+    if (cycles > isrStats.cyclesMax)
+    {
+        isrStats.cyclesMax = cycles;
+    }
+    isrStats.cyclesSum += cycles;
+    isrBusyCycles += cycles;
+    isrStats.calls++;
+}
+
+#endif
+
+#endif
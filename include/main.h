@@ -1,8 +1,18 @@
 /// Included Files
 #include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
 #include <math.h>
+#include "hal.h"
 #include "pwm.h"
+#include "pwm_dma.h"
 #include "sci.h"
+#include "bench.h"
+#include "protocol.h"
+#include "profile.h"
+#include "isr_stats.h"
+#include "cla_shared.h"
+#include "telemetry.h"
+#include "config_store.h"
+#include "preset.h"
 
 #ifndef INCLUDE_MAIN_H_
 #define INCLUDE_MAIN_H_
@@ -11,5 +21,10 @@
 
 extern EPwmParams liveEpwmParams;
 extern EPwmParams bufferEpwmParams;
+extern WaveformPlan liveWaveformPlan;
+
+// Function prototypes
+void firmware_init(void);   // Initializes the system and the peripherals, prints the welcome screen
+void firmware_poll(void);   // One pass of the main loop: handles a received character and the background work
 
 #endif /* INCLUDE_MAIN_H_ */
@@ -0,0 +1,47 @@
+/*
+ * preset.h
+ *
+ *  Preset slots: PRESET_SLOTS operating points, each validated and compiled into a waveform plan when it
+ *  is stored. Activating a slot only hands its finished plan to the ISR (no parsing, no Y/N confirmation,
+ *  no plan compile), so the outputs switch at the next period boundary.
+ *  A slot is activated by a single byte (PRESET_BYTE_FIRST + slot) outside a binary frame, by
+ *  OPCODE_PRESET_ACTIVATE at a PLAN_APPLY_ point, or by a falling edge on the trigger GPIO for the armed slot.
+ *  With CONFIG_STORE the slots are saved in flash and loaded at boot. Activations are not saved as the
+ *  boot configuration, so a switch never waits for a flash write.
+ */
+#include "DSP28x_Project.h"
+#include "pwm.h"
+
+#ifndef PRESET_H
+#define PRESET_H
+
+#define PRESET_SLOTS 8
+#define PRESET_BYTE_FIRST 0xB0          // Activates slot 0, up to 0xB7 for slot 7, neither ASCII nor PROTOCOL_SYNC
+#define PRESET_NONE 0xFFFF              // No slot armed
+#define PRESET_TRIGGER_GPIO 12          // XINT1 input with pull up, init_preset_trigger_interrupt() sets up its pin
+
+// One operating point, plan is compiled from params when the slot is stored
+typedef struct
+{
+    EPwmParams params;
+    WaveformPlan plan;
+    Uint16 stored;              // 1 once the slot holds a valid parameter set
+} Preset;
+
+extern EPwmParams liveEpwmParams;
+extern EPwmParams bufferEpwmParams;
+extern volatile Uint16 presetTriggerPending;
+
+// Function prototypes
+void preset_init(void);                         // Loads the saved slots (CONFIG_STORE), call after config_init()
+int preset_store(Uint16 slot, const EPwmParams *params); // Validates and compiles the parameters into a slot, returns 1 if stored
+int preset_ready(Uint16 slot);                  // Returns 1 if the slot holds a parameter set
+Uint16 preset_activate(Uint16 slot, Uint16 when, Uint32 cycle); // Hands a stored slot to the ISR, returns the update's sequence number
+int preset_arm(Uint16 slot);                    // Selects the slot the trigger GPIO activates, PRESET_NONE disarms
+void init_preset_trigger_interrupt(void);       // XINT1 on PRESET_TRIGGER_GPIO, call after the PIE vector table is initialized
+void preset_service(void);                      // Activates the armed slot after a trigger edge, for the main loop
+
+// Interrupt service routines (ISRs)
+__interrupt void preset_trigger_isr(void);      // ISR for XINT1: Flags a trigger edge for preset_service().
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * profile.h
+ *
+ *  Ramp/sweep profile engine for the sine frequency and modulation depth.
+ *  A profile is a list of segments (target, ramp time, hold time). The PWM ISR advances it every
+ *  PROFILE_DECIMATION ISR calls by adding precomputed integer tuning word and amplitude steps to the
+ *  live waveform plan, so no division happens while it runs. The modulation depth can follow a
+ *  V/f line (depth = boost + slope * sinWavFreq) instead of per segment targets.
+ */
+#include "DSP28x_Project.h"
+#include "pwm.h"
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#define PROFILE_MAX_SEGMENTS 16
+#define PROFILE_DECIMATION 16           // ISR calls per profile tick
+#define PROFILE_DEPTH_FOLLOW_VF -1.0    // Segment depth target that follows the V/f line instead
+
+// Profile states
+#define PROFILE_IDLE 0
+#define PROFILE_RUNNING 1
+#define PROFILE_PAUSED 2
+#define PROFILE_DONE 3
+#define PROFILE_STARTING 4      // profile_start() is handing the outputs the plan the profile ramps
+
+// Segment as loaded by the user
+typedef struct
+{
+    float targetSinFreq;        // Sine frequency at the end of the ramp (Hz)
+    float targetDepth;          // Modulation depth at the end of the ramp, or PROFILE_DEPTH_FOLLOW_VF
+    Uint32 rampMs;              // Ramp duration from the previous target
+    Uint32 holdMs;              // Time held at the target before the next segment
+} ProfileSegment;
+
+extern EPwmParams liveEpwmParams;
+extern EPwmParams bufferEpwmParams;
+extern WaveformPlan liveWaveformPlan;
+extern volatile Uint16 profileState;
+
+// Function prototypes
+int profile_load_segment(Uint16 index, const ProfileSegment *segment); // Stores a segment, index 0 starts a new list
+int profile_set_vf(Uint16 enable, float boost, float slope);          // Sets the V/f line the depth follows
+int profile_start(Uint16 loop);         // Precomputes the steps and starts the profile from the live values
+void profile_pause(Uint16 pause);       // Pauses or resumes a running profile
+void profile_stop(void);                // Stops the profile, the outputs stay at the values reached
+void profile_current(float *sinWavFreq, float *modulationDepth); // Frequency and depth the outputs are at
+void profile_sync_params(void);         // Copies the frequency and depth the profile reached into liveEpwmParams
+void profile_service(void);             // Background profile work for the main loop
+Uint16 profile_segment_index(void);     // Index of the segment being played
+void profile_tick(WaveformPlan *plan);  // Advances the profile by one tick, called from the PWM ISR
+
+// Called on every ISR call, only does work every PROFILE_DECIMATION calls while running
+#pragma CODE_SECTION(profile_isr_step, "ramfuncs");
+static inline void profile_isr_step(WaveformPlan *plan)
+{
+    static Uint16 divider = 0;
+
+    if (profileState == PROFILE_RUNNING && ++divider >= PROFILE_DECIMATION)
+    {
+        divider = 0;
+        profile_tick(plan);
+    }
+}
+
+#endif
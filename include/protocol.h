@@ -0,0 +1,89 @@
+/*
+ * protocol.h
+ *
+ *  Compact binary command protocol, runs alongside the ASCII interface on SCI A.
+ *  Frame: SYNC | LENGTH | OPCODE | PAYLOAD (LENGTH bytes) | CRC16 high | CRC16 low
+ *  The CRC16 (CCITT, polynomial 0x1021, initial value 0xFFFF) covers LENGTH, OPCODE and PAYLOAD.
+ *  Multi-byte payload values are little endian, floats are IEEE 754 single precision.
+ *  Every request is answered with a single ACK or NACK frame (payload starts with the request opcode).
+ */
+#include "DSP28x_Project.h"
+#include "pwm.h"
+#include "profile.h"
+#include "waveform.h"
+#include "isr_stats.h"
+#include "telemetry.h"
+#include "preset.h"
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#define PROTOCOL_SYNC 0xA5              // Not a valid ASCII command character, starts a binary frame
+#define PROTOCOL_MAX_PAYLOAD 64
+#define PROTOCOL_MAX_FRAME (PROTOCOL_MAX_PAYLOAD + 5)   // SYNC, LENGTH, OPCODE and CRC, the TX room a reply waits for
+#define PROTOCOL_BYTE_TIMEOUT 9000000   // SYSCLKOUT cycles (100 ms) between two bytes of a frame before it is dropped
+
+// Request opcodes
+#define OPCODE_SET_PARAMS 0x01          // Uint16 field mask, then one float per set bit (lowest bit first)
+#define OPCODE_GET_PARAMS 0x02          // No payload, ACK carries all PARAM_COUNT parameter floats
+#define OPCODE_SET_BAUD 0x03            // Uint32 baud rate, switched after the ACK has been sent
+#define OPCODE_SET_MODULATION 0x04      // Uint16 modulation mode (MODULATION_SINE, _THIRD_HARMONIC, _SVPWM)
+#define OPCODE_GET_ACHIEVED 0x05        // No payload, ACK carries float carrier, float sine (achieved Hz),
+                                        // Uint16 TBPRD, Uint16 clock prescaler, Uint16 PWM periods per ISR call
+#define OPCODE_SCHEDULE_PARAMS 0x07     // Uint16 when (PLAN_APPLY_...), Uint32 carrier cycle, then as SET_PARAMS,
+                                        // ACK carries the Uint16 sequence number of the update
+#define OPCODE_PLAN_STATUS 0x08         // No payload, ACK carries Uint16 update pending, Uint16 applied sequence,
+                                        // Uint32 carrier cycle count, Uint32 cycle the last update took over in,
+                                        // Uint16 save status (CONFIG_STATUS_..., 0 without CONFIG_STORE)
+#define OPCODE_PROFILE_LOAD 0x20        // Uint16 index, float sin freq, float depth, Uint32 ramp ms, Uint32 hold ms
+#define OPCODE_PROFILE_VF 0x21          // Uint16 enable, float boost, float slope (depth per Hz)
+#define OPCODE_PROFILE_START 0x22       // Uint16 loop
+#define OPCODE_PROFILE_PAUSE 0x23       // Uint16 pause (1) or resume (0)
+#define OPCODE_PROFILE_STOP 0x24        // No payload, outputs stay at the values reached
+#define OPCODE_PROFILE_QUERY 0x25       // No payload, ACK carries Uint16 state, Uint16 segment, float sin freq, float depth
+#define OPCODE_WAVE_BEGIN 0x30          // Uint16 table length (power of two, 256-4096 samples)
+#define OPCODE_WAVE_DATA 0x31           // Uint16 sample offset, then up to 31 Q15 samples
+#define OPCODE_WAVE_COMMIT 0x32         // No payload, plays the uploaded table from the next period boundary
+#define OPCODE_WAVE_SELECT 0x33         // Uint16 waveform, 0 sine or 1 the committed table
+#define OPCODE_ISR_STATS 0x40           // Uint16 clear after reading, ACK carries the PWM ISR statistics (ISR_PROFILING builds only)
+#define OPCODE_TELEMETRY 0x41           // Uint16 PWM periods per telemetry record, 0 stops the stream
+#define OPCODE_PRESET_STORE 0x50        // Uint16 slot, then as SET_PARAMS over the live parameters (mask 0 stores them as they are)
+#define OPCODE_PRESET_ACTIVATE 0x51     // Uint16 slot, Uint16 when (PLAN_APPLY_...), Uint32 carrier cycle,
+                                        // ACK carries the Uint16 sequence number of the update
+#define OPCODE_PRESET_ARM 0x52          // Uint16 slot the trigger input activates, PRESET_NONE disarms
+
+// Reply opcodes
+#define OPCODE_ACK 0x06
+#define OPCODE_NACK 0x15
+
+// Telemetry stream opcodes, sent unrequested while telemetry is on (see telemetry.h), the payload has no request opcode
+#define OPCODE_TELEMETRY_PARAMS 0x60    // Active parameter set, sent before the first sample of every plan sequence
+#define OPCODE_TELEMETRY_SAMPLE 0x61    // One ISR record: Uint32 cycle, Uint32 phase, Uint32 tuning word,
+                                        // Uint16 sequence, Uint16 records dropped, one Uint16 CMPA per channel
+
+// SET_PARAMS field mask bits, in EPwmParams order
+#define PARAM_PWM_FREQ 0x0001
+#define PARAM_SIN_FREQ 0x0002
+#define PARAM_MODULATION_DEPTH 0x0004
+#define PARAM_OFFSET 0x0008
+#define PARAM_PHASE_LEAD1 0x0010        // Phase lead of channel n is bit 4 + n - 1
+#define PARAM_PHASE_LEAD2 0x0020
+#define PARAM_PHASE_LEAD3 0x0040
+#define PARAM_COUNT (4 + HAL_EPWM_CHANNELS)
+
+// NACK error codes
+#define NACK_BAD_CRC 0x01
+#define NACK_BAD_LENGTH 0x02
+#define NACK_UNKNOWN_OPCODE 0x03
+#define NACK_OUT_OF_RANGE 0x04
+#define NACK_REJECTED 0x05              // Not possible in the current state, e.g. loading while a profile plays
+#define NACK_BUSY 0x06                  // A parameter update is still pending (see plan_update_pending()), retry later
+
+// Function prototypes
+int protocol_busy(void);                        // Returns 1 while a frame is partly received
+int protocol_reply_pending(void);               // Returns 1 while a received frame waits for TX room for its reply
+void protocol_receive_byte(Uint16 byte);        // Feeds one received byte to the frame parser
+void protocol_service(void);                    // Replies once there is TX room, drops a frame whose rest never came
+Uint16 crc16_update(Uint16 crc, Uint16 byte);   // Adds one byte to a CRC16 (CCITT)
+
+#endif
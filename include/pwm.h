@@ -1,28 +1,53 @@
 /*
- * main.h
+ * pwm.h
+ *
+ *  Three phase PWM generation: the parameter limits, the parameters the user sets (EPwmParams), the
+ *  waveform plan compiled from them for the ePWM ISR (WaveformPlan) and the compare kernels the ISR,
+ *  the DMA tables and the CLA share.
  *
  *  Created on: Jun 26, 2024
  *      Author: admin
  */
 #include <math.h>
+#include "dds.h"
+#include "hal.h"
+#include "hrpwm.h"
 #ifndef PWM_H
 #define PWM_H
 
-//TODO: make define into config file with constant global variables for easier debugging (for define now, unit is unknown)
-
-//Define Valid Ranges for parameters (all frequencies are in measured in Hz)
-#define PWMWAVFREQ_MIN 687
+// Valid ranges of the user parameters: frequencies in Hz, angles in degrees, depth and offset without a unit
+#ifdef HRPWM_MODE
+#define PWMWAVFREQ_MIN 687              // The MEP needs TBCLK = SYSCLKOUT, so TBPRD alone has to hold the period
+#else
+#define PWMWAVFREQ_MIN 10               // The timer planner prescales TBCLK down to SYSCLKOUT / 1792
+#endif
 #define PWMWAVFREQ_MAX 100000
 #define SINWAVFREQ_MIN 0
 #define SINWAVFREQ_MAX 300
 #define MODULATION_DEPTH_MIN 0.0
 #define MODULATION_DEPTH_MAX 1.0
-#define PWMCLKFREQ 90.0*1000000.0
+#define MODULATION_DEPTH_INJECTED_MAX 1.1547    // 2/sqrt(3), common mode injection keeps the phase peak at depth * sqrt(3)/2
+#define PWMCLKFREQ (90.0*1000000.0)    // SYSCLKOUT in Hz, TBCLK before the prescaler
+#define TBPRD_MAX 65535                 // 16-bit time base period
+#define TIMEBASE_ERROR_TOLERANCE 1e-3   // Relative carrier error a finer prescaler may add over the closest one (see plan_timebase())
+#define PWM_INTERRUPT_DIVISOR_MAX 3     // ETPS INTPRD allows an interrupt on every 1st to 3rd event
+#define DECIMATION_MAX_ERROR 0.5        // Largest compare error (counts) the interpolation of a decimated ISR may add
 #define MIN_ANGLE -360
 #define MAX_ANGLE 360
-#define MAX_BUFFER_SIZE 100
 #define MAX_MSG_SIZE 100
 
+// Modulation modes, the injected modes add the same common mode signal to all three phases,
+// the line to line voltages stay sinusoidal but reach 15% more amplitude before the phases clip
+#define MODULATION_SINE 0               // Plain sinusoidal PWM per phase
+#define MODULATION_THIRD_HARMONIC 1     // Adds 1/6 of the third harmonic of phase 1
+#define MODULATION_SVPWM 2              // Min-max injection, same line to line output as space vector PWM
+#define INJECTED_PEAK_SCALE 0.8660254   // sqrt(3)/2, phase peak per unit depth with injection
+
+// When a new plan takes over from the live one (schedule_live_params())
+#define PLAN_APPLY_NEXT_PERIOD 0        // At the next ISR call
+#define PLAN_APPLY_ZERO_CROSSING 1      // At the first ISR call after the rising zero crossing of channel 1
+#define PLAN_APPLY_AT_CYCLE 2           // From the given carrier cycle (carrierCycleCount) on
+
 // Declaration of struct to hold PWM parameters
 typedef struct
 {
@@ -30,20 +55,188 @@ typedef struct
     float sinWavFreq;
     float modulation_depth;
     float offset;
-    float phaseLead1;
-    float phaseLead2;
-    float phaseLead3;
+    float phaseLead[HAL_EPWM_CHANNELS];     // Phase shift of each channel in degrees
     Uint32 epwmTimerTBPRD;
+    Uint16 waveform;            // WAVEFORM_SINE or WAVEFORM_TABLE (see waveform.h)
+    Uint16 modulationMode;      // MODULATION_SINE, MODULATION_THIRD_HARMONIC or MODULATION_SVPWM
 } EPwmParams;
 
+// Waveform plan compiled from EPwmParams when values are confirmed, holds only what the ISR needs
+// compare value = bias + amplitude * table sample
+typedef struct
+{
+#ifdef __TMS320C28XX_CLA__
+    Uint32 table;               // CLA pointers are 16 bits, the slot keeps the C28x layout (see PLAN_TABLE)
+#else
+    const int16 *table;         // One period in Q15, the sine table or an uploaded waveform table
+#endif
+    Uint16 tableShift;          // Phase word shift that leaves the table index
+    Uint16 tableMask;           // Table size - 1
+    Uint16 sine;                // 1 if table is the sine table, the rotation kernels and the DMA tables only run those
+    Uint32 tuningWord;          // Phase accumulator increment per PWM period (see dds.h)
+    Uint32 channelPhase[HAL_EPWM_CHANNELS]; // Phase lead of each channel as a phase word
+    Uint16 groupEnd[HAL_EPWM_GROUPS];       // Index after the last channel of each group (see HalEpwmChannel)
+    float amplitude;            // Compare counts per Q15 table step (negative, compare = (1 - duty) * TBPRD)
+    float bias;                 // Compare counts at a zero sample (includes the offset)
+    Uint16 timerPeriod;         // TBPRD the plan was scaled for
+    Uint32 timerPeriodHR;       // Exact period as 16.16 fixed point counts (TBPRD:TBPRDHR), fraction 0 without HRPWM_MODE
+    Uint16 modulationMode;      // Common mode injection, see MODULATION_SINE
+    Uint16 hspClkDiv;           // TBCTL HSPCLKDIV code of the time base prescaler
+    Uint16 clkDiv;              // TBCTL CLKDIV code of the time base prescaler
+    Uint16 clockPrescale;       // TBCLK = SYSCLKOUT / clockPrescale
+    Uint16 interruptDivisor;    // PWM periods per ISR call (ETPS INTPRD), the DMA writes the compares in between
+    float carrierFreq;          // Achieved PWM frequency, the compares change every period
+    float isrFreq;              // ISR calls per second, carrierFreq / interruptDivisor
+    float sineFreq;             // Achieved sine frequency
+#ifdef DDS_ROTATION
+    float leadSine[HAL_EPWM_CHANNELS];      // Sine and cosine of each channel's phase lead (see compare_counts())
+    float leadCosine[HAL_EPWM_CHANNELS];
+    Uint32 rotationWord;        // Tuning word stepSine / stepCosine belong to, a profile ramps tuningWord away from it
+    float stepSine;             // Sine and cosine of one tuning word step, for DDS_ROTATION_INCREMENTAL
+    float stepCosine;
+#endif
+} WaveformPlan;
+
+// Table of a plan, the CLA only runs sine plans (see cla_shared.h) and reads the sine table directly
+#ifdef __TMS320C28XX_CLA__
+#define PLAN_TABLE(plan) sineTable
+#else
+#define PLAN_TABLE(plan) ((plan)->table)
+#endif
+
+// The kernels below are also compiled for the CLA (cla_tasks.cla), ramfuncs only places the C28x copies
+
+/*
+ * Turns the table samples of all channels (counts on entry) into compare values in timer counts with fraction.
+ * The channels of a group are evaluated together so the injected modes add one common mode signal per
+ * three phase set: min-max (-(max + min) / 2 of the group's samples) or 1/6 of the third harmonic of the
+ * group's first channel.
+ */
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(scale_counts, "ramfuncs");
+#endif
+static inline void scale_counts(const WaveformPlan *plan, Uint32 phase, float *counts)
+{
+    Uint16 first = 0, group, ch;
+
+    for (group = 0; group < HAL_EPWM_GROUPS; group++)
+    {
+        Uint16 end = plan->groupEnd[group];
+        float commonMode = 0;
+
+        if (end - first >= 3 && plan->modulationMode == MODULATION_SVPWM)
+        {
+            float max = counts[first], min = counts[first];
+            for (ch = first + 1; ch < end; ch++)
+            {
+                if (counts[ch] > max) max = counts[ch];
+                if (counts[ch] < min) min = counts[ch];
+            }
+            commonMode = -.5f * (max + min);
+        }
+        else if (end - first >= 3 && plan->modulationMode == MODULATION_THIRD_HARMONIC)
+        {
+            commonMode = dds_sample(sineTable, SINE_TABLE_SHIFT, SINE_TABLE_MASK,
+                                    3 * (phase + plan->channelPhase[first])) * (1.0f / 6.0f);
+        }
+
+        for (ch = first; ch < end; ch++)
+        {
+            counts[ch] = plan->bias + plan->amplitude * (counts[ch] + commonMode);
+        }
+        first = end;
+    }
+}
+
+#ifdef DDS_ROTATION
+/*
+ * Same as compare_counts() for a sine plan whose base phase sine and cosine (Q15 scale) are already known:
+ * sin(phase + lead) = sin(phase) * cos(lead) + cos(phase) * sin(lead), two multiply-adds per channel.
+ */
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(compare_counts_rotated, "ramfuncs");
+#endif
+static inline void compare_counts_rotated(const WaveformPlan *plan, Uint32 phase, float baseSine, float baseCosine,
+                                          float *counts)
+{
+    Uint16 ch;
+
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        counts[ch] = baseSine * plan->leadCosine[ch] + baseCosine * plan->leadSine[ch];
+    }
+    scale_counts(plan, phase, counts);
+}
+#endif
+
+/*
+ * Calculates the compare values of all channels at the given phase word, in timer counts with fraction.
+ * Every channel costs one table sample and one multiply-add. With DDS_ROTATION a sine plan costs
+ * one sine / cosine pair for all channels and two multiply-adds per channel instead.
+ */
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(compare_counts, "ramfuncs");
+#endif
+static inline void compare_counts(const WaveformPlan *plan, Uint32 phase, float *counts)
+{
+    Uint16 ch;
+
+#ifdef DDS_ROTATION
+    if (plan->sine)
+    {
+        float baseSine, baseCosine;
+        dds_sine_cosine(phase, &baseSine, &baseCosine);
+        compare_counts_rotated(plan, phase, baseSine, baseCosine, counts);
+        return;
+    }
+#endif
+
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        counts[ch] = dds_sample(PLAN_TABLE(plan), plan->tableShift, plan->tableMask, phase + plan->channelPhase[ch]);
+    }
+    scale_counts(plan, phase, counts);
+}
+
+// Calculates the integer compare values (CMPA) of all channels at the given phase word
+#ifndef __TMS320C28XX_CLA__
+#pragma CODE_SECTION(compare_values, "ramfuncs");
+#endif
+static inline void compare_values(const WaveformPlan *plan, Uint32 phase, Uint16 *compare)
+{
+    float counts[HAL_EPWM_CHANNELS];
+    Uint16 ch;
+
+    compare_counts(plan, phase, counts);
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        compare[ch] = (Uint16) counts[ch];
+    }
+}
+
 // Function prototypes
 
-void Init_Epwmm(void);              // Initialize registers for ePWM 1, 2, and 3
-void init_epwm_interrupts(void);    //Initialize interrupts for ePWM 1,2, and 3
+void Init_Epwmm(void);              // Initialize the registers of every ePWM channel
+void init_phase_leads(EPwmParams *params); // Sets the phase leads to the power up values of the channel descriptors
+void compile_waveform_plan(EPwmParams *params, WaveformPlan *plan); // Calculates the timer period and compiles the waveform plan for the ISR
+void limit_plan_decimation(WaveformPlan *plan, float sinWavFreq); // Lowers the ISR decimation to what a higher sine frequency allows
+int params_valid(const EPwmParams *params); // Returns 1 if every parameter is within its valid range
+float modulation_depth_max(const EPwmParams *params); // Highest modulation depth of the modulation mode
+float offset_limit(const EPwmParams *params); // Highest offset magnitude that keeps the outputs within the period
+void wait_for_plan_update(void);    // Waits until the ISR has switched to the last applied plan
+void apply_live_params(void);       // Applies liveEpwmParams to the outputs, starts them or retunes them without a glitch
+Uint16 schedule_live_params(Uint16 when, Uint32 cycle); // Applies liveEpwmParams at a PLAN_APPLY_ point, returns the update's sequence number
+Uint16 schedule_live_plan(const WaveformPlan *plan, Uint16 when, Uint32 cycle); // Same with a plan compiled from liveEpwmParams beforehand
+Uint16 plan_update_pending(void);   // Returns 1 while the ISR has not switched to the last applied plan
+Uint16 plan_applied_sequence(void); // Sequence number of the plan the ISR runs
+void init_epwm_interrupts(void);    //Initialize the ePWM1 interrupt that drives every channel
+
+// PWM periods (ePWM1 counter zeros) since the outputs started, and the period the last plan took over in
+extern volatile Uint32 carrierCycleCount;
+extern volatile Uint32 planAppliedCycle;
+extern volatile Uint32 planAppliedPhase;
 
 // Interrupt service routines (ISRs)
-__interrupt void epwm1_isr(void);               // ISR for ePWM1: Generates a sinusoidal PWM signal with the specified parameters.
-__interrupt void epwm2_isr(void);               // ISR for ePWM2: Generates a sinusoidal PWM signal with the specified parameters.
-__interrupt void epwm3_isr(void);               // ISR for ePWM3: Generates a sinusoidal PWM signal with the specified parameters.
+__interrupt void epwm_three_phase_isr(void);    // ISR for ePWM1: Generates the phase shifted sinusoidal PWM signals of every channel.
 
 #endif
@@ -0,0 +1,51 @@
+/*
+ * pwm_dma.h
+ *
+ *  DMA table mode: when the PWM frequency is a whole multiple of the sine frequency, one full sine
+ *  period of compare values is precomputed for each channel and DMA channels 1-3 stream them into
+ *  EPwm1..3Regs.CMPA on every ePWM1 SOCA (counter zero). The steady-state output then uses no CPU.
+ *  Ratios that do not fit fall back to the ISR. The handovers keep the sine continuous: the DMA starts
+ *  at the table entry of the ISR's phase, and the ISR resumes from the DMA's next entry with
+ *  carrierCycleCount moved on by the periods the DMA wrote (channel 1 counts its passes over the tables).
+ *
+ *  Interrupt decimation: when the plan's interruptDivisor is 2 or 3 the ISR runs only every 2nd or 3rd
+ *  period. Each call fills half of a small ring per channel with the compares of the next
+ *  interruptDivisor periods, interpolated up to one exact compare, and the DMA streams the ring into
+ *  CMPA on every SOCA so the compares still change every period. The ISR fills the half the DMA has
+ *  just finished, one whole decimated interval ahead. The ring runs on DMA channels 4-6.
+ */
+#include "DSP28x_Project.h"
+#include "pwm.h"
+
+#ifndef PWM_DMA_H
+#define PWM_DMA_H
+
+// Uncomment to stream the compare values with the DMA whenever the frequency ratio fits a table
+//#define DMA_TABLE_MODE
+
+#define DMA_TABLE_MAX_SIZE 0x1000   // Compare values per channel and period, the period twice fills one RAML5-7 block
+#define DMA_TABLE_MIN_SIZE 2
+#define DMA_RATIO_TOLERANCE 0.0001  // How close pwmWavFreq / sinWavFreq has to be to a whole number
+
+#define DMA_CHANNELS 3              // DMA channels 1-3 (4-6) write ePWM1-3, other channel counts keep the ISR
+#define DMA_RING_SIZE (2 * PWM_INTERRUPT_DIVISOR_MAX)   // Two halves of up to 3 compares per channel
+
+extern Uint16 dmaTableModeActive;
+extern volatile Uint16 dmaTableStartPending;
+extern Uint16 dmaResumePending;
+extern Uint32 dmaResumePhase;
+extern Uint16 dmaRingDivisor;
+extern Uint16 dmaCmpaRing[HAL_EPWM_CHANNELS][DMA_RING_SIZE];
+
+// Function prototypes
+void dma_init(void);                   // Configures DMA channels 1-6 once, call before the ePWM interrupt is enabled
+Uint16 dma_table_length(const EPwmParams *params);    // Samples per sine period if the parameters fit a DMA table, 0 otherwise
+void dma_start_table_mode(const WaveformPlan *plan, Uint16 length); // Fills the tables, the ISR hands the outputs to the DMA at its next call
+void dma_take_over(Uint32 phase, Uint32 cycleCount);   // Called from the ISR, the DMA streams the compares from phase on
+Uint32 dma_table_cycle_count(void);                    // carrierCycleCount while the DMA streams the tables
+void dma_stop_table_mode(void);                        // Stops the DMA and hands the outputs back to the ISR at the DMA's phase
+__interrupt void dma_table_isr(void);                  // DMA channel 1: one pass over the tables
+void dma_start_ring(Uint16 divisor);   // Streams the compare ring into CMPA and interrupts every divisor periods
+void dma_stop_ring(void);              // Stops the ring, the ISR interrupts and writes CMPA every period again
+
+#endif
@@ -6,34 +6,53 @@
  */
 #include <stdio.h>
 #include <string.h>
-#include <stdlib.h>
 #include "pwm.h"
+#include "command_parser.h"
 
 #ifndef SCI_H
 #define SCI_H
 
 #define NEWLINE "\r\n"
+#define SCIA_RX_RING_SIZE 128       // Must be a power of 2
+#define SCIA_TX_RING_SIZE 2048      // Must be a power of 2, holds the full welcome screen and parameter dump
+#define SCIA_FIFO_DEPTH 4
+#define SCIA_LSPCLK 22500000        // Low speed peripheral clock (90 MHz SYSCLK / 4)
+#define SCIA_BAUD_TOLERANCE 0.02    // Largest relative baud rate error accepted for a baud rate change
 
 extern EPwmParams liveEpwmParams;
 extern EPwmParams bufferEpwmParams;
+extern WaveformPlan liveWaveformPlan;
+extern volatile Uint32 sciaRxOverflowCount;
+extern volatile Uint32 sciaTxOverflowCount;
 
 // Function Prototypes
 // Peripheral initialization
 void scia_echoback_init(void);     // Rx and Tx register initialization
 void scia_fifo_init(void);         // Initialize registers the SCI FIFO
+void init_scia_interrupts(void);   // Initialize the SCI A RX and TX FIFO interrupts
+
+// Interrupt service routines (ISRs)
+__interrupt void scia_rx_isr(void);     // ISR for SCI A RX FIFO: Moves received characters into the RX ring buffer.
+__interrupt void scia_tx_isr(void);     // ISR for SCI A TX FIFO: Refills the TX FIFO from the TX ring buffer.
 
 // Utility functions
-void handle_received_char(Uint16 ReceivedChar); // Handles a received character from SCI, processes input buffer for PWM parameters.
-int populate_variable(const char *arr, float *var, float min, float max,
-                      int *pindex);             // Populates a float variable with a value from a given string, ensuring the value is within the specified range.
-int process_buffer(const char *buffer);         // Processes the input buffer to extract and update the PWM parameters.
-int confirm_values(void);                       // Prompts the user to confirm the new PWM values and returns the confirmation status.
+void handle_received_char(Uint16 ReceivedChar); // Handles a received character from SCI, feeds it to the command parser.
+void set_or_reset_params(int confirmed);        // Applies the confirmed buffered parameters, or restores them from the live ones.
+void live_params_changed(void);                 // Cancels a pending confirmation after the live parameters changed elsewhere.
+void prompt_confirmation(void);                 // Prompts the user to confirm the new PWM values.
+int confirm_values(Uint16 ReceivedChar);        // Checks the answer to the confirmation prompt and returns the confirmation status.
 void print_params(const EPwmParams *arr);       // Prints the given PWM parameters to the serial terminal.
+void print_achieved(const WaveformPlan *plan);  // Prints the frequencies and time base the timer planner achieved.
 void float_to_string(float value);              // Function to convert a float to a string and send it via SCI
 void report_invalid_input(char invalid_char);   // Reports an invalid input character via the serial terminal.
 void clear_scia_rx_buffer(void);                // Clears the SCI A RX buffer to remove any remaining data.
-void scia_msg(const char *msg);                 // Transmits a message (string) via the SCI.
-void scia_xmit(int asciiValue);                 // Transmits a single ASCII character via the SCI.
+int scia_read(Uint16 *ReceivedChar);            // Reads a received character if one is available, never waits.
+void scia_msg(const char *msg);                 // Queues a message (string) for transmission via the SCI.
+int scia_xmit(int asciiValue);                  // Queues a single ASCII character for transmission via the SCI, never waits.
+Uint16 scia_tx_free(void);                      // Returns the number of characters the TX ring buffer still takes.
+int scia_baud_valid(Uint32 baud);               // Returns 1 if the baud rate can be generated within SCIA_BAUD_TOLERANCE.
+void scia_request_baud(Uint32 baud);            // Switches the baud rate once everything queued so far has been sent.
+void scia_service(void);                        // Background SCI work for the main loop (pending baud rate switch).
 void print_welcome_screen(void);                // Prints the welcome screen message to the serial terminal.
 
 #endif
@@ -0,0 +1,132 @@
+/*
+ * telemetry.h
+ *
+ *  Live telemetry stream of the generated compares.
+ *  While enabled the PWM ISR copies a record (carrier cycle, phase word, tuning word, plan sequence and the
+ *  CMPA value of every channel) into a RAM ring every telemetryPeriods PWM periods, it never formats text.
+ *  The main loop sends each record as a binary frame (OPCODE_TELEMETRY_SAMPLE, see protocol.h) and, whenever
+ *  the plan changes, the active parameter set first (OPCODE_TELEMETRY_PARAMS). tools/telemetry_decode.py
+ *  turns a capture of the serial port into CSV.
+ *  Records are only produced by the ISR, so enabling telemetry takes the outputs back from the DMA tables
+ *  and the CLA. Records the main loop could not send in time are dropped, the next record counts them.
+ */
+#include "DSP28x_Project.h"
+#include "pwm.h"
+#include "waveform.h"
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#define TELEMETRY_RING_SIZE 32              // Records, must be a power of 2
+#define TELEMETRY_TX_RESERVE 256            // TX ring space a frame leaves free for replies and echoes
+#define TELEMETRY_PLAN_SLOTS 4              // Plan sequences whose parameters are kept for queued records, a power of 2
+
+// One ISR sample, the compares are the ones active in carrier cycle cycle
+typedef struct
+{
+    Uint32 cycle;                           // Carrier cycle (see carrierCycleCount) the compares load for
+    Uint32 phase;                           // Phase word of the compares
+    Uint32 tuningWord;                      // Phase increment per PWM period, a profile ramps it
+    Uint16 sequence;                        // Sequence number of the plan (plan_applied_sequence())
+    Uint16 dropped;                         // Records lost right before this one because the ring was full
+    Uint16 compare[HAL_EPWM_CHANNELS];      // CMPA of each channel
+} TelemetryRecord;
+
+// Parameters of a plan sequence as the ISR switched to it, sent before the first record of the sequence
+typedef struct
+{
+    Uint16 sequence;                        // Plan sequence (plan_applied_sequence()) the parameters belong to
+    float carrierFreq;                      // Achieved frequencies
+    float sineFreq;
+    float amplitude;                        // As in WaveformPlan
+    float bias;
+    Uint32 channelPhase[HAL_EPWM_CHANNELS];
+    Uint16 timerPeriod;
+    Uint16 clockPrescale;
+    Uint16 modulationMode;
+    Uint16 waveform;                        // WAVEFORM_SINE or WAVEFORM_TABLE
+} TelemetryPlan;
+
+extern TelemetryRecord telemetryRing[TELEMETRY_RING_SIZE];
+extern TelemetryPlan telemetryPlans[TELEMETRY_PLAN_SLOTS];
+extern Uint16 telemetryPlanHead;            // Slot the next plan goes to, written with interrupts off only
+extern volatile Uint16 telemetryHead;       // Written by the ISR only
+extern volatile Uint16 telemetryTail;       // Written by the main loop only
+extern volatile Uint16 telemetryPeriods;    // PWM periods per record, 0 while telemetry is off
+extern Uint32 telemetryNextCycle;           // Carrier cycle of the next record
+extern Uint16 telemetryDropped;             // Records dropped since the last queued one, written by the ISR only
+
+// Function prototypes
+void telemetry_start(Uint16 periods);       // Streams a record every periods PWM periods, 0 stops the stream
+void telemetry_service(void);               // Background telemetry work for the main loop, sends the queued records
+
+/*
+ * Keeps the parameters of a plan the outputs switch to, called from the PWM ISR at the switch while
+ * telemetry is on. Records still queued for older sequences find theirs in the other slots.
+ */
+#pragma CODE_SECTION(telemetry_isr_plan, "ramfuncs");
+static inline void telemetry_isr_plan(const WaveformPlan *plan, Uint16 sequence)
+{
+    TelemetryPlan *slot = &telemetryPlans[telemetryPlanHead];
+    Uint16 ch;
+
+    slot->sequence = sequence;
+    slot->carrierFreq = plan->carrierFreq;
+    slot->sineFreq = plan->sineFreq;
+    slot->amplitude = plan->amplitude;
+    slot->bias = plan->bias;
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        slot->channelPhase[ch] = plan->channelPhase[ch];
+    }
+    slot->timerPeriod = plan->timerPeriod;
+    slot->clockPrescale = plan->clockPrescale;
+    slot->modulationMode = plan->modulationMode;
+    slot->waveform = plan->sine ? WAVEFORM_SINE : WAVEFORM_TABLE;
+    telemetryPlanHead = (telemetryPlanHead + 1) & (TELEMETRY_PLAN_SLOTS - 1);
+}
+
+// Returns 1 if the compares of carrier cycle cycle are due for a record, called from the PWM ISR
+#pragma CODE_SECTION(telemetry_isr_due, "ramfuncs");
+static inline Uint16 telemetry_isr_due(Uint32 cycle)
+{
+    return telemetryPeriods && (int32) (cycle - telemetryNextCycle) >= 0;
+}
+
+/*
+ * Queues a record of the compares that are active in carrier cycle cycle, called from the PWM ISR
+ * once telemetry_isr_due() returned 1. Only copies, the main loop builds the frames.
+ */
+#pragma CODE_SECTION(telemetry_isr_record, "ramfuncs");
+static inline void telemetry_isr_record(Uint32 cycle, Uint32 phase, const WaveformPlan *plan, Uint16 sequence,
+                                        const Uint16 *compare)
+{
+    Uint16 head = telemetryHead;
+    Uint16 next = (head + 1) & (TELEMETRY_RING_SIZE - 1);
+    TelemetryRecord *record = &telemetryRing[head];
+    Uint16 ch;
+
+    telemetryNextCycle = cycle + telemetryPeriods;
+    if (next == telemetryTail)
+    {
+        if (telemetryDropped != 0xFFFF)
+        {
+            telemetryDropped++;
+        }
+        return;
+    }
+
+    record->cycle = cycle;
+    record->phase = phase;
+    record->tuningWord = plan->tuningWord;
+    record->sequence = sequence;
+    record->dropped = telemetryDropped;
+    telemetryDropped = 0;
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        record->compare[ch] = compare[ch];
+    }
+    telemetryHead = next;
+}
+
+#endif
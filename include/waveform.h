@@ -0,0 +1,31 @@
+/*
+ * waveform.h
+ *
+ *  User defined waveform tables (trapezoid, clipped sine, recorded current, ...) uploaded in chunks
+ *  over SCI A and played back by the ISR instead of the sine table, at sinWavFreq with the same
+ *  per channel phase leads. Two table buffers share RAML4: uploads go to the one not playing and
+ *  the switch is an ordinary plan update, so it happens at a period boundary without a glitch.
+ */
+#include "DSP28x_Project.h"
+#include "pwm.h"
+
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#define WAVEFORM_TABLE_MIN_BITS 8
+#define WAVEFORM_TABLE_MAX_BITS 12
+#define WAVEFORM_TABLE_MAX_SIZE (1 << WAVEFORM_TABLE_MAX_BITS)  // Q15 samples of one period, 2 buffers fill RAML4
+
+// EPwmParams.waveform values
+#define WAVEFORM_SINE 0
+#define WAVEFORM_TABLE 1
+
+// Function prototypes
+int waveform_upload_busy(void);                 // Returns 1 while the ISR still plays the buffer of the previous commit
+int waveform_upload_begin(Uint16 length);       // Starts an upload of a power of two table length into the free buffer
+int waveform_upload_chunk(Uint16 offset, const Uint16 *bytes, Uint16 count); // Stores count little endian Q15 samples
+int waveform_upload_commit(void);                // Switches the outputs to the uploaded table at the next period boundary
+int waveform_table_ready(void);                 // Returns 1 once a table has been committed
+void waveform_select_table(Uint16 waveform, WaveformPlan *plan); // Points a plan at the sine or the committed table
+
+#endif
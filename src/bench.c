@@ -0,0 +1,499 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include <math.h>
+#include "bench.h"
+#include "sci.h"
+#include "waveform.h"
+
+#ifdef KERNEL_BENCHMARK
+
+// Radians per phase word unit in single precision, DDS_PHASE_FULL_SCALE is long double and would time
+// the 64-bit float library instead of the kernel
+#define BENCH_RADIANS_PER_PHASE (2.0f * (float) M_PI / 4294967296.0f)
+
+// Sine table the table kernels read, refilled for each table size
+#pragma DATA_SECTION(benchTable, "pwmdata");
+static int16 benchTable[1 << BENCH_TABLE_BITS_MAX];
+static Uint16 benchTableBits;
+
+// Kernel under test, returns the Q15 scaled sine at the phase word like dds_sample()
+typedef struct
+{
+    const char *name;
+    float (*sample)(Uint32 phase);
+    Uint16 tableBits;           // 0 if the kernel does not use the table
+} BenchKernel;
+
+// Reference kernel, what the ISR did before the lookup table
+#pragma CODE_SECTION(kernel_sinf, "ramfuncs");
+static float kernel_sinf(Uint32 phase)
+{
+    return SINE_TABLE_AMPLITUDE * sinf((float) phase * BENCH_RADIANS_PER_PHASE);
+}
+
+// Nearest lower table entry
+#pragma CODE_SECTION(kernel_table, "ramfuncs");
+static float kernel_table(Uint32 phase)
+{
+    return (float) benchTable[phase >> (32 - benchTableBits)];
+}
+
+// Linear interpolation between neighbouring table entries
+#pragma CODE_SECTION(kernel_table_interp, "ramfuncs");
+static float kernel_table_interp(Uint32 phase)
+{
+    Uint16 index = (Uint16) (phase >> (32 - benchTableBits));
+    float sample = (float) benchTable[index];
+    float fraction = (float) ((Uint16) ((phase << benchTableBits) >> 16)) * (1.0f / 65536.0f);
+    return sample + ((float) benchTable[(index + 1) & ((1 << benchTableBits) - 1)] - sample) * fraction;
+}
+
+// Linear interpolation in Q15 integer math (IQmath style), only the result is converted to float.
+// Neighbouring entries of a table of 2^8 or more differ by less than 2^10, so the product fits 32 bits.
+#pragma CODE_SECTION(kernel_table_interp_q15, "ramfuncs");
+static float kernel_table_interp_q15(Uint32 phase)
+{
+    Uint16 index = (Uint16) (phase >> (32 - benchTableBits));
+    int32 sample = benchTable[index];
+    int32 next = benchTable[(index + 1) & ((1 << benchTableBits) - 1)];
+    int32 fraction = (Uint16) ((phase << benchTableBits) >> 16);
+    return (float) (sample + (((next - sample) * fraction) >> 16));
+}
+
+// Empty kernel, its time is subtracted as the loop and call overhead
+#pragma CODE_SECTION(kernel_empty, "ramfuncs");
+static float kernel_empty(Uint32 phase)
+{
+    return 0;
+}
+
+static const BenchKernel benchKernels[] = {
+        { "sinf", kernel_sinf, 0 },
+        { "table", kernel_table, 8 },
+        { "table", kernel_table, 9 },
+        { "table", kernel_table, 10 },
+        { "table", kernel_table, 11 },
+        { "table_interp", kernel_table_interp, 8 },
+        { "table_interp", kernel_table_interp, 9 },
+        { "table_interp", kernel_table_interp, 10 },
+        { "table_interp", kernel_table_interp, 11 },
+        { "table_interp_q15", kernel_table_interp_q15, 8 },
+        { "table_interp_q15", kernel_table_interp_q15, 9 },
+        { "table_interp_q15", kernel_table_interp_q15, 10 },
+        { "table_interp_q15", kernel_table_interp_q15, 11 }
+};
+
+// Three phase kernel under test, writes the Q15 scaled sines of channels 1-3 at the phase word
+typedef struct
+{
+    const char *name;
+    void (*sample)(Uint32 phase, float *out);
+} BenchThreePhaseKernel;
+
+// Phase leads of the three phase kernels (0, -120, 120 degrees) with their rotation coefficients,
+// and the phase step of consecutive samples with its rotation for the incremental kernel
+static Uint32 benchLeadPhase[3];
+static float benchLeadSine[3];
+static float benchLeadCosine[3];
+static Uint32 benchStep;
+static float benchStepSine;
+static float benchStepCosine;
+static DdsRotator benchRotator;
+
+// Reference, one sinf per channel
+#pragma CODE_SECTION(kernel3_sinf, "ramfuncs");
+static void kernel3_sinf(Uint32 phase, float *out)
+{
+    Uint16 ch;
+    for (ch = 0; ch < 3; ch++)
+    {
+        out[ch] = SINE_TABLE_AMPLITUDE * sinf((float) (phase + benchLeadPhase[ch]) * BENCH_RADIANS_PER_PHASE);
+    }
+}
+
+// One interpolated sine table sample per channel, what compare_counts() does by default
+#pragma CODE_SECTION(kernel3_table, "ramfuncs");
+static void kernel3_table(Uint32 phase, float *out)
+{
+    Uint16 ch;
+    for (ch = 0; ch < 3; ch++)
+    {
+        out[ch] = dds_sample(sineTable, SINE_TABLE_SHIFT, SINE_TABLE_MASK, phase + benchLeadPhase[ch]);
+    }
+}
+
+// Interpolated sine table sample per channel in Q15 integer math, see kernel_table_interp_q15()
+#pragma CODE_SECTION(kernel3_table_q15, "ramfuncs");
+static void kernel3_table_q15(Uint32 phase, float *out)
+{
+    Uint16 ch;
+    for (ch = 0; ch < 3; ch++)
+    {
+        Uint32 channelPhase = phase + benchLeadPhase[ch];
+        Uint16 index = (Uint16) (channelPhase >> SINE_TABLE_SHIFT);
+        int32 sample = sineTable[index];
+        int32 next = sineTable[(index + 1) & SINE_TABLE_MASK];
+        int32 fraction = (Uint16) (channelPhase >> (SINE_TABLE_SHIFT - 16));
+        out[ch] = (float) (sample + (((next - sample) * fraction) >> 16));
+    }
+}
+
+// Sine / cosine pair from the table, rotated by each phase lead (DDS_ROTATION)
+#pragma CODE_SECTION(kernel3_rotation, "ramfuncs");
+static void kernel3_rotation(Uint32 phase, float *out)
+{
+    float baseSine, baseCosine;
+    Uint16 ch;
+
+    dds_sine_cosine(phase, &baseSine, &baseCosine);
+    for (ch = 0; ch < 3; ch++)
+    {
+        out[ch] = baseSine * benchLeadCosine[ch] + baseCosine * benchLeadSine[ch];
+    }
+}
+
+// Pair advanced by one step rotation per sample, then rotated by each phase lead (DDS_ROTATION_INCREMENTAL)
+#pragma CODE_SECTION(kernel3_rotation_incremental, "ramfuncs");
+static void kernel3_rotation_incremental(Uint32 phase, float *out)
+{
+    float baseSine, baseCosine;
+    Uint16 ch;
+
+    dds_rotator_sine_cosine(&benchRotator, phase, benchStep, benchStepSine, benchStepCosine, &baseSine, &baseCosine);
+    for (ch = 0; ch < 3; ch++)
+    {
+        out[ch] = baseSine * benchLeadCosine[ch] + baseCosine * benchLeadSine[ch];
+    }
+}
+
+// Empty kernel, its time is subtracted as the loop and call overhead
+#pragma CODE_SECTION(kernel3_empty, "ramfuncs");
+static void kernel3_empty(Uint32 phase, float *out)
+{
+}
+
+static const BenchThreePhaseKernel benchThreePhaseKernels[] = {
+        { "sinf_x3", kernel3_sinf },
+        { "table_interp_x3", kernel3_table },
+        { "table_interp_q15_x3", kernel3_table_q15 },
+        { "rotation", kernel3_rotation },
+        { "rotation_incremental", kernel3_rotation_incremental }
+};
+
+static const float benchPwmFreqs[] = { PWMWAVFREQ_MIN, 1000, 2500, 10000, 25000, 50000, PWMWAVFREQ_MAX };
+static const float benchSinFreqs[] = { 1, 10, 60, 150, SINWAVFREQ_MAX };
+
+// Queues a message, waiting for room in the TX ring buffer instead of dropping characters
+static void bench_msg(const char *msg)
+{
+    while (*msg)
+    {
+        while (!scia_xmit(*msg))
+        {
+            hal_busy_wait();
+        }
+        msg++;
+    }
+}
+
+// Fills the benchmark table with one sine period of 2^bits entries
+static void bench_fill_table(Uint16 bits)
+{
+    Uint16 i, size = 1 << bits;
+    for (i = 0; i < size; i++)
+    {
+        benchTable[i] = (int16) floorf(SINE_TABLE_AMPLITUDE * sinf(2 * M_PI * i / size) + 0.5f);
+    }
+    benchTableBits = bits;
+}
+
+/*
+ * Benchmark ticks (hal_benchmark_ticks()) the kernel takes for BENCH_TIMING_SAMPLES samples.
+ * The kernel is called through a volatile pointer, so the compiler can neither inline it nor drop the
+ * calls whose result is not used. Interrupts are off while the loop runs, an SCI or PWM ISR would be
+ * counted as kernel time.
+ */
+static Uint32 bench_time_kernel(float (*sample)(Uint32 phase))
+{
+    float (*volatile kernel)(Uint32 phase) = sample;
+    Uint32 phase = 0, i, start, end;
+
+    DINT;
+    start = hal_benchmark_ticks();
+    for (i = 0; i < BENCH_TIMING_SAMPLES; i++)
+    {
+        kernel(phase);
+        phase += 0x01234567;
+    }
+    end = hal_benchmark_ticks();
+    EINT;
+    return end - start;
+}
+
+// Ticks the three phase kernel takes for BENCH_TIMING_SAMPLES consecutive samples benchStep apart, as above
+static Uint32 bench_time_three_phase(void (*sample)(Uint32 phase, float *out))
+{
+    void (*volatile kernel)(Uint32 phase, float *out) = sample;
+    float out[3];
+    Uint32 phase = 0, i, start, end;
+
+    DINT;
+    start = hal_benchmark_ticks();
+    for (i = 0; i < BENCH_TIMING_SAMPLES; i++)
+    {
+        kernel(phase, out);
+        phase += benchStep;
+    }
+    end = hal_benchmark_ticks();
+    EINT;
+    return end - start;
+}
+
+/*
+ * Formats the time per sample as the "cycles,ns" CSV fields. On the target the ticks are SYSCLKOUT cycles,
+ * the host build times the kernels on the host CPU, so its cycles field stays empty.
+ */
+static void bench_format_time(char *fields, float ticksPerSample)
+{
+#ifdef HAL_HOST
+    sprintf(fields, ",%.1f", ticksPerSample * HAL_BENCHMARK_TICK_NS);
+#else
+    sprintf(fields, "%.2f,%.1f", ticksPerSample, ticksPerSample * HAL_BENCHMARK_TICK_NS);
+#endif
+}
+
+// Largest difference (Q15 steps) between the three phase kernel and sinf over BENCH_THREE_PHASE_SAMPLES samples
+static float bench_three_phase_error(void (*sample)(Uint32 phase, float *out))
+{
+    float out[3], maxError = 0;
+    Uint32 phase = 0, i;
+    Uint16 ch;
+
+    for (i = 0; i < BENCH_THREE_PHASE_SAMPLES; i++)
+    {
+        sample(phase, out);
+        for (ch = 0; ch < 3; ch++)
+        {
+            float exact = SINE_TABLE_AMPLITUDE
+                    * sinf((float) ((phase + benchLeadPhase[ch]) >> 8) * (2 * M_PI / 16777216.0));
+            maxError = fmaxf(maxError, fabsf(out[ch] - exact));
+        }
+        phase += benchStep;
+    }
+    return maxError;
+}
+
+/*
+ * Times the three phase kernels and prints one CSV line per kernel:
+ * BENCH3,kernel,cycles_per_sample,ns_per_sample,max_error_q15
+ * A sample covers all three channels, the error is the largest over all channels and samples.
+ */
+static void bench_three_phase(void)
+{
+    char msg[120];
+    Uint16 k, ch;
+
+    for (ch = 0; ch < 3; ch++)
+    {
+        float lead = -120.0f * ch;
+        benchLeadPhase[ch] = dds_phase_word(lead);
+        benchLeadSine[ch] = sinf(lead * (M_PI / 180));
+        benchLeadCosine[ch] = cosf(lead * (M_PI / 180));
+    }
+    benchStep = dds_tuning_word(BENCH_THREE_PHASE_SIN, BENCH_THREE_PHASE_PWM);
+    benchStepSine = sinf((float) benchStep * BENCH_RADIANS_PER_PHASE);
+    benchStepCosine = cosf((float) benchStep * BENCH_RADIANS_PER_PHASE);
+
+    Uint32 overhead = bench_time_three_phase(kernel3_empty);
+
+    bench_msg(NEWLINE "BENCH3,kernel,cycles_per_sample,ns_per_sample,max_error_q15");
+    for (k = 0; k < sizeof(benchThreePhaseKernels) / sizeof(benchThreePhaseKernels[0]); k++)
+    {
+        const BenchThreePhaseKernel *kernel = &benchThreePhaseKernels[k];
+        char time[40];
+
+        benchRotator.count = DDS_ROTATOR_RESYNC;    // Start from the table
+        bench_format_time(time, (float) (int32) (bench_time_three_phase(kernel->sample) - overhead)
+                          / BENCH_TIMING_SAMPLES);
+        benchRotator.count = DDS_ROTATOR_RESYNC;
+        float maxError = bench_three_phase_error(kernel->sample);
+
+        sprintf(msg, NEWLINE "BENCH3,%s,%s,%.3f", kernel->name, time, maxError);
+        bench_msg(msg);
+    }
+}
+
+/*
+ * Generates the CMPA stream of one channel for the grid point and measures its spectrum with Goertzel
+ * filters at the fundamental and its harmonics (Hann window, whole sine periods where possible).
+ * The filters use Reinsch's form: 2cos(w) rounds to 2 at the low sine to carrier ratios of the grid.
+ * Stores the THD and the spurious free dynamic range over harmonics 2..BENCH_HARMONICS in dB.
+ */
+static void bench_distortion(const BenchKernel *kernel, float pwmWavFreq, float sinWavFreq,
+                             float *thd, float *sfdr)
+{
+    EPwmParams params = liveEpwmParams;
+    WaveformPlan plan;
+    float s[BENCH_HARMONICS + 1], d[BENCH_HARMONICS + 1], lambda[BENCH_HARMONICS + 1];
+    Uint16 h;
+
+    params.pwmWavFreq = pwmWavFreq;
+    params.sinWavFreq = sinWavFreq;
+    params.modulation_depth = 1.0;
+    params.offset = 0;
+    compile_waveform_plan(&params, &plan);
+
+    // Analyze a whole number of sine periods, at least BENCH_MIN_PERIODS of them and BENCH_MIN_SAMPLES samples
+    float samplesPerPeriod = plan.carrierFreq / sinWavFreq;
+    Uint32 periods = (Uint32) ceilf(BENCH_MIN_SAMPLES / samplesPerPeriod);
+    if (periods < BENCH_MIN_PERIODS)
+        periods = BENCH_MIN_PERIODS;
+    Uint32 count = (Uint32) (periods * samplesPerPeriod);
+    float cyclesPerSample = (float) plan.tuningWord / DDS_PHASE_FULL_SCALE;
+
+    for (h = 1; h <= BENCH_HARMONICS; h++)
+    {
+        float sine = sinf(M_PI * h * cyclesPerSample);
+        s[h] = d[h] = 0;
+        lambda[h] = -4 * sine * sine;
+    }
+
+    Uint32 i, phase = 0;
+    for (i = 0; i < count; i++)
+    {
+        float window = .5f - .5f * cosf(2 * M_PI * i / count);
+        float x = window * (float) ((Uint16) (plan.bias + plan.amplitude * kernel->sample(phase)) - plan.bias);
+        for (h = 1; h <= BENCH_HARMONICS; h++)
+        {
+            // Harmonics above the Nyquist frequency of the carrier are aliased, skip them
+            if (h * cyclesPerSample >= .5f)
+                continue;
+            d[h] += lambda[h] * s[h] + x;
+            s[h] += d[h];
+        }
+        phase += plan.tuningWord;
+    }
+
+    float fundamental = d[1] * d[1] - lambda[1] * s[1] * (s[1] - d[1]);
+    float harmonicSum = 0, harmonicMax = 0;
+    for (h = 2; h <= BENCH_HARMONICS; h++)
+    {
+        if (h * cyclesPerSample >= .5f)
+            break;
+        float power = d[h] * d[h] - lambda[h] * s[h] * (s[h] - d[h]);
+        harmonicSum += power;
+        if (power > harmonicMax)
+            harmonicMax = power;
+    }
+
+    // Floor at 1e-12 so a perfectly clean result still prints a number
+    *thd = 10 * log10f(fmaxf(harmonicSum, 1e-12f * fundamental) / fundamental);
+    *sfdr = 10 * log10f(fundamental / fmaxf(harmonicMax, 1e-12f * fundamental));
+}
+
+/*
+ * Effective number of bits of the compare stream of one channel against an exact sine, with the compare
+ * quantized to 1 / steps of a timer count (1 for CMPA, the MEP steps per count with HRPWM).
+ * Includes the kernel error, so it shows whichever of table and PWM resolution limits the output.
+ */
+static float bench_effective_bits(const BenchKernel *kernel, const WaveformPlan *plan, float steps)
+{
+    float errorPower = 0;
+    Uint32 i, phase = 0;
+
+    for (i = 0; i < BENCH_MIN_SAMPLES; i++)
+    {
+        float exact = plan->bias + plan->amplitude * SINE_TABLE_AMPLITUDE
+                * sinf((float) (phase >> 8) * (2 * M_PI / 16777216.0));
+        float counts = plan->bias + plan->amplitude * kernel->sample(phase);
+        float error = floorf(counts * steps) / steps - exact;
+        errorPower += error * error;
+        phase += plan->tuningWord;
+    }
+
+    float peak = plan->amplitude * SINE_TABLE_AMPLITUDE;
+    float signalPower = .5f * peak * peak;
+    return (10 * log10f(signalPower / fmaxf(errorPower / BENCH_MIN_SAMPLES, 1e-20f)) - 1.76f) / 6.02f;
+}
+
+// MEP steps per timer count for the HRPWM column, the calibrated value once HRPWM is running
+static float bench_mep_steps(void)
+{
+#ifdef HRPWM_MODE
+    if (MEP_ScaleFactor)
+    {
+        return MEP_ScaleFactor;
+    }
+#endif
+    return HRPWM_TYPICAL_MEP_STEPS;
+}
+
+/*
+ * Runs every kernel and prints one CSV line per kernel and valid grid point (params_valid()):
+ * BENCH,kernel,table_bits,cycles_per_sample,ns_per_sample,pwm_hz,sin_hz,freq_error_hz,thd_db,sfdr_db,enob_bits,enob_hrpwm_bits
+ * followed by the three phase kernels (see bench_three_phase()).
+ * The frequency error is the achieved sine frequency (TBPRD, plus TBPRDHR with HRPWM_MODE, and tuning word)
+ * minus the requested one. The effective bits are those of the CMPA stream and of the CMPA:CMPAHR stream.
+ */
+void kernel_benchmark_run(void)
+{
+    char msg[120];
+    Uint16 k, p, s;
+
+    Uint32 overhead = bench_time_kernel(kernel_empty);
+
+    bench_msg(NEWLINE "BENCH,kernel,table_bits,cycles_per_sample,ns_per_sample,pwm_hz,sin_hz,freq_error_hz,thd_db,sfdr_db,"
+              "enob_bits,enob_hrpwm_bits");
+
+    for (k = 0; k < sizeof(benchKernels) / sizeof(benchKernels[0]); k++)
+    {
+        const BenchKernel *kernel = &benchKernels[k];
+        if (kernel->tableBits)
+        {
+            bench_fill_table(kernel->tableBits);
+        }
+
+        char time[40];
+        bench_format_time(time, (float) (int32) (bench_time_kernel(kernel->sample) - overhead) / BENCH_TIMING_SAMPLES);
+
+        for (p = 0; p < sizeof(benchPwmFreqs) / sizeof(benchPwmFreqs[0]); p++)
+        {
+            for (s = 0; s < sizeof(benchSinFreqs) / sizeof(benchSinFreqs[0]); s++)
+            {
+                EPwmParams params = liveEpwmParams;
+                WaveformPlan plan;
+                float thd, sfdr;
+
+                // Skip the points the interfaces reject, e.g. a sine above half the carrier: its tuning
+                // word overflows and the spectrum has no fundamental
+                params.pwmWavFreq = benchPwmFreqs[p];
+                params.sinWavFreq = benchSinFreqs[s];
+                params.modulation_depth = 1.0;
+                params.offset = 0;
+                params.waveform = WAVEFORM_SINE;
+                if (!params_valid(&params))
+                {
+                    continue;
+                }
+                compile_waveform_plan(&params, &plan);
+
+                // Achieved sine frequency (planned time base and tuning word)
+                float freqError = plan.sineFreq - params.sinWavFreq;
+
+                bench_distortion(kernel, params.pwmWavFreq, params.sinWavFreq, &thd, &sfdr);
+                float enob = bench_effective_bits(kernel, &plan, 1);
+                float enobHrpwm = bench_effective_bits(kernel, &plan, bench_mep_steps());
+
+                sprintf(msg, NEWLINE "BENCH,%s,%u,%s,%.0f,%.0f,%.6f,%.2f,%.2f,%.2f,%.2f",
+                        kernel->name, kernel->tableBits, time,
+                        params.pwmWavFreq, params.sinWavFreq, freqError, thd, sfdr, enob, enobHrpwm);
+                bench_msg(msg);
+            }
+        }
+    }
+
+    bench_three_phase();
+
+    bench_msg(NEWLINE "BENCH,done" NEWLINE);
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include <string.h>
+#include "F2806x_Cla_defines.h"
+#include "cla_shared.h"
+#include "profile.h"
+#include "waveform.h"
+#include "telemetry.h"
+
+#ifdef CLA_OFFLOAD
+
+// Message RAMs, see F28069M.cmd
+#pragma DATA_SECTION(claCommand, "CpuToCla1MsgRAM");
+#pragma DATA_SECTION(claStatus, "Cla1ToCpuMsgRAM");
+ClaCommand claCommand;
+ClaStatus claStatus;
+
+// Set while CLA task 1 writes the compares instead of the ISR
+Uint16 claActive = 0;
+
+// Set by cla_start(), cleared by the ISR once it has handed the outputs over
+volatile Uint16 claStartPending = 0;
+
+// Phase the ISR resumes from after cla_stop()
+Uint16 claResumePending = 0;
+Uint32 claResumePhase = 0;
+
+/*
+ * Copies the CLA program and constants from flash to CLA RAM (RAML3, RAML2), maps RAML1 (sine table)
+ * and RAML2 (CLA variables) as CLA data RAM the CPU can still access, and routes the ePWM1 interrupt to
+ * task 1, which stays masked until cla_take_over(). Call after hal_system_init() and before the ePWM
+ * interrupt is enabled.
+ */
+void cla_init(void)
+{
+    Uint16 ch;
+
+    memcpy(&Cla1funcsRunStart, &Cla1funcsLoadStart, (Uint32) &Cla1funcsLoadSize);
+    memcpy(&Cla1ConstRunStart, &Cla1ConstLoadStart, (Uint32) &Cla1ConstLoadSize);
+
+    EALLOW;
+    SysCtrlRegs.PCLKCR3.bit.CLA1ENCLK = 1;
+    EDIS;
+
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        claCommand.epwmAddress[ch] = (Uint16) (Uint32) halEpwmChannels[ch].regs;
+    }
+
+    EALLOW;
+
+    // Task vectors are offsets from the start of the CLA program
+    Cla1Regs.MVECT1 = (Uint16) ((Uint32) &Cla1Task1 - (Uint32) &Cla1funcsRunStart);
+    Cla1Regs.MVECT8 = (Uint16) ((Uint32) &Cla1Task8 - (Uint32) &Cla1funcsRunStart);
+    Cla1Regs.MPISRCSEL1.bit.PERINT1SEL = CLA_INT1_EPWM1INT;
+
+    Cla1Regs.MMEMCFG.bit.PROGE = 1;     // RAML3 is CLA program RAM
+    Cla1Regs.MMEMCFG.bit.RAM0E = 1;     // RAML1 is CLA data RAM 0 (sine table)
+    Cla1Regs.MMEMCFG.bit.RAM1E = 1;     // RAML2 is CLA data RAM 1 (CLA variables)
+    Cla1Regs.MMEMCFG.bit.RAM0CPUE = 1;  // The ISR, the DMA tables and telemetry keep reading the sine table
+    Cla1Regs.MMEMCFG.bit.RAM1CPUE = 1;  // And the debugger the CLA variables
+
+    Cla1Regs.MCTL.bit.IACKE = 1;        // The CPU forces task 8
+    Cla1Regs.MIER.all = M_INT8;
+    EDIS;
+}
+
+// Returns 1 if the CLA can run the parameters: sine plans without HRPWM_MODE, no running or paused profile and no telemetry stream
+Uint16 cla_params_supported(const EPwmParams *params)
+{
+#ifdef HRPWM_MODE
+    return 0;   // The task writes CMPA only
+#else
+    return params->waveform == WAVEFORM_SINE && profileState != PROFILE_RUNNING && profileState != PROFILE_PAUSED
+            && profileState != PROFILE_STARTING && !telemetryPeriods;
+#endif
+}
+
+/*
+ * Hands the outputs to the CLA. The ISR passes its phase over at its next call, so it has to run the
+ * live plan already (wait_for_plan_update()). Waits for the handover, at most one PWM period.
+ */
+void cla_start(void)
+{
+    claStartPending = 1;
+    while (claStartPending)
+    {
+        hal_busy_wait();
+    }
+}
+
+/*
+ * Called from the ISR right after it wrote the compares of the next period and advanced the phase.
+ * The CLA writes the following compares from the next counter zero on, the ISR is no longer called.
+ */
+#pragma CODE_SECTION(cla_take_over, "ramfuncs");
+void cla_take_over(Uint32 phase, Uint32 cycleCount)
+{
+    claCommand.plan = liveWaveformPlan;
+    claCommand.phase = phase;
+    claCommand.cycleCount = cycleCount;
+    Cla1ForceTask8andWait();
+
+    // A flag left from before would run the task at once
+    EALLOW;
+    Cla1Regs.MICLR.bit.INT1 = 1;
+    Cla1Regs.MIER.bit.INT1 = 1;
+    EDIS;
+    PieCtrlRegs.PIEIER3.bit.INTx1 = 0;
+
+    claActive = 1;
+    claStartPending = 0;
+}
+
+/*
+ * Stops the CLA and re-enables the ISR, which resumes from the CLA's phase and cycle count.
+ * Waits for a task that is running to finish.
+ */
+void cla_stop(void)
+{
+    EALLOW;
+    Cla1Regs.MIER.bit.INT1 = 0;
+    EDIS;
+    while (Cla1Regs.MIRUN.bit.INT1)
+    {
+    }
+
+    claResumePhase = claStatus.phase;
+    carrierCycleCount = claStatus.cycleCount;
+    claResumePending = 1;
+    claActive = 0;
+
+    // The PIE flag was set at every counter zero while the CLA ran, only keep it if the CLA missed the
+    // last counter zero, so the ISR is not called twice in one period
+    DINT;
+    if (!EPwm1Regs.ETFLG.bit.INT)
+    {
+        PieCtrlRegs.PIEIFR3.bit.INTx1 = 0;
+    }
+    PieCtrlRegs.PIEIER3.bit.INTx1 = 1;
+    EINT;
+}
+
+#endif
@@ -0,0 +1,350 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include "command_parser.h"
+
+// Parser states
+#define STATE_START 0           // Nothing of the command fed yet
+#define STATE_PARAMETER 1       // Waiting for a parameter letter
+#define STATE_CHANNEL 2         // After A, waiting for the channel number
+#define STATE_VALUE 3           // After the parameter letter, waiting for the number
+#define STATE_SIGN 4            // After the minus sign
+#define STATE_NUMBER 5          // Reading digits
+#define STATE_FAILED 6          // Ignoring the rest of a failed command
+
+static const Uint32 powersOfTen[COMMAND_MAX_DIGITS + 1] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static const char * const errorMessages[] = {
+        "",
+        "Invalid character",
+        "Invalid channel after A",
+        "Parameter without a value",
+        "Number input has too many digits",
+        "Input has too many decimal points",
+        "Value out of bound",
+        "Modulation depth out of range for the modulation mode",
+        "Offset out of range",
+        "Empty command",
+        "Sin wave frequency must be below half the PWM frequency",
+        "Modulation mode must be a whole number"
+};
+
+// Starts a new command, parameters the command does not mention keep their values from params
+void command_parser_reset(CommandParser *parser, const EPwmParams *params)
+{
+    parser->state = STATE_START;
+    parser->values = 0;
+    parser->error = COMMAND_ERROR_NONE;
+    parser->errorChar = 0;
+    parser->params = *params;
+}
+
+// Returns 1 if no character of a command has been fed yet
+Uint16 command_parser_idle(const CommandParser *parser)
+{
+    return parser->state == STATE_START;
+}
+
+// Text for a COMMAND_ERROR_ code
+const char *command_parser_error_message(Uint16 error)
+{
+    return error < sizeof(errorMessages) / sizeof(errorMessages[0]) ? errorMessages[error] : "";
+}
+
+// Marks the command as failed, the rest up to the terminator is ignored
+static Uint16 fail(CommandParser *parser, Uint16 error, char c)
+{
+    parser->error = error;
+    parser->errorChar = c;
+    parser->state = STATE_FAILED;
+    return COMMAND_FAILED;
+}
+
+static Uint16 is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static Uint16 is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Selects the parameter of a letter and its range, returns 0 if the letter is no parameter
+static Uint16 select_parameter(CommandParser *parser, char c)
+{
+    switch (c)
+    {
+    case 'P':
+    case 'p':
+        parser->field = &parser->params.pwmWavFreq;
+        parser->min = PWMWAVFREQ_MIN;
+        parser->max = PWMWAVFREQ_MAX;
+        break;
+    case 'S':
+    case 's':
+        parser->field = &parser->params.sinWavFreq;
+        parser->min = SINWAVFREQ_MIN;
+        parser->max = SINWAVFREQ_MAX;
+        break;
+    case 'M':
+    case 'm':
+        parser->field = &parser->params.modulation_depth;
+        parser->min = MODULATION_DEPTH_MIN;
+        parser->max = MODULATION_DEPTH_INJECTED_MAX;
+        break;
+    case 'V':
+    case 'v':
+        parser->field = &parser->mode;
+        parser->min = MODULATION_SINE;
+        parser->max = MODULATION_SVPWM;
+        break;
+    case 'O':
+    case 'o':
+        parser->field = &parser->params.offset;
+        parser->min = -1;
+        parser->max = 1;
+        break;
+    case 'A':
+    case 'a':
+        // The channel number that follows picks the phase lead
+        parser->min = MIN_ANGLE;
+        parser->max = MAX_ANGLE;
+        parser->state = STATE_CHANNEL;
+        return 1;
+    default:
+        return 0;
+    }
+
+    parser->state = STATE_VALUE;
+    return 1;
+}
+
+// Starts reading a number for the selected parameter
+static void start_number(CommandParser *parser)
+{
+    parser->negative = 0;
+    parser->mantissa = 0;
+    parser->digits = 0;
+    parser->decimals = 0xFFFF;
+}
+
+// Adds one digit, the integer part is range checked right away so a long number fails at its first digit too many
+static Uint16 add_digit(CommandParser *parser, char c)
+{
+    if (parser->digits >= COMMAND_MAX_DIGITS)
+    {
+        return fail(parser, COMMAND_ERROR_DIGITS, c);
+    }
+
+    parser->mantissa = parser->mantissa * 10 + (c - '0');
+    parser->digits++;
+
+    if (parser->decimals == 0xFFFF)
+    {
+        if (parser->negative ? -(float) parser->mantissa < parser->min : (float) parser->mantissa > parser->max)
+        {
+            return fail(parser, COMMAND_ERROR_RANGE, c);
+        }
+    }
+    else
+    {
+        parser->decimals++;
+    }
+    return COMMAND_PENDING;
+}
+
+// Converts the finished number and stores it if it is in range
+static Uint16 finish_number(CommandParser *parser, char c)
+{
+    float value;
+
+    if (parser->digits == 0)
+    {
+        return fail(parser, COMMAND_ERROR_NO_VALUE, c);
+    }
+
+    value = (float) parser->mantissa;
+    if (parser->decimals != 0xFFFF)
+    {
+        value /= (float) powersOfTen[parser->decimals];
+    }
+    if (parser->negative)
+    {
+        value = -value;
+    }
+
+    if (value < parser->min || value > parser->max)
+    {
+        return fail(parser, COMMAND_ERROR_RANGE, c);
+    }
+
+    *parser->field = value;
+    parser->values++;
+    if (parser->field == &parser->mode)
+    {
+        parser->params.modulationMode = (Uint16) value;
+    }
+    parser->state = STATE_PARAMETER;
+    return COMMAND_PENDING;
+}
+
+// Checks the limits that depend on several parameters once the whole command is in
+static Uint16 finish_command(CommandParser *parser)
+{
+    float offsetLimit = offset_limit(&parser->params);
+
+    parser->state = STATE_START;
+
+    // A lone terminator (or only separators) changes nothing and is not confirmed
+    if (parser->values == 0)
+    {
+        parser->error = COMMAND_ERROR_EMPTY;
+        return COMMAND_INVALID;
+    }
+    if (!(parser->params.sinWavFreq < .5f * parser->params.pwmWavFreq))
+    {
+        parser->error = COMMAND_ERROR_NYQUIST;
+        return COMMAND_INVALID;
+    }
+    if (parser->params.modulation_depth > modulation_depth_max(&parser->params))
+    {
+        parser->error = COMMAND_ERROR_DEPTH;
+        return COMMAND_INVALID;
+    }
+    if (parser->params.offset > offsetLimit || parser->params.offset < -offsetLimit)
+    {
+        parser->error = COMMAND_ERROR_OFFSET;
+        return COMMAND_INVALID;
+    }
+    return COMMAND_VALID;
+}
+
+// Handles a character while waiting for a parameter letter
+static Uint16 parameter_char(CommandParser *parser, char c)
+{
+    if (c == COMMAND_TERMINATOR)
+    {
+        return finish_command(parser);
+    }
+    if (is_space(c) || c == ',' || c == '.')
+    {
+        parser->state = STATE_PARAMETER;
+        return COMMAND_PENDING;
+    }
+    if (!select_parameter(parser, c))
+    {
+        return fail(parser, COMMAND_ERROR_CHARACTER, c);
+    }
+    start_number(parser);
+    return COMMAND_PENDING;
+}
+
+/*
+ * Parses one character of a command.
+ * Returns COMMAND_FAILED for the character that makes the command invalid (parser->error tells why),
+ * COMMAND_VALID or COMMAND_INVALID for the terminator and COMMAND_PENDING for everything else.
+ * After the terminator the parser is ready for the next command on top of parser->params.
+ */
+Uint16 command_parser_feed(CommandParser *parser, char c)
+{
+    Uint16 result;
+
+    switch (parser->state)
+    {
+    case STATE_START:
+    case STATE_PARAMETER:
+        return parameter_char(parser, c);
+
+    case STATE_CHANNEL:
+        // A single digit, channel 1 to HAL_EPWM_CHANNELS
+        if (c >= '1' && c < '1' + HAL_EPWM_CHANNELS)
+        {
+            parser->field = &parser->params.phaseLead[c - '1'];
+            parser->state = STATE_VALUE;
+            return COMMAND_PENDING;
+        }
+        if (c == COMMAND_TERMINATOR)
+        {
+            parser->state = STATE_START;
+            parser->error = COMMAND_ERROR_CHANNEL;
+            return COMMAND_INVALID;
+        }
+        return fail(parser, COMMAND_ERROR_CHANNEL, c);
+
+    case STATE_VALUE:
+        if (is_space(c))
+        {
+            return COMMAND_PENDING;
+        }
+        if (c == '-')
+        {
+            parser->negative = 1;
+            parser->state = STATE_SIGN;
+            return COMMAND_PENDING;
+        }
+        // no break, the first digit or decimal point is read like the ones after the sign
+
+    case STATE_SIGN:
+        if (is_digit(c) || c == '.')
+        {
+            parser->state = STATE_NUMBER;
+            return command_parser_feed(parser, c);
+        }
+        if (c == COMMAND_TERMINATOR || c == ',' || is_space(c))
+        {
+            if (c == COMMAND_TERMINATOR)
+            {
+                parser->state = STATE_START;
+                parser->error = COMMAND_ERROR_NO_VALUE;
+                return COMMAND_INVALID;
+            }
+            return fail(parser, COMMAND_ERROR_NO_VALUE, c);
+        }
+        return fail(parser, COMMAND_ERROR_CHARACTER, c);
+
+    case STATE_NUMBER:
+        if (is_digit(c))
+        {
+            return add_digit(parser, c);
+        }
+        if (c == '.')
+        {
+            if (parser->field == &parser->mode)
+            {
+                return fail(parser, COMMAND_ERROR_NOT_INTEGER, c);
+            }
+            if (parser->decimals != 0xFFFF)
+            {
+                return fail(parser, COMMAND_ERROR_DECIMAL_POINTS, c);
+            }
+            parser->decimals = 0;
+            return COMMAND_PENDING;
+        }
+        if (c == COMMAND_TERMINATOR || c == ',' || is_space(c) || (c >= 'A' && c <= 'z'))
+        {
+            // The number ends at a separator, the terminator or the next parameter letter
+            result = finish_number(parser, c);
+            if (result != COMMAND_PENDING)
+            {
+                if (c == COMMAND_TERMINATOR)
+                {
+                    parser->state = STATE_START;
+                    return COMMAND_INVALID;
+                }
+                return result;
+            }
+            return c == ',' || is_space(c) ? COMMAND_PENDING : parameter_char(parser, c);
+        }
+        return fail(parser, COMMAND_ERROR_CHARACTER, c);
+
+    default:
+        // Failed, wait for the terminator
+        if (c == COMMAND_TERMINATOR)
+        {
+            parser->state = STATE_START;
+            return COMMAND_INVALID;
+        }
+        return COMMAND_PENDING;
+    }
+}
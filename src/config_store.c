@@ -0,0 +1,327 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include <stddef.h>
+#include <string.h>
+#include "config_store.h"
+#include "protocol.h"
+#include "waveform.h"
+
+#ifdef CONFIG_STORE
+#include "Flash2806x_API_Library.h"
+
+// Flash API load and run addresses (F28069M.cmd)
+extern Uint16 Flash28_API_LoadStart;
+extern Uint16 Flash28_API_LoadEnd;
+extern Uint16 Flash28_API_RunStart;
+
+// The two sectors the records alternate between
+static const Uint16 *const sectorStart[2] = { (const Uint16 *) CONFIG_SECTOR_G_START,
+                                              (const Uint16 *) CONFIG_SECTOR_H_START };
+static const Uint16 sectorMask[2] = { SECTORG, SECTORH };
+
+// Sector and slot the next record goes to, and whether the other sector has to be erased before it takes records
+static Uint16 activeSector = 0;
+static Uint16 nextSlot = 0;
+static Uint16 otherSectorDirty = 0;
+static Uint32 lastSequence = 0;
+
+// Newest valid record of each key, in flash
+static const ConfigRecord *current[CONFIG_KEYS];
+
+// Set by config_request_save() with the cycle of the request, cleared by config_service()
+static Uint16 savePending = 0;
+static Uint32 saveRequestCycle = 0;
+
+// Set when config_save() fails, cleared when it succeeds
+static Uint16 saveFailed = 0;
+
+static void load_records(void);
+
+// Copies the Flash API from flash to RAMM1, it cannot run from the flash it erases and programs, and loads the records
+void config_init(void)
+{
+#ifndef HAL_HOST    // The emulator of the host build (host/flash_sim.c) has nothing to copy
+    memcpy(&Flash28_API_RunStart, &Flash28_API_LoadStart,
+           (Uint32) &Flash28_API_LoadEnd - (Uint32) &Flash28_API_LoadStart);
+#endif
+
+    EALLOW;
+    Flash_CPUScaleFactor = SCALE_FACTOR;
+    Flash_CallbackPtr = NULL;
+    EDIS;
+
+    load_records();
+}
+
+// CRC16 (CCITT, see protocol.h) of every word of the record before the CRC, low byte first
+Uint16 config_record_crc(const ConfigRecord *record)
+{
+    const Uint16 *word = (const Uint16 *) record;
+    Uint16 crc = 0xFFFF;
+    Uint16 i;
+
+    for (i = 0; i < offsetof(ConfigRecord, crc) / sizeof(Uint16); i++)
+    {
+        crc = crc16_update(crc, word[i]);
+        crc = crc16_update(crc, word[i] >> 8);
+    }
+    return crc;
+}
+
+// Returns 1 if every word of the slot is erased
+static Uint16 slot_blank(const Uint16 *slot)
+{
+    Uint16 i;
+
+    for (i = 0; i < CONFIG_SLOT_WORDS; i++)
+    {
+        if (slot[i] != CONFIG_ERASED)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Returns 1 if the slot holds a complete record, a program cut short by a power loss fails the CRC
+static Uint16 slot_valid(const Uint16 *slot)
+{
+    const ConfigRecord *record = (const ConfigRecord *) slot;
+
+    return record->magic == CONFIG_RECORD_MAGIC && record->length == CONFIG_RECORD_WORDS
+            && record->key < CONFIG_KEYS && record->crc == config_record_crc(record);
+}
+
+// Erases a sector, interrupts are off for the whole erase, so only load_records() calls it at boot. Returns 1 on success
+static Uint16 erase_sector(Uint16 sector)
+{
+    FLASH_ST status;
+    Uint16 result;
+
+    DINT;
+    result = Flash_Erase(sectorMask[sector], &status);
+    EINT;
+    return result == STATUS_SUCCESS;
+}
+
+/*
+ * Programs a record into a slot. Only the PWM and DMA table interrupts stay enabled, their code and data
+ * are in RAM; the SCI and trigger ISRs run from flash and wait. Returns 1 on success
+ */
+static Uint16 program_record(Uint16 sector, Uint16 slot, ConfigRecord *record)
+{
+    FLASH_ST status;
+    Uint16 result;
+    Uint16 enabled = IER;
+
+    IER &= M_INT3 | M_INT7;
+    result = Flash_Program((Uint16 *) sectorStart[sector] + slot * CONFIG_SLOT_WORDS, (Uint16 *) record,
+                           CONFIG_RECORD_WORDS, &status);
+    IER |= enabled;
+    return result == STATUS_SUCCESS;
+}
+
+/*
+ * Appends a record of a key's parameters to the next slot of the active sector and makes it the key's
+ * current record. Returns 1 on success, 0 if the sector is full; a failed program leaves the slot unusable as well.
+ */
+static Uint16 append_record(Uint16 key, const EPwmParams *params)
+{
+    ConfigRecord record;
+    Uint16 slot;
+
+    memset(&record, 0, sizeof(record));
+    record.magic = CONFIG_RECORD_MAGIC;
+    record.length = CONFIG_RECORD_WORDS;
+    record.key = key;
+    record.sequence = lastSequence + 1;
+    record.params = *params;
+    record.crc = config_record_crc(&record);
+
+    if (nextSlot >= CONFIG_SLOTS)
+    {
+        return 0;
+    }
+    slot = nextSlot++;
+    if (!program_record(activeSector, slot, &record))
+    {
+        return 0;
+    }
+
+    lastSequence = record.sequence;
+    current[key] = (const ConfigRecord *) (sectorStart[activeSector] + slot * CONFIG_SLOT_WORDS);
+    return 1;
+}
+
+/*
+ * Copies the current record of every key that lives in the other sector into the active one. Returns 1
+ * once the other sector holds no current record any more and may be erased.
+ */
+static Uint16 carry_over(void)
+{
+    const Uint16 *other = sectorStart[activeSector ^ 1];
+    Uint16 key;
+
+    for (key = 0; key < CONFIG_KEYS; key++)
+    {
+        const Uint16 *words = (const Uint16 *) current[key];
+
+        if (words >= other && words < other + CONFIG_SECTOR_WORDS)
+        {
+            EPwmParams params = current[key]->params;
+
+            if (!append_record(key, &params))
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * Finds the newest valid record of each key and the first free slot after the newest record of all,
+ * carries the keys whose newest record is in the other sector over (a sector switch cut short by a power
+ * loss) and erases the other sector if anything was written to it. Runs at boot before the outputs
+ * start, the erase takes a while after a sector switch or an interrupted save.
+ */
+static void load_records(void)
+{
+    const ConfigRecord *newest = 0;
+    Uint16 used[2];
+    Uint16 sector, slot;
+
+    // From nothing, the host test boots more than once in a process
+    memset(current, 0, sizeof(current));
+    lastSequence = 0;
+    savePending = 0;
+    saveFailed = 0;
+
+    for (sector = 0; sector < 2; sector++)
+    {
+        used[sector] = 0;
+        for (slot = 0; slot < CONFIG_SLOTS; slot++)
+        {
+            const Uint16 *words = sectorStart[sector] + slot * CONFIG_SLOT_WORDS;
+            const ConfigRecord *record = (const ConfigRecord *) words;
+
+            // Records are appended, the next one goes after the last slot that is not erased
+            if (!slot_blank(words))
+            {
+                used[sector] = slot + 1;
+            }
+            if (slot_valid(words))
+            {
+                if (!current[record->key] || record->sequence > current[record->key]->sequence)
+                {
+                    current[record->key] = record;
+                }
+                if (!newest || record->sequence > newest->sequence)
+                {
+                    newest = record;
+                    activeSector = sector;
+                }
+            }
+        }
+    }
+
+    if (!newest)
+    {
+        activeSector = used[0] <= used[1] ? 0 : 1;
+    }
+    else
+    {
+        lastSequence = newest->sequence;
+    }
+    nextSlot = used[activeSector];
+    otherSectorDirty = used[activeSector ^ 1] && !(carry_over() && erase_sector(activeSector ^ 1));
+}
+
+/*
+ * Loads the newest saved parameters of a key into params. Returns 1 if a valid record within the
+ * parameter ranges was found, params is unchanged otherwise.
+ * Uploaded waveform tables are not saved, a record of a table output restores the sine.
+ */
+int config_get(Uint16 key, EPwmParams *params)
+{
+    EPwmParams restored;
+
+    if (key >= CONFIG_KEYS || !current[key])
+    {
+        return 0;
+    }
+
+    restored = current[key]->params;
+    if (restored.waveform != WAVEFORM_SINE)
+    {
+        restored.waveform = WAVEFORM_SINE;
+    }
+    if (!params_valid(&restored))
+    {
+        return 0;
+    }
+
+    *params = restored;
+    return 1;
+}
+
+/*
+ * Appends a record of a key's parameters unless they equal its current record. A full sector hands over
+ * to the other one, erased at boot, which takes the current record of every key before the new one; the
+ * full one waits for the next boot to be erased. Returns 1 if saved or unchanged, 0 if not saved: both
+ * sectors are full until the next boot, or programming failed.
+ */
+int config_save(Uint16 key, const EPwmParams *params)
+{
+    if (key >= CONFIG_KEYS)
+    {
+        return 0;
+    }
+    if (current[key] && memcmp(&current[key]->params, params, sizeof(EPwmParams)) == 0)
+    {
+        return 1;
+    }
+
+    if (nextSlot >= CONFIG_SLOTS)
+    {
+        // Erasing would hold the interrupts off for the whole erase, the other sector waits for the next boot
+        if (otherSectorDirty)
+        {
+            saveFailed = 1;
+            return 0;
+        }
+        activeSector ^= 1;
+        nextSlot = 0;
+        otherSectorDirty = 1;
+    }
+
+    // Also retries a carry over that failed, the other sector must not be erased before it is done
+    saveFailed = !(carry_over() && append_record(key, params));
+    return !saveFailed;
+}
+
+// Asks config_service() to save liveEpwmParams once the ISR runs them, called for every confirmed change
+void config_request_save(void)
+{
+    saveRequestCycle = hal_cycle_count();
+    savePending = 1;
+}
+
+/*
+ * Background save for the main loop, writes a record once a confirmed change is applied, no other change
+ * followed it for CONFIG_SAVE_SETTLE and it differs from the saved one. A failed save shows in config_status().
+ */
+void config_service(void)
+{
+    if (savePending && !plan_update_pending() && hal_cycle_count() - saveRequestCycle >= CONFIG_SAVE_SETTLE)
+    {
+        savePending = 0;
+        config_save(CONFIG_KEY_LIVE, &liveEpwmParams);
+    }
+}
+
+Uint16 config_status(void)
+{
+    return (savePending ? CONFIG_STATUS_SAVE_PENDING : 0) | (saveFailed ? CONFIG_STATUS_SAVE_FAILED : 0);
+}
+
+#endif
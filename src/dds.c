@@ -0,0 +1,45 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include <math.h>
+#include "dds.h"
+#include "cla_shared.h"
+
+// One sine period in Q15, filled at boot by dds_init_sine_table(), read by the ISR so kept in the hot data RAM block,
+// with CLA_OFFLOAD in CLA data RAM so the CLA task reads it too
+#ifdef CLA_OFFLOAD
+#pragma DATA_SECTION(sineTable, "ClaSineTable");
+#else
+#pragma DATA_SECTION(sineTable, "pwmdata");
+#endif
+int16 sineTable[SINE_TABLE_SIZE];
+
+/*
+ * Fills the sine lookup table with one full sine period.
+ * sinf() is only called here, never from the ISR.
+ */
+void dds_init_sine_table(void)
+{
+    Uint16 i;
+    for (i = 0; i < SINE_TABLE_SIZE; i++)
+    {
+        sineTable[i] = (int16) floorf(SINE_TABLE_AMPLITUDE * sinf(2 * M_PI * i / SINE_TABLE_SIZE) + 0.5f);
+    }
+}
+
+/*
+ * Calculates the phase accumulator increment per PWM period for the requested sine frequency.
+ * Computed once in long double precision when the parameters change, so the integer
+ * accumulator reproduces sinWavFreq exactly (to 2^-32 of the PWM frequency) over any run time.
+ */
+Uint32 dds_tuning_word(const float sinWavFreq, const float pwmWavFreq)
+{
+    return (Uint32) ((long double) sinWavFreq / pwmWavFreq * DDS_PHASE_FULL_SCALE + 0.5L);
+}
+
+/*
+ * Converts a phase angle in degrees (any sign) to a phase word.
+ * The signed 64-bit intermediate wraps negative and >= 360 degree angles modulo one period.
+ */
+Uint32 dds_phase_word(const float degrees)
+{
+    return (Uint32) (int64) ((long double) degrees / 360.0L * DDS_PHASE_FULL_SCALE);
+}
@@ -0,0 +1,64 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include <string.h>
+#include "hal.h"
+#include "pwm_dma.h"
+#include "cla_shared.h"
+
+// The CLA reaches the ePWM registers on peripheral frame 1 only, the DMA on frame 3 only (EPWMCFG)
+#if defined(CLA_OFFLOAD) && defined(DMA_TABLE_MODE)
+#error "CLA_OFFLOAD and DMA_TABLE_MODE exclude each other"
+#endif
+
+// ePWM modules driven by the generator, index 0 is ePWM1 (see HalEpwmChannel). In RAM (pwmdata, initialized
+// at boot) because the ISR looks up the register blocks every carrier period, flash would add wait states.
+#pragma DATA_SECTION(halEpwmChannels, "pwmdata");
+HalEpwmChannel halEpwmChannels[HAL_EPWM_CHANNELS] = {
+        { &EPwm1Regs, InitEPwm1Gpio, 0, 0 },
+        { &EPwm2Regs, InitEPwm2Gpio, 0, 120 },
+        { &EPwm3Regs, InitEPwm3Gpio, 0, 240 }
+        // Six phase (HAL_EPWM_CHANNELS 6, HAL_EPWM_GROUPS 2), a second set shifted by 30 degrees:
+        // { &EPwm4Regs, InitEPwm4Gpio, 1, 30 },
+        // { &EPwm5Regs, InitEPwm5Gpio, 1, 150 },
+        // { &EPwm6Regs, InitEPwm6Gpio, 1, 270 }
+};
+
+#ifndef HAL_HOST    // The host simulator (host/sim.c) has its own
+/*
+ * Initializes the system clocks, copies the ramfuncs section (ISR, waveform kernel and InitFlash)
+ * from flash to RAM, sets the flash wait states from RAM for the code that stays in flash,
+ * starts CPU timer 0 for hal_cycle_count(), moves the ePWM registers to the peripheral frame the DMA
+ * reaches (not with CLA_OFFLOAD, the CLA writes them then) and muxes the SCI A pins and the pins of every
+ * ePWM channel.
+ */
+void hal_system_init(void)
+{
+    Uint16 i;
+
+    InitSysCtrl();
+
+    memcpy(&RamfuncsRunStart, &RamfuncsLoadStart, (Uint32) &RamfuncsLoadEnd - (Uint32) &RamfuncsLoadStart);
+    InitFlash();
+
+    // CPU timer 0 runs free at SYSCLKOUT, no interrupt
+    CpuTimer0Regs.TCR.bit.TSS = 1;
+    CpuTimer0Regs.PRD.all = 0xFFFFFFFF;
+    CpuTimer0Regs.TPR.all = 0;
+    CpuTimer0Regs.TPRH.all = 0;
+    CpuTimer0Regs.TCR.bit.TIE = 0;
+    CpuTimer0Regs.TCR.bit.TRB = 1;
+    CpuTimer0Regs.TCR.bit.TSS = 0;
+
+#ifndef CLA_OFFLOAD
+    // ePWM on peripheral frame 3, where the DMA writes the compares (tables and decimation ring)
+    EALLOW;
+    SysCtrlRegs.EPWMCFG.bit.CONFIG = 1;
+    EDIS;
+#endif
+
+    InitSciaGpio();
+    for (i = 0; i < HAL_EPWM_CHANNELS; i++)
+    {
+        halEpwmChannels[i].initGpio();
+    }
+}
+#endif
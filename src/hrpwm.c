@@ -0,0 +1,62 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include "hrpwm.h"
+#include "hal.h"
+
+#ifdef HRPWM_MODE
+
+// Read and written by the SFO library
+int MEP_ScaleFactor = 0;
+volatile struct EPWM_REGS *ePWM[PWM_CH] = { &EPwm1Regs, &EPwm1Regs, &EPwm2Regs, &EPwm3Regs };
+
+// Set once hrpwm_init() has enabled the HRPWM clock and calibrated the MEP
+static Uint16 hrpwmReady = 0;
+
+/*
+ * Calibrates the MEP step with SFO() and configures the high resolution compare and period of every channel
+ * for up/down count: both edges are moved by the MEP, the high resolution registers load together with
+ * CMPA and TBPRD, and AUTOCONV scales CMPAHR / TBPRDHR by the calibrated step.
+ */
+void hrpwm_init(void)
+{
+    Uint16 i;
+
+    EALLOW;
+    SysCtrlRegs.PCLKCR0.bit.HRPWMENCLK = 1;
+    EDIS;
+
+    // The first calibration has to complete before the MEP scale factor is valid
+    while (SFO() == SFO_INCOMPLETE)
+    {
+    }
+
+    EALLOW;
+    for (i = 0; i < HAL_EPWM_CHANNELS; i++)
+    {
+        volatile struct EPWM_REGS *regs = halEpwmChannels[i].regs;
+
+        regs->HRCNFG.all = 0;
+        regs->HRCNFG.bit.EDGMODE = HR_BEP;          // MEP on both edges, needed for up/down count
+        regs->HRCNFG.bit.CTLMODE = HR_CMP;          // CMPAHR controls the edge position
+        regs->HRCNFG.bit.HRLOAD = HR_CTR_ZERO_PRD;  // Shadow load like CMPA
+        regs->HRCNFG.bit.AUTOCONV = 1;              // Hardware scales the 8-bit fraction to MEP steps
+
+        regs->HRPCTL.bit.HRPE = 1;                  // High resolution period
+        regs->HRPCTL.bit.TBPHSHRLOADE = 1;          // Keep the high resolution phase on sync
+    }
+    EDIS;
+
+    // Resynchronize so all modules start from the same high resolution phase
+    EPwm1Regs.TBCTL.bit.SWFSYNC = 1;
+    hrpwmReady = 1;
+}
+
+// Recalibrates the MEP step, SFO() runs one short step per call so this is safe in the main loop
+void hrpwm_service(void)
+{
+    if (hrpwmReady)
+    {
+        SFO();
+    }
+}
+
+#endif
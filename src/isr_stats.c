@@ -0,0 +1,55 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include "isr_stats.h"
+
+#ifdef ISR_PROFILING
+
+// Statistics written by the PWM ISR, read by the main loop
+#pragma DATA_SECTION(isrStats, "pwmdata");
+IsrStats isrStats = { .cyclesMin = 0xFFFFFFFF };
+volatile Uint16 isrStatsResetPending = 0;
+volatile Uint32 isrBusyCycles = 0;
+Uint32 isrStatsEntry;
+
+// CPU load of the last full window
+static float isrCpuLoad = 0;
+
+// Clears the statistics, the timestamps come from CPU timer 0 (hal_cycle_count()), started by hal_system_init()
+void isr_stats_init(void)
+{
+    isrStatsResetPending = 1;
+}
+
+// The ISR clears the statistics itself at its next call, so a reset never races a half written update
+void isr_stats_reset(void)
+{
+    isrStatsResetPending = 1;
+}
+
+/*
+ * Estimates the CPU load of the PWM ISR from the background loop: every ISR_STATS_LOAD_WINDOW cycles the
+ * time spent from ISR entries to exits is divided by the window.
+ * The difference of the two running totals stays correct across their wrap around.
+ */
+void isr_stats_service(void)
+{
+    static Uint32 windowStart = 0;
+    static Uint32 busyStart = 0;
+    Uint32 now = hal_cycle_count();
+    Uint32 elapsed = now - windowStart;
+
+    if (elapsed >= ISR_STATS_LOAD_WINDOW)
+    {
+        Uint32 busy = isrBusyCycles;
+        isrCpuLoad = (float) (busy - busyStart) / (float) elapsed;
+        busyStart = busy;
+        windowStart = now;
+    }
+}
+
+// Share of the CPU the PWM ISR used in the last full window (0-1)
+float isr_stats_cpu_load(void)
+{
+    return isrCpuLoad;
+}
+
+#endif
@@ -26,39 +26,101 @@
  * and handles user interaction through SCI for parameter configuration.
  * All main logic for PWM occurs at interrupt
  */
-
+#ifndef HAL_HOST    // The host simulator (host/sim.c) calls firmware_init() and firmware_poll() itself
 void main(void)
 {
-    // Calculate the ePWM timer period, .5 is used because timer is in up/down count mode
-    liveEpwmParams.epwmTimerTBPRD =
-            (Uint32)(0.5 * (PWMCLKFREQ / liveEpwmParams.pwmWavFreq));
+    firmware_init();
+
+    // Process user communications from serial port and write to global structure to reconfigure PWM to generate different sin wave outputs
+    // The SCI interrupts fill and drain the ring buffers, so this loop never blocks on the UART
+    while (FOREVER)
+    {
+        firmware_poll();
+    }
+}
+#endif
+
+void firmware_init(void)
+{
+    // Start every channel at the phase lead of its descriptor, calculate the ePWM timer period,
+    // compile the waveform plan, and fill the sine lookup table
+    init_phase_leads(&liveEpwmParams);
+    compile_waveform_plan(&liveEpwmParams, &liveWaveformPlan);
+    dds_init_sine_table();
 
     // Initializes struct that accepts user inputs by copying live pwm struct
     memcpy(&bufferEpwmParams, &liveEpwmParams, sizeof(EPwmParams));
 
     /// System initialization
-    InitSysCtrl();
-    InitSciaGpio();
+    hal_system_init();
     scia_fifo_init();
     scia_echoback_init();
-    InitEPwm1Gpio();
-    InitEPwm2Gpio();
-    InitEPwm3Gpio();
+#ifdef CONFIG_STORE
+    // Restore the last confirmed parameters, the outputs start with them below instead of waiting for a command
+    config_init();
+    int restored = config_get(CONFIG_KEY_LIVE, &liveEpwmParams);
+    memcpy(&bufferEpwmParams, &liveEpwmParams, sizeof(EPwmParams));
+#endif
+    preset_init();      // Compile the saved preset slots
+#ifdef ISR_PROFILING
+    isr_stats_init();   // Clear the statistics before the first PWM interrupt
+#endif
+    dma_init();         // Configure the DMA channels once, the ISR only points them at new compares
+#ifdef CLA_OFFLOAD
+    cla_init();         // Load the CLA before the ePWM interrupt is enabled
+#endif
     init_epwm_interrupts();
+    init_scia_interrupts();
+    init_preset_trigger_interrupt();
+#ifdef CONFIG_STORE
+    if (restored)
+    {
+        apply_live_params();    // The first call starts the outputs
+    }
+#endif
+
+#ifdef KERNEL_BENCHMARK
+    kernel_benchmark_run(); // Time and measure the waveform kernels, results are sent as CSV
+#endif
 
     print_welcome_screen(); // Print the welcome message
+}
 
+void firmware_poll(void)
+{
     Uint16 ReceivedChar;
 
-    // Process user communications from serial port and write to global structure to reconfigure PWM to generate different sin wave outputs
-    while (FOREVER)
+    protocol_service();     // Reply to a received frame once there is TX room, drop a frame that stalled
+
+    // A received frame waiting for room for its reply holds back the next bytes
+    if (!protocol_reply_pending() && scia_read(&ReceivedChar))
     {
-        // Wait for a character to be received
-        while (SciaRegs.SCIFFRX.bit.RXFFST < 1)
+        // Binary frames start with a sync byte that is never part of an ASCII command
+        if (protocol_busy() || ReceivedChar == PROTOCOL_SYNC)
         {
+            protocol_receive_byte(ReceivedChar);
+        }
+        else if (ReceivedChar >= PRESET_BYTE_FIRST && ReceivedChar < PRESET_BYTE_FIRST + PRESET_SLOTS)
+        {
+            // Neither a sync nor ASCII, switches to a preset slot at the next period (empty slots are ignored)
+            preset_activate(ReceivedChar - PRESET_BYTE_FIRST, PLAN_APPLY_NEXT_PERIOD, 0);
+        }
+        else
+        {
+            handle_received_char(ReceivedChar);
         }
-        ReceivedChar = SciaRegs.SCIRXBUF.all;  // Read received character from buffer
-        handle_received_char(ReceivedChar);
     }
-
+    scia_service();
+    profile_service();
+    telemetry_service();
+    preset_service();   // Switch to the armed preset slot after a trigger edge
+#ifdef CONFIG_STORE
+    config_service();   // Save confirmed parameters to flash
+#endif
+#ifdef HRPWM_MODE
+    hrpwm_service();    // Track the MEP step over temperature and voltage
+#endif
+#ifdef ISR_PROFILING
+    isr_stats_service();
+#endif
 }
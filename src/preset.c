@@ -0,0 +1,145 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include "preset.h"
+#include "config_store.h"
+#include "sci.h"
+
+// Stored slots, each with the plan compiled from its parameters
+static Preset presets[PRESET_SLOTS];
+
+// Slot the trigger input activates, and the flag its ISR sets
+static Uint16 armedSlot = PRESET_NONE;
+volatile Uint16 presetTriggerPending = 0;
+
+// Validates the parameters and compiles them into the slot, returns 1 if they are within range
+static int preset_compile(Uint16 slot, const EPwmParams *params)
+{
+    Preset *preset = &presets[slot];
+
+    if (!params_valid(params))
+    {
+        return 0;
+    }
+
+    preset->params = *params;
+    compile_waveform_plan(&preset->params, &preset->plan);
+    preset->stored = 1;
+    return 1;
+}
+
+// Loads the slots saved in flash, an empty or invalid record leaves the slot empty
+void preset_init(void)
+{
+#ifdef CONFIG_STORE
+    EPwmParams params;
+    Uint16 slot;
+
+    for (slot = 0; slot < PRESET_SLOTS; slot++)
+    {
+        if (config_get(CONFIG_KEY_PRESET(slot), &params))
+        {
+            preset_compile(slot, &params);
+        }
+    }
+#endif
+}
+
+/*
+ * Stores a parameter set in a slot, the outputs are left alone. With CONFIG_STORE the slot is saved in
+ * flash right away, a failed save shows in config_status().
+ * Returns 1 if stored, 0 for an invalid slot or parameters out of range.
+ */
+int preset_store(Uint16 slot, const EPwmParams *params)
+{
+    if (slot >= PRESET_SLOTS || !preset_compile(slot, params))
+    {
+        return 0;
+    }
+
+#ifdef CONFIG_STORE
+    config_save(CONFIG_KEY_PRESET(slot), &presets[slot].params);
+#endif
+    return 1;
+}
+
+int preset_ready(Uint16 slot)
+{
+    return slot < PRESET_SLOTS && presets[slot].stored;
+}
+
+/*
+ * Makes a stored slot the live parameter set and hands its plan to the ISR at the given point, see
+ * schedule_live_params(). Check preset_ready() first, an empty slot leaves the outputs alone and
+ * returns the sequence of the plan the ISR runs.
+ */
+Uint16 preset_activate(Uint16 slot, Uint16 when, Uint32 cycle)
+{
+    if (!preset_ready(slot))
+    {
+        return plan_applied_sequence();
+    }
+
+    liveEpwmParams = presets[slot].params;
+    live_params_changed();      // Keep the ASCII interface in step
+    return schedule_live_plan(&presets[slot].plan, when, cycle);
+}
+
+// Selects the slot the trigger input activates, returns 0 for an empty or invalid slot
+int preset_arm(Uint16 slot)
+{
+    if (slot != PRESET_NONE && !preset_ready(slot))
+    {
+        return 0;
+    }
+
+    armedSlot = slot;
+    presetTriggerPending = 0;   // An edge from before the slot was armed does not count
+    return 1;
+}
+
+/*
+ * XINT1 on PRESET_TRIGGER_GPIO: input with pull up, qualified over 6 samples so a bouncing contact
+ * does not retrigger, interrupt on the falling edge.
+ */
+void init_preset_trigger_interrupt(void)
+{
+    EALLOW; // Enables access to emulation and other protected registers
+    GpioCtrlRegs.GPAMUX1.bit.GPIO12 = 0;        // GPIO
+    GpioCtrlRegs.GPADIR.bit.GPIO12 = 0;         // Input
+    GpioCtrlRegs.GPAPUD.bit.GPIO12 = 0;         // Pull up enabled
+    GpioCtrlRegs.GPACTRL.bit.QUALPRD1 = 0xFF;   // GPIO8-15 sample period 510 SYSCLKOUT
+    GpioCtrlRegs.GPAQSEL1.bit.GPIO12 = 2;       // 6 samples
+    GpioIntRegs.GPIOXINT1SEL.bit.GPIOSEL = PRESET_TRIGGER_GPIO;
+    PieVectTable.XINT1 = &preset_trigger_isr;
+    EDIS; // Disable access to emulation space and other protected registers
+
+    XIntruptRegs.XINT1CR.bit.POLARITY = 0;      // Falling edge
+    XIntruptRegs.XINT1CR.bit.ENABLE = 1;
+
+    // Enable XINT1 in the PIE: Group 1 interrupt 4
+    PieCtrlRegs.PIEIER1.bit.INTx4 = 1;
+
+    IER |= M_INT1; // Enable CPU INT1 which is connected to XINT1
+}
+
+// Background trigger work for the main loop, activates the armed slot from the next period on
+void preset_service(void)
+{
+    if (presetTriggerPending)
+    {
+        presetTriggerPending = 0;
+        if (armedSlot != PRESET_NONE)
+        {
+            preset_activate(armedSlot, PLAN_APPLY_NEXT_PERIOD, 0);
+        }
+    }
+}
+
+/*
+ * Interrupt service routine for XINT1.
+ * Only flags the edge, the slot is activated by preset_service() in the main loop.
+ */
+__interrupt void preset_trigger_isr(void)
+{
+    presetTriggerPending = 1;
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP1;
+}
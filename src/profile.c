@@ -0,0 +1,306 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include "profile.h"
+#include "pwm_dma.h"
+#include "cla_shared.h"
+#include "sci.h"
+
+// Segment steps precomputed by profile_start(), the ISR only adds them
+typedef struct
+{
+    Uint32 targetTuningWord;
+    float targetAmplitude;
+    int32 tuningStep;           // Added every tick during the ramp, the target is written exactly on the last one
+    float amplitudeStep;
+    Uint32 rampTicks;
+    Uint32 holdTicks;
+} ProfileStep;
+
+// Segments as loaded by the user
+static ProfileSegment profileSegments[PROFILE_MAX_SEGMENTS];
+static Uint16 segmentCount = 0;
+
+// V/f line the depth follows for PROFILE_DEPTH_FOLLOW_VF targets
+static Uint16 vfEnabled = 0;
+static float vfBoost = 0;
+static float vfSlope = 0;
+
+// Playback state, shared with the ISR
+#pragma DATA_SECTION(profileSteps, "pwmdata");
+#pragma DATA_SECTION(profileState, "pwmdata");
+static ProfileStep profileSteps[PROFILE_MAX_SEGMENTS];
+static ProfileStep loopStep;    // First segment ramping from the last target when looping
+volatile Uint16 profileState = PROFILE_IDLE;
+static volatile Uint16 segmentIndex = 0;
+static Uint32 rampRemaining = 0;
+static Uint32 holdRemaining = 0;
+static Uint16 loopProfile = 0;
+static Uint16 looped = 0;          // Set once the profile has wrapped back to the first segment
+
+/*
+ * Stores a segment. Segments are loaded in order, index 0 starts a new list.
+ * Returns 1 if stored, 0 if the index is out of order or full, or the profile is playing.
+ */
+int profile_load_segment(Uint16 index, const ProfileSegment *segment)
+{
+    if (index >= PROFILE_MAX_SEGMENTS || index > segmentCount
+            || profileState == PROFILE_RUNNING || profileState == PROFILE_PAUSED)
+    {
+        return 0;
+    }
+
+    profileSegments[index] = *segment;
+    segmentCount = index + 1;
+    return 1;
+}
+
+// Sets the V/f line (depth = boost + slope * sinWavFreq) used by PROFILE_DEPTH_FOLLOW_VF targets
+int profile_set_vf(Uint16 enable, float boost, float slope)
+{
+    if (profileState == PROFILE_RUNNING || profileState == PROFILE_PAUSED)
+    {
+        return 0;
+    }
+
+    vfEnabled = enable;
+    vfBoost = boost;
+    vfSlope = slope;
+    return 1;
+}
+
+// Modulation depth at the end of a segment
+static float segment_depth(const ProfileSegment *segment)
+{
+    if (segment->targetDepth != PROFILE_DEPTH_FOLLOW_VF)
+    {
+        return segment->targetDepth;
+    }
+
+    float depth = vfEnabled ? vfBoost + vfSlope * segment->targetSinFreq : liveEpwmParams.modulation_depth;
+    if (depth < MODULATION_DEPTH_MIN)
+        depth = MODULATION_DEPTH_MIN;
+    if (depth > modulation_depth_max(&liveEpwmParams))
+        depth = modulation_depth_max(&liveEpwmParams);
+    return depth;
+}
+
+// Converts milliseconds to profile ticks at the given ISR rate
+static Uint32 ms_to_ticks(Uint32 ms, float isrFreq)
+{
+    return (Uint32) ((float) ms * isrFreq / (1000.0 * PROFILE_DECIMATION) + 0.5);
+}
+
+// Precomputes the steps that take a segment from the given start values to its target at the given ISR rate
+static void compile_step(ProfileStep *step, const ProfileSegment *segment,
+                         Uint32 startTuningWord, float startAmplitude, float isrFreq)
+{
+    EPwmParams target = liveEpwmParams;
+    WaveformPlan targetPlan;
+
+    target.sinWavFreq = segment->targetSinFreq;
+    target.modulation_depth = segment_depth(segment);
+    compile_waveform_plan(&target, &targetPlan);
+
+    step->targetTuningWord = targetPlan.tuningWord;
+    step->targetAmplitude = targetPlan.amplitude;
+    step->rampTicks = ms_to_ticks(segment->rampMs, isrFreq);
+    step->holdTicks = ms_to_ticks(segment->holdMs, isrFreq);
+
+    if (step->rampTicks)
+    {
+        step->tuningStep = (int32) (targetPlan.tuningWord - startTuningWord) / (int32) step->rampTicks;
+        step->amplitudeStep = (targetPlan.amplitude - startAmplitude) / step->rampTicks;
+    }
+    else
+    {
+        step->tuningStep = 0;
+        step->amplitudeStep = 0;
+    }
+}
+
+/*
+ * Validates every segment against the live parameters, precomputes the integer steps of each
+ * segment and starts playback from the values the outputs have now.
+ * Returns 1 if started, 0 if there are no segments, a target is out of range or a parameter update is
+ * still pending (the start values would not be the ones the outputs run, see plan_update_pending()).
+ */
+int profile_start(Uint16 loop)
+{
+    Uint16 i;
+    float maxSinFreq = 0;
+    WaveformPlan plan;
+
+    if (segmentCount == 0 || plan_update_pending())
+    {
+        return 0;
+    }
+
+    for (i = 0; i < segmentCount; i++)
+    {
+        EPwmParams target = liveEpwmParams;
+        target.sinWavFreq = profileSegments[i].targetSinFreq;
+        target.modulation_depth = segment_depth(&profileSegments[i]);
+        if (!params_valid(&target))
+        {
+            return 0;
+        }
+        if (target.sinWavFreq > maxSinFreq)
+        {
+            maxSinFreq = target.sinWavFreq;
+        }
+    }
+
+    // The ISR stops touching the plan before the steps are rewritten, and the plan scheduled below
+    // leaves the outputs with the ISR (see schedule_live_params())
+    profileState = PROFILE_STARTING;
+
+#ifdef DMA_TABLE_MODE
+    // The profile is advanced from the PWM ISR, so the ISR takes the outputs back from the DMA
+    if (dmaTableModeActive)
+    {
+        dma_stop_table_mode();
+    }
+#endif
+#ifdef CLA_OFFLOAD
+    // And from the CLA
+    if (claActive)
+    {
+        cla_stop();
+    }
+#endif
+
+    /*
+     * The ISR ramps the tuning word of the live plan but keeps its ISR decimation, which was chosen for
+     * the sine frequency the outputs have now. Lower it first to what the highest target allows, so the
+     * interpolation between decimated ISR calls stays within DECIMATION_MAX_ERROR all through the profile.
+     * The ISR switches to it before its first profile tick, the steps are compiled for its ISR rate.
+     */
+    plan = liveWaveformPlan;
+    limit_plan_decimation(&plan, maxSinFreq);
+    if (plan.interruptDivisor != liveWaveformPlan.interruptDivisor)
+    {
+        schedule_live_plan(&plan, PLAN_APPLY_NEXT_PERIOD, 0);
+    }
+
+    // Each segment ramps from the previous target, the first one from the live plan
+    Uint32 tuningWord = plan.tuningWord;
+    float amplitude = plan.amplitude;
+    for (i = 0; i < segmentCount; i++)
+    {
+        compile_step(&profileSteps[i], &profileSegments[i], tuningWord, amplitude, plan.isrFreq);
+        tuningWord = profileSteps[i].targetTuningWord;
+        amplitude = profileSteps[i].targetAmplitude;
+    }
+    compile_step(&loopStep, &profileSegments[0], tuningWord, amplitude, plan.isrFreq);
+
+    loopProfile = loop;
+    looped = 0;
+    segmentIndex = 0;
+    rampRemaining = profileSteps[0].rampTicks;
+    holdRemaining = profileSteps[0].holdTicks;
+    profileState = PROFILE_RUNNING;
+    return 1;
+}
+
+// Pauses (1) or resumes (0) the profile, the outputs hold their current values while paused
+void profile_pause(Uint16 pause)
+{
+    if (pause && profileState == PROFILE_RUNNING)
+    {
+        profileState = PROFILE_PAUSED;
+    }
+    else if (!pause && profileState == PROFILE_PAUSED)
+    {
+        profileState = PROFILE_RUNNING;
+    }
+}
+
+// Stops the profile, the outputs stay at the values reached
+void profile_stop(void)
+{
+    profileState = PROFILE_IDLE;
+}
+
+// Index of the segment being played
+Uint16 profile_segment_index(void)
+{
+    return segmentIndex;
+}
+
+// Sine frequency and modulation depth the outputs are at, read back from the live plan
+void profile_current(float *sinWavFreq, float *modulationDepth)
+{
+    float period = (float) liveWaveformPlan.timerPeriod;
+
+    *sinWavFreq = (float) ((long double) liveWaveformPlan.tuningWord / DDS_PHASE_FULL_SCALE
+            * liveWaveformPlan.carrierFreq);
+    *modulationDepth = -liveWaveformPlan.amplitude * SINE_TABLE_AMPLITUDE / (.5 * period);
+}
+
+/*
+ * Copies the sine frequency and modulation depth the profile has reached back into
+ * liveEpwmParams (and bufferEpwmParams, see live_params_changed()), so the ASCII interface and GET_PARAMS show them.
+ */
+void profile_sync_params(void)
+{
+    profile_current(&liveEpwmParams.sinWavFreq, &liveEpwmParams.modulation_depth);
+    live_params_changed();
+}
+
+// Background profile work for the main loop, syncs the live parameters once a profile has finished
+void profile_service(void)
+{
+    if (profileState == PROFILE_DONE)
+    {
+        profile_sync_params();
+        profileState = PROFILE_IDLE;
+    }
+}
+
+/*
+ * Advances the profile by one tick: one step of the ramp, one tick of the hold,
+ * or the move to the next segment. Only additions and compares, called from the PWM ISR.
+ */
+#pragma CODE_SECTION(profile_tick, "ramfuncs");
+void profile_tick(WaveformPlan *plan)
+{
+    const ProfileStep *step = (segmentIndex == 0 && looped) ? &loopStep : &profileSteps[segmentIndex];
+
+    if (rampRemaining)
+    {
+        plan->tuningWord += (Uint32) step->tuningStep;
+        plan->amplitude += step->amplitudeStep;
+
+        // Land exactly on the target, the integer steps leave a small remainder
+        if (--rampRemaining == 0)
+        {
+            plan->tuningWord = step->targetTuningWord;
+            plan->amplitude = step->targetAmplitude;
+        }
+        return;
+    }
+
+    if (holdRemaining)
+    {
+        holdRemaining--;
+        return;
+    }
+
+    // Next segment
+    if (++segmentIndex >= segmentCount)
+    {
+        if (!loopProfile)
+        {
+            segmentIndex = segmentCount - 1;
+            profileState = PROFILE_DONE;
+            return;
+        }
+
+        // From the second pass on the first segment ramps from the last target
+        segmentIndex = 0;
+        looped = 1;
+    }
+
+    step = (segmentIndex == 0 && looped) ? &loopStep : &profileSteps[segmentIndex];
+    rampRemaining = step->rampTicks;
+    holdRemaining = step->holdTicks;
+}
@@ -0,0 +1,864 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include "protocol.h"
+#include "sci.h"
+#include "pwm_dma.h"
+#include "config_store.h"
+
+// Frame parser states
+typedef enum
+{
+    WAIT_SYNC,
+    WAIT_LENGTH,
+    WAIT_OPCODE,
+    WAIT_PAYLOAD,
+    WAIT_CRC_HIGH,
+    WAIT_CRC_LOW,
+    WAIT_REPLY_ROOM     // Frame complete, runs once its reply fits the TX ring buffer
+} ProtocolState;
+
+static ProtocolState state = WAIT_SYNC;
+static Uint16 frameLength;
+static Uint16 frameOpcode;
+static Uint16 framePayload[PROTOCOL_MAX_PAYLOAD];  // One byte per element
+static Uint16 payloadIndex;
+static Uint16 frameCrc;
+static Uint16 receivedCrc;
+static Uint32 lastByteCycle;    // hal_cycle_count() at the last byte of the frame being received
+static Uint16 frameError;       // NACK error code of the frame waiting for TX room, 0 runs the command
+
+// Reply being built and its running CRC
+static Uint16 replyCrc;
+
+// Reinterprets the bits of a float as a Uint32 and back
+typedef union
+{
+    float f;
+    Uint32 u;
+} FloatBits;
+
+// Adds one byte to a CRC16 (CCITT, polynomial 0x1021)
+Uint16 crc16_update(Uint16 crc, Uint16 byte)
+{
+    Uint16 i;
+    crc ^= (byte & 0xFF) << 8;
+    for (i = 0; i < 8; i++)
+    {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// Returns 1 while a frame is partly received, the main loop then sends every byte here
+int protocol_busy(void)
+{
+    return state != WAIT_SYNC;
+}
+
+// Returns 1 while a complete frame waits for room for its reply, the main loop reads no byte until then
+int protocol_reply_pending(void)
+{
+    return state == WAIT_REPLY_ROOM;
+}
+
+// Reads a little endian Uint16 / Uint32 / float from the payload
+static Uint16 payload_u16(Uint16 index)
+{
+    return framePayload[index] | (framePayload[index + 1] << 8);
+}
+
+static Uint32 payload_u32(Uint16 index)
+{
+    return (Uint32) payload_u16(index) | ((Uint32) payload_u16(index + 2) << 16);
+}
+
+static float payload_float(Uint16 index)
+{
+    FloatBits bits;
+    bits.u = payload_u32(index);
+    return bits.f;
+}
+
+// Sends one reply byte and adds it to the reply CRC
+static void reply_byte(Uint16 byte)
+{
+    byte &= 0xFF;
+    replyCrc = crc16_update(replyCrc, byte);
+    scia_xmit(byte);
+}
+
+static void reply_float(float value)
+{
+    FloatBits bits;
+    bits.f = value;
+    reply_byte(bits.u);
+    reply_byte(bits.u >> 8);
+    reply_byte(bits.u >> 16);
+    reply_byte(bits.u >> 24);
+}
+
+// Starts a reply frame, payload is length bytes including the request opcode
+static void reply_begin(Uint16 opcode, Uint16 length)
+{
+    scia_xmit(PROTOCOL_SYNC);
+    replyCrc = 0xFFFF;
+    reply_byte(length);
+    reply_byte(opcode);
+    reply_byte(frameOpcode);
+}
+
+static void reply_end(void)
+{
+    Uint16 crc = replyCrc;
+    scia_xmit(crc >> 8);
+    scia_xmit(crc & 0xFF);
+}
+
+static void reply_nack(Uint16 error)
+{
+    reply_begin(OPCODE_NACK, 2);
+    reply_byte(error);
+    reply_end();
+}
+
+static void reply_ack(void)
+{
+    reply_begin(OPCODE_ACK, 1);
+    reply_end();
+}
+
+/*
+ * Reads a field mask and the masked parameters from the payload, starting at the given byte,
+ * over a copy of the live parameters and range checks all of them together.
+ * Returns 0 if the parameters are valid, the NACK error code otherwise.
+ */
+static Uint16 parse_params(EPwmParams *params, Uint16 start)
+{
+    float *fields[PARAM_COUNT] = { &params->pwmWavFreq, &params->sinWavFreq, &params->modulation_depth,
+                                   &params->offset };
+    Uint16 mask, bit, index = start + 2;
+
+    for (bit = 0; bit < HAL_EPWM_CHANNELS; bit++)
+    {
+        fields[4 + bit] = &params->phaseLead[bit];
+    }
+
+    if (frameLength < start + 2)
+    {
+        return NACK_BAD_LENGTH;
+    }
+
+    *params = liveEpwmParams;
+    mask = payload_u16(start);
+    for (bit = 0; bit < PARAM_COUNT; bit++)
+    {
+        if (mask & (1 << bit))
+        {
+            if (index + 4 > frameLength)
+            {
+                return NACK_BAD_LENGTH;
+            }
+            *fields[bit] = payload_float(index);
+            index += 4;
+        }
+    }
+
+    if (index != frameLength)
+    {
+        return NACK_BAD_LENGTH;
+    }
+
+    if (!params_valid(params))
+    {
+        return NACK_OUT_OF_RANGE;
+    }
+    return 0;
+}
+
+/*
+ * Sets the masked subset of parameters atomically: all of them are range checked together
+ * and then applied in one hitless update, or none of them is.
+ */
+static void set_params(void)
+{
+    EPwmParams params;
+    Uint16 error = parse_params(&params, 0);
+
+    if (error)
+    {
+        reply_nack(error);
+        return;
+    }
+
+    liveEpwmParams = params;
+    live_params_changed();      // Keep the ASCII interface in step
+    apply_live_params();
+    reply_ack();
+}
+
+/*
+ * Like set_params(), but all channels switch together at the requested point: the next period, the next
+ * rising zero crossing of channel 1 or a carrier cycle count. The ACK carries the update's sequence number.
+ */
+static void schedule_params(void)
+{
+    EPwmParams params;
+    Uint16 when, sequence;
+    Uint16 error = parse_params(&params, 6);
+
+    if (error)
+    {
+        reply_nack(error);
+        return;
+    }
+
+    when = payload_u16(0);
+    if (when > PLAN_APPLY_AT_CYCLE)
+    {
+        reply_nack(NACK_OUT_OF_RANGE);
+        return;
+    }
+
+    liveEpwmParams = params;
+    live_params_changed();      // Keep the ASCII interface in step
+    sequence = schedule_live_params(when, payload_u32(2));
+
+    reply_begin(OPCODE_ACK, 3);
+    reply_byte(sequence);
+    reply_byte(sequence >> 8);
+    reply_end();
+}
+
+// Replies with the state of the parameter mailbox and the carrier cycle count, never waits for the ISR
+static void plan_status(void)
+{
+    Uint16 pending = plan_update_pending();
+    Uint16 sequence = plan_applied_sequence();
+    Uint32 cycle = carrierCycleCount;
+    Uint32 appliedCycle = planAppliedCycle;
+    Uint16 saved = 0;
+
+#ifdef CONFIG_STORE
+    saved = config_status();
+#endif
+#ifdef DMA_TABLE_MODE
+    // The ISR does not count while the DMA writes the compares
+    if (dmaTableModeActive)
+    {
+        cycle = dma_table_cycle_count();
+    }
+#endif
+
+    reply_begin(OPCODE_ACK, 15);
+    reply_byte(pending);
+    reply_byte(pending >> 8);
+    reply_byte(sequence);
+    reply_byte(sequence >> 8);
+    reply_byte(cycle);
+    reply_byte(cycle >> 8);
+    reply_byte(cycle >> 16);
+    reply_byte(cycle >> 24);
+    reply_byte(appliedCycle);
+    reply_byte(appliedCycle >> 8);
+    reply_byte(appliedCycle >> 16);
+    reply_byte(appliedCycle >> 24);
+    reply_byte(saved);
+    reply_byte(saved >> 8);
+    reply_end();
+}
+
+// Replies with all user facing parameters in EPwmParams order, one phase lead per channel
+static void get_params(void)
+{
+    Uint16 ch;
+
+    reply_begin(OPCODE_ACK, 1 + 4 * PARAM_COUNT);
+    reply_float(liveEpwmParams.pwmWavFreq);
+    reply_float(liveEpwmParams.sinWavFreq);
+    reply_float(liveEpwmParams.modulation_depth);
+    reply_float(liveEpwmParams.offset);
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        reply_float(liveEpwmParams.phaseLead[ch]);
+    }
+    reply_end();
+}
+
+// Replies with the frequencies and time base the timer planner achieved for the live parameters
+static void get_achieved(void)
+{
+    // The achieved values are those of the plan the ISR runs, a pending update would change them
+    if (plan_update_pending())
+    {
+        reply_nack(NACK_BUSY);
+        return;
+    }
+
+    reply_begin(OPCODE_ACK, 15);
+    reply_float(liveWaveformPlan.carrierFreq);
+    reply_float(liveWaveformPlan.sineFreq);
+    reply_byte(liveWaveformPlan.timerPeriod);
+    reply_byte(liveWaveformPlan.timerPeriod >> 8);
+    reply_byte(liveWaveformPlan.clockPrescale);
+    reply_byte(liveWaveformPlan.clockPrescale >> 8);
+    reply_byte(liveWaveformPlan.interruptDivisor);
+    reply_byte(liveWaveformPlan.interruptDivisor >> 8);
+    reply_end();
+}
+
+// Acknowledges at the current baud rate, the switch happens once the ACK has left the UART (see scia_service())
+static void set_baud(void)
+{
+    if (frameLength != 4)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    Uint32 baud = payload_u32(0);
+    if (!scia_baud_valid(baud))
+    {
+        reply_nack(NACK_OUT_OF_RANGE);
+        return;
+    }
+
+    reply_ack();
+    scia_request_baud(baud);
+}
+
+// Stores one profile segment, segments are loaded in order and index 0 starts a new profile
+static void profile_load(void)
+{
+    ProfileSegment segment;
+
+    if (frameLength != 18)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    segment.targetSinFreq = payload_float(2);
+    segment.targetDepth = payload_float(6);
+    segment.rampMs = payload_u32(10);
+    segment.holdMs = payload_u32(14);
+
+    if (!(segment.targetSinFreq >= SINWAVFREQ_MIN && segment.targetSinFreq <= SINWAVFREQ_MAX)
+            || (segment.targetDepth != PROFILE_DEPTH_FOLLOW_VF
+                && !(segment.targetDepth >= MODULATION_DEPTH_MIN && segment.targetDepth <= MODULATION_DEPTH_INJECTED_MAX)))
+    {
+        reply_nack(NACK_OUT_OF_RANGE);
+        return;
+    }
+
+    if (!profile_load_segment(payload_u16(0), &segment))
+    {
+        reply_nack(NACK_REJECTED);
+        return;
+    }
+    reply_ack();
+}
+
+static void profile_vf(void)
+{
+    if (frameLength != 10)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    if (!profile_set_vf(payload_u16(0), payload_float(2), payload_float(6)))
+    {
+        reply_nack(NACK_REJECTED);
+        return;
+    }
+    reply_ack();
+}
+
+// Starts the loaded profile from the current outputs, NACKs if a target is out of range for the live parameters
+static void profile_begin(void)
+{
+    if (frameLength != 2)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    if (plan_update_pending())
+    {
+        reply_nack(NACK_BUSY);
+        return;
+    }
+    if (!profile_start(payload_u16(0)))
+    {
+        reply_nack(NACK_REJECTED);
+        return;
+    }
+    reply_ack();
+}
+
+static void profile_hold(void)
+{
+    if (frameLength != 2)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    profile_pause(payload_u16(0));
+    if (profileState == PROFILE_PAUSED)
+    {
+        profile_sync_params();
+    }
+    reply_ack();
+}
+
+static void profile_end(void)
+{
+    profile_stop();
+    profile_sync_params();
+    reply_ack();
+}
+
+// Replies with the profile state, the segment being played and the sine frequency and depth reached
+static void profile_query(void)
+{
+    Uint16 state = profileState;
+    Uint16 segment = profile_segment_index();
+    float sinWavFreq, modulationDepth;
+
+    profile_current(&sinWavFreq, &modulationDepth);
+
+    reply_begin(OPCODE_ACK, 15);
+    reply_byte(state);
+    reply_byte(state >> 8);
+    reply_byte(segment);
+    reply_byte(segment >> 8);
+    reply_float(sinWavFreq);
+    reply_float(modulationDepth);
+    reply_end();
+}
+
+// Starts a waveform table upload into the buffer that is not playing
+static void wave_begin(void)
+{
+    if (frameLength != 2)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    if (waveform_upload_busy())
+    {
+        reply_nack(NACK_BUSY);
+        return;
+    }
+    if (!waveform_upload_begin(payload_u16(0)))
+    {
+        reply_nack(NACK_OUT_OF_RANGE);
+        return;
+    }
+    reply_ack();
+}
+
+// Stores one chunk of Q15 samples, chunks have to arrive in order
+static void wave_data(void)
+{
+    if (frameLength < 4 || (frameLength & 1))
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    if (!waveform_upload_chunk(payload_u16(0), &framePayload[2], (frameLength - 2) / 2))
+    {
+        reply_nack(NACK_REJECTED);
+        return;
+    }
+    reply_ack();
+}
+
+static void wave_commit(void)
+{
+    if (!waveform_upload_commit())
+    {
+        reply_nack(NACK_REJECTED);
+        return;
+    }
+    reply_ack();
+}
+
+// Switches between the sine and the committed table without a glitch
+static void wave_select(void)
+{
+    EPwmParams params = liveEpwmParams;
+
+    if (frameLength != 2)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    params.waveform = payload_u16(0);
+    if (!params_valid(&params))
+    {
+        reply_nack(NACK_OUT_OF_RANGE);
+        return;
+    }
+
+    liveEpwmParams = params;
+    live_params_changed();
+    apply_live_params();
+    reply_ack();
+}
+
+// Switches the modulation mode, all-or-nothing like SET_PARAMS since the depth limit depends on it
+static void set_modulation(void)
+{
+    EPwmParams params = liveEpwmParams;
+
+    if (frameLength != 2)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    params.modulationMode = payload_u16(0);
+    if (!params_valid(&params))
+    {
+        reply_nack(NACK_OUT_OF_RANGE);
+        return;
+    }
+
+    liveEpwmParams = params;
+    live_params_changed();
+    apply_live_params();
+    reply_ack();
+}
+
+#ifdef ISR_PROFILING
+/*
+ * Replies with the PWM ISR statistics: Uint32 calls, Uint32 min / avg / max cycles, Uint32 missed updates,
+ * float CPU load (0-1), Uint16 avg / max entry latency (saturated) and the Uint16 entry latency histogram
+ * (ISR_STATS_LATENCY_BIN_CYCLES per bin).
+ */
+static void isr_stats_dump(void)
+{
+    Uint16 i;
+    Uint32 values[5], latency[2];
+
+    if (frameLength != 2)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    // The ISR may update the statistics while the reply is sent, copy the counters first
+    values[0] = isrStats.calls;
+    values[1] = isrStats.calls ? isrStats.cyclesMin : 0;
+    values[2] = isrStats.calls ? (Uint32) (isrStats.cyclesSum / isrStats.calls) : 0;
+    values[3] = isrStats.cyclesMax;
+    values[4] = isrStats.missed;
+    latency[0] = isrStats.calls ? (Uint32) (isrStats.latencySum / isrStats.calls) : 0;
+    latency[1] = isrStats.latencyMax;
+
+    reply_begin(OPCODE_ACK, 1 + 4 * 5 + 4 + 2 * 2 + 2 * ISR_STATS_LATENCY_BINS);
+    for (i = 0; i < 5; i++)
+    {
+        reply_byte(values[i]);
+        reply_byte(values[i] >> 8);
+        reply_byte(values[i] >> 16);
+        reply_byte(values[i] >> 24);
+    }
+    reply_float(isr_stats_cpu_load());
+    for (i = 0; i < 2; i++)
+    {
+        Uint16 cycles = latency[i] > 0xFFFF ? 0xFFFF : latency[i];
+        reply_byte(cycles);
+        reply_byte(cycles >> 8);
+    }
+    for (i = 0; i < ISR_STATS_LATENCY_BINS; i++)
+    {
+        reply_byte(isrStats.latencyHistogram[i]);
+        reply_byte(isrStats.latencyHistogram[i] >> 8);
+    }
+    reply_end();
+
+    if (payload_u16(0))
+    {
+        isr_stats_reset();
+    }
+}
+#endif
+
+// Starts or stops the telemetry stream, the ACK goes out before the first telemetry frame
+static void telemetry(void)
+{
+    if (frameLength != 2)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    reply_ack();
+    telemetry_start(payload_u16(0));
+}
+
+/*
+ * Stores a parameter set in a preset slot without touching the outputs: the masked parameters over the
+ * live ones are range checked together, as for SET_PARAMS.
+ */
+static void preset_save(void)
+{
+    EPwmParams params;
+    Uint16 error = parse_params(&params, 2);
+
+    if (error)
+    {
+        reply_nack(error);
+        return;
+    }
+    if (payload_u16(0) >= PRESET_SLOTS)
+    {
+        reply_nack(NACK_OUT_OF_RANGE);
+        return;
+    }
+
+    preset_store(payload_u16(0), &params);
+    reply_ack();
+}
+
+// Switches to a stored preset slot at the requested point, as SCHEDULE_PARAMS. The ACK carries the update's sequence number
+static void preset_recall(void)
+{
+    Uint16 slot, when, sequence;
+
+    if (frameLength != 8)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    slot = payload_u16(0);
+    when = payload_u16(2);
+    if (slot >= PRESET_SLOTS || when > PLAN_APPLY_AT_CYCLE)
+    {
+        reply_nack(NACK_OUT_OF_RANGE);
+        return;
+    }
+    if (!preset_ready(slot))
+    {
+        reply_nack(NACK_REJECTED);
+        return;
+    }
+
+    sequence = preset_activate(slot, when, payload_u32(4));
+
+    reply_begin(OPCODE_ACK, 3);
+    reply_byte(sequence);
+    reply_byte(sequence >> 8);
+    reply_end();
+}
+
+// Selects the preset slot an edge on the trigger input activates, an empty slot is rejected
+static void preset_trigger_select(void)
+{
+    Uint16 slot;
+
+    if (frameLength != 2)
+    {
+        reply_nack(NACK_BAD_LENGTH);
+        return;
+    }
+
+    slot = payload_u16(0);
+    if (slot >= PRESET_SLOTS && slot != PRESET_NONE)
+    {
+        reply_nack(NACK_OUT_OF_RANGE);
+        return;
+    }
+    if (!preset_arm(slot))
+    {
+        reply_nack(NACK_REJECTED);
+        return;
+    }
+    reply_ack();
+}
+
+// Runs the command of a complete frame with a valid CRC
+static void execute_frame(void)
+{
+    switch (frameOpcode)
+    {
+    case OPCODE_SET_PARAMS:
+        set_params();
+        break;
+    case OPCODE_GET_PARAMS:
+        get_params();
+        break;
+    case OPCODE_SET_BAUD:
+        set_baud();
+        break;
+    case OPCODE_SET_MODULATION:
+        set_modulation();
+        break;
+    case OPCODE_GET_ACHIEVED:
+        get_achieved();
+        break;
+    case OPCODE_SCHEDULE_PARAMS:
+        schedule_params();
+        break;
+    case OPCODE_PLAN_STATUS:
+        plan_status();
+        break;
+    case OPCODE_PROFILE_LOAD:
+        profile_load();
+        break;
+    case OPCODE_PROFILE_VF:
+        profile_vf();
+        break;
+    case OPCODE_PROFILE_START:
+        profile_begin();
+        break;
+    case OPCODE_PROFILE_PAUSE:
+        profile_hold();
+        break;
+    case OPCODE_PROFILE_STOP:
+        profile_end();
+        break;
+    case OPCODE_PROFILE_QUERY:
+        profile_query();
+        break;
+    case OPCODE_WAVE_BEGIN:
+        wave_begin();
+        break;
+    case OPCODE_WAVE_DATA:
+        wave_data();
+        break;
+    case OPCODE_WAVE_COMMIT:
+        wave_commit();
+        break;
+    case OPCODE_WAVE_SELECT:
+        wave_select();
+        break;
+#ifdef ISR_PROFILING
+    case OPCODE_ISR_STATS:
+        isr_stats_dump();
+        break;
+#endif
+    case OPCODE_TELEMETRY:
+        telemetry();
+        break;
+    case OPCODE_PRESET_STORE:
+        preset_save();
+        break;
+    case OPCODE_PRESET_ACTIVATE:
+        preset_recall();
+        break;
+    case OPCODE_PRESET_ARM:
+        preset_trigger_select();
+        break;
+    default:
+        reply_nack(NACK_UNKNOWN_OPCODE);
+        break;
+    }
+}
+
+/*
+ * Background protocol work for the main loop. A complete frame is only run (or NACKed) once the TX ring
+ * buffer takes the largest reply, so no reply is cut short by a full buffer (telemetry may have filled it).
+ * A frame whose next byte has not come within PROTOCOL_BYTE_TIMEOUT is dropped, the following bytes
+ * then go to the ASCII interface again.
+ */
+void protocol_service(void)
+{
+    if (state == WAIT_REPLY_ROOM)
+    {
+        if (scia_tx_free() >= PROTOCOL_MAX_FRAME)
+        {
+            state = WAIT_SYNC;
+            if (frameError)
+            {
+                reply_nack(frameError);
+            }
+            else
+            {
+                execute_frame();
+            }
+        }
+    }
+    else if (state != WAIT_SYNC && hal_cycle_count() - lastByteCycle > PROTOCOL_BYTE_TIMEOUT)
+    {
+        state = WAIT_SYNC;
+    }
+}
+
+// Ends the frame, the command or NACK runs from protocol_service() once there is room for the reply
+static void frame_complete(Uint16 error)
+{
+    frameError = error;
+    state = WAIT_REPLY_ROOM;
+    protocol_service();
+}
+
+/*
+ * Feeds one received byte to the frame parser.
+ * Executes the command once a complete frame with a valid CRC has arrived, NACKs a bad CRC or length.
+ */
+void protocol_receive_byte(Uint16 byte)
+{
+    byte &= 0xFF;
+    lastByteCycle = hal_cycle_count();
+
+    switch (state)
+    {
+    case WAIT_SYNC:
+        if (byte == PROTOCOL_SYNC)
+        {
+            frameCrc = 0xFFFF;
+            state = WAIT_LENGTH;
+        }
+        break;
+
+    case WAIT_LENGTH:
+        frameLength = byte;
+        frameCrc = crc16_update(frameCrc, byte);
+        if (frameLength > PROTOCOL_MAX_PAYLOAD)
+        {
+            frameOpcode = 0;
+            frame_complete(NACK_BAD_LENGTH);
+        }
+        else
+        {
+            state = WAIT_OPCODE;
+        }
+        break;
+
+    case WAIT_OPCODE:
+        frameOpcode = byte;
+        frameCrc = crc16_update(frameCrc, byte);
+        payloadIndex = 0;
+        state = frameLength ? WAIT_PAYLOAD : WAIT_CRC_HIGH;
+        break;
+
+    case WAIT_PAYLOAD:
+        framePayload[payloadIndex++] = byte;
+        frameCrc = crc16_update(frameCrc, byte);
+        if (payloadIndex == frameLength)
+        {
+            state = WAIT_CRC_HIGH;
+        }
+        break;
+
+    case WAIT_CRC_HIGH:
+        receivedCrc = byte << 8;
+        state = WAIT_CRC_LOW;
+        break;
+
+    case WAIT_CRC_LOW:
+        receivedCrc |= byte;
+        frame_complete(receivedCrc == frameCrc ? 0 : NACK_BAD_CRC);
+        break;
+
+    case WAIT_REPLY_ROOM:
+        break;  // Not fed until the reply has gone out, see protocol_reply_pending()
+    }
+}
@@ -1,100 +1,727 @@
 #include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
 #include "pwm.h"
+#include "pwm_dma.h"
+#include "profile.h"
+#include "waveform.h"
+#include "isr_stats.h"
+#include "cla_shared.h"
+#include "telemetry.h"
+#include "config_store.h"
 
 // Initialize default PWM parameters to be outputted
 EPwmParams liveEpwmParams = {
-        .pwmWavFreq = 2500,      // frequency of pwm DO NOT GO BELOW 687Hz, counter wont work properly 65535 < 90*10^6 / (687*2)
+        .pwmWavFreq = 2500,      // frequency of pwm, the timer planner prescales the clock below 687Hz (65535 < 90*10^6 / (687*2))
         .sinWavFreq = 60,        // sin frequency 0-150Hz
         .modulation_depth = 1.0,    // modulation depth between 0 and 1
         .offset = 0.0,              // make sure offset is between +-(1-MODULATION_DEPTH)/2
-        .phaseLead1 = 0,               // Phase shift angle in degree
-        .phaseLead2 = 120,             // Phase shift angle in degree
-        .phaseLead3 = 240,             // Phase shift angle in degree
-        .epwmTimerTBPRD = 0
+        .phaseLead = { 0 },            // Phase shift angles in degree, set from the channel descriptors by init_phase_leads()
+        .epwmTimerTBPRD = 0,
+        .waveform = WAVEFORM_SINE,
+        .modulationMode = MODULATION_SINE
 };
 // Structure to store values input from serial terminal
 EPwmParams bufferEpwmParams;
 
-/**
- * Interrupt service routine for ePWM1 module.
- * Generates a PWM signal with a sinusoidal modulation.
- * Calculates phase angle and sets duty cycle based on parameters.
- * Interrupt occurs when counter is set to 0
+// Waveform plan the ISR generates from, compiled from liveEpwmParams
+#pragma DATA_SECTION(liveWaveformPlan, "pwmdata");
+WaveformPlan liveWaveformPlan;
+
+// Plan waiting to be picked up by the ISR, and when. Sequence counted mailbox: planSequence is odd while the
+// main loop writes the plan and its schedule and even once they are complete. The ISR only takes an even
+// sequence it has not applied yet; it preempts the main loop, so it never sees a half written plan and
+// all channels switch in the same ISR call. A new update replaces one that is still waiting.
+#pragma DATA_SECTION(pendingWaveformPlan, "pwmdata");
+#pragma DATA_SECTION(planSequence, "pwmdata");
+#pragma DATA_SECTION(planAppliedSequence, "pwmdata");
+static WaveformPlan pendingWaveformPlan;
+static Uint16 pendingApplyWhen = PLAN_APPLY_NEXT_PERIOD;
+static Uint32 pendingApplyCycle = 0;
+static volatile Uint16 planSequence = 0;
+static volatile Uint16 planAppliedSequence = 0;
+
+// PWM periods since the outputs started, and the period the last plan took over in
+volatile Uint32 carrierCycleCount = 0;
+volatile Uint32 planAppliedCycle = 0;
+
+// Phase of the first compare the last plan wrote, every later compare of the plan is a whole number of
+// tuning words on from it (the DMA tables start there)
+volatile Uint32 planAppliedPhase = 0;
+
+// Set once Init_Epwmm() has started the outputs
+static Uint16 epwmRunning = 0;
+
+#ifdef DDS_ROTATION_INCREMENTAL
+// Sine / cosine pair of the ISR's phase, only the ISR advances it
+#pragma DATA_SECTION(isrRotator, "pwmdata");
+static DdsRotator isrRotator;
+#endif
+
+#ifndef HRPWM_MODE
+// 1 / n for the interpolation between two exact compares n periods apart
+#pragma DATA_SECTION(interpolationScale, "pwmdata");
+static const float interpolationScale[PWM_INTERRUPT_DIVISOR_MAX + 1] = { 0, 1.0f, 0.5f, 1.0f / 3.0f };
+
+/*
+ * Fills one half of the DMA compare ring with the next interruptDivisor periods after phase.
+ * Only the last entry is an exact compare, the ones before are interpolated from lastCounts (the compares
+ * at phase), which then move on to the new end point. Returns the phase of the last entry.
  */
-__interrupt void epwm1_isr(void)
+#pragma CODE_SECTION(fill_ring_half, "ramfuncs");
+static inline Uint32 fill_ring_half(const WaveformPlan *plan, Uint16 half, Uint32 phase, float *lastCounts)
 {
-    //initialize angle and convert from degrees to radians
-    static float angle = 0;
-
-    // Calculate the angle increment per PWM cycle
-    float angleincrement = 2 * M_PI
-            /(liveEpwmParams.pwmWavFreq / liveEpwmParams.sinWavFreq);
+    Uint16 divisor = plan->interruptDivisor;
+    Uint16 first = half * divisor;
+    Uint16 ch, j;
+    float counts[HAL_EPWM_CHANNELS];
+
+    phase += divisor * plan->tuningWord;
+    compare_counts(plan, phase, counts);
+
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        float step = (counts[ch] - lastCounts[ch]) * interpolationScale[divisor];
+        for (j = 0; j < divisor; j++)
+        {
+            dmaCmpaRing[ch][first + j] = (Uint16) (lastCounts[ch] + step * (j + 1));
+        }
+        lastCounts[ch] = counts[ch];
+    }
+    return phase;
+}
+#endif
 
-    // If the angle exceeds 2*PI, wrap it around
-    if (angle > 2 * M_PI)
-        angle -= 2 * M_PI;
+/*
+ * Carrier frequency error of a TBCLK prescaler, with the period in TBCLK counts (exact and rounded to TBPRD).
+ * Returns -1 if the period does not fit TBPRD with that prescaler.
+ */
+static float timebase_error(float pwmWavFreq, Uint16 prescale, float *period, Uint16 *counts)
+{
+#ifdef HRPWM_MODE
+    if (prescale != 1)
+        return -1;
+#endif
+    *period = 0.5 * (PWMCLKFREQ / prescale / pwmWavFreq);
+    if (*period > TBPRD_MAX + 0.5)
+        return -1;
+
+#ifdef HRPWM_MODE
+    Uint32 rounded = (Uint32) *period;  // TBPRDHR adds the fraction
+#else
+    Uint32 rounded = (Uint32) (*period + 0.5);
+#endif
+    if (rounded < 2)
+        return -1;
+
+    *counts = (Uint16) rounded;
+    return fabsf(0.5 * (PWMCLKFREQ / prescale / rounded) - pwmWavFreq);
+}
 
-    // Calculate the duty cycle for the PWM signal
-    float angle_rad = angle + liveEpwmParams.phaseLead1 * M_PI / 180.0;
-    float duty_cycle = (sinf(angle_rad) * liveEpwmParams.modulation_depth + 1) * .5
-            - liveEpwmParams.offset;
+/*
+ * Plans the time base for the requested carrier: picks the TBCLK prescaler (HSPCLKDIV x CLKDIV) and the
+ * rounded TBPRD. The smallest prescaler (the largest TBPRD, so the finest duty resolution) is taken whose
+ * carrier error is within TIMEBASE_ERROR_TOLERANCE of the smallest error any prescaler reaches, so a larger
+ * prescaler never trades duty resolution for a tiny frequency gain. Returns the exact (unrounded) period
+ * in TBCLK counts for the HRPWM fraction.
+ */
+static float plan_timebase(float pwmWavFreq, WaveformPlan *plan)
+{
+    Uint16 hsp, clk, pass, counts, found = 0;
+    float bestError = -1, exactPeriod = 0, period;
+
+    plan->hspClkDiv = TB_DIV1;
+    plan->clkDiv = TB_DIV1;
+    plan->clockPrescale = 1;
+    plan->timerPeriod = TBPRD_MAX;
+
+    // First pass finds the smallest error, the second the smallest prescaler within the tolerance of it
+    for (pass = 0; pass < 2; pass++)
+    {
+        // HSPCLKDIV code 0 divides by 1, code n by 2n; CLKDIV code n divides by 2^n
+        for (hsp = 0; hsp < 8; hsp++)
+        {
+            for (clk = 0; clk < 8; clk++)
+            {
+                Uint16 prescale = (hsp ? 2 * hsp : 1) << clk;
+                float error = timebase_error(pwmWavFreq, prescale, &period, &counts);
+                if (error < 0)
+                    continue;
+
+                if (pass == 0)
+                {
+                    if (bestError < 0 || error < bestError)
+                        bestError = error;
+                }
+                else if (error <= bestError + TIMEBASE_ERROR_TOLERANCE * pwmWavFreq
+                        && (!found || prescale < plan->clockPrescale))
+                {
+                    found = 1;
+                    exactPeriod = period;
+                    plan->hspClkDiv = hsp;
+                    plan->clkDiv = clk;
+                    plan->clockPrescale = prescale;
+                    plan->timerPeriod = counts;
+                }
+            }
+        }
+    }
+
+#ifdef HRPWM_MODE
+    exactPeriod = floorf(exactPeriod * 256) / 256;     // TBPRDHR holds 8 fraction bits
+    plan->carrierFreq = 0.5 * (PWMCLKFREQ / exactPeriod);
+#else
+    plan->carrierFreq = 0.5 * (PWMCLKFREQ / plan->clockPrescale / plan->timerPeriod);
+    exactPeriod = plan->timerPeriod;
+#endif
+
+    return exactPeriod;
+}
 
-    // Set the compare value for the PWM signal
-    EPwm1Regs.CMPA.half.CMPA = (Uint32) ((1-duty_cycle)
-            * ((float) liveEpwmParams.epwmTimerTBPRD));
+/*
+ * Picks the interrupt decimation from the carrier to sine ratio: the largest divisor (ISR every 1st to 3rd
+ * period) for which linear interpolation between the ISR's exact compares stays within DECIMATION_MAX_ERROR
+ * counts of the sine. A sine of amplitude A sampled every n periods deviates from the straight line
+ * by at most A * (2 pi n sinWavFreq / carrierFreq)^2 / 8.
+ * Uploaded waveform tables can have edges the bound does not cover, they, HRPWM_MODE (the DMA ring
+ * would not reach CMPAHR) and channel tables other than ePWM1-3 keep one ISR call per period, so does
+ * CLA_OFFLOAD (the CLA writes every period of a sine plan, the ISR must not be decimating to hand over).
+ */
+static Uint16 plan_decimation(const WaveformPlan *plan, float sinWavFreq)
+{
+#if defined(HRPWM_MODE) || defined(CLA_OFFLOAD)
+    return 1;
+#else
+    Uint16 divisor;
+    float amplitude;
+
+    if (!plan->sine || HAL_EPWM_CHANNELS != DMA_CHANNELS)
+    {
+        return 1;
+    }
+
+    amplitude = .5 * MODULATION_DEPTH_INJECTED_MAX * plan->timerPeriod;
+
+    for (divisor = PWM_INTERRUPT_DIVISOR_MAX; divisor > 1; divisor--)
+    {
+        float step = 2 * M_PI * divisor * sinWavFreq / plan->carrierFreq;
+        if (amplitude * step * step / 8 <= DECIMATION_MAX_ERROR)
+        {
+            break;
+        }
+    }
+    return divisor;
+#endif
+}
 
-    // Increment the angle for the next cycle
-    angle += angleincrement;
+/*
+ * Calculates the ePWM timer period and compiles the user facing parameters into the plan
+ * the ISR uses, so that no parameter math is left for the ISR.
+ * The duty cycle (sin * modulation_depth + 1) * .5 - offset is folded into
+ * compare = (1 - duty) * TBPRD = bias + amplitude * sample.
+ * Call whenever the parameters change, never from the ISR.
+ */
+void compile_waveform_plan(EPwmParams *params, WaveformPlan *plan)
+{
+    Uint16 ch;
+
+    // Plan the ePWM time base, the period is in TBCLK counts of the up/down count timer
+    // With HRPWM_MODE TBPRDHR keeps the fraction of the period, so the carrier frequency is exact
+    float period = plan_timebase(params->pwmWavFreq, plan);
+    params->epwmTimerTBPRD = plan->timerPeriod;
+
+    // Phase increment per PWM period and the phase lead of each channel
+    plan->tuningWord = dds_tuning_word(params->sinWavFreq, plan->carrierFreq);
+    plan->sineFreq = (float) ((long double) plan->tuningWord / DDS_PHASE_FULL_SCALE * plan->carrierFreq);
+
+    // Table the ISR plays back, the sine or the uploaded waveform
+    waveform_select_table(params->waveform, plan);
+
+    // At high carrier to sine ratios the ISR only runs every 2nd or 3rd period (see pwm_dma.h)
+    plan->interruptDivisor = plan_decimation(plan, params->sinWavFreq);
+    plan->isrFreq = plan->carrierFreq / plan->interruptDivisor;
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        plan->channelPhase[ch] = dds_phase_word(params->phaseLead[ch]);
+        plan->groupEnd[halEpwmChannels[ch].group] = ch + 1;
+    }
+
+    // Sine amplitude and offset scaled to timer counts
+    plan->amplitude = -params->modulation_depth * .5 * period / SINE_TABLE_AMPLITUDE;
+    plan->bias = (.5 + params->offset) * period;
+    plan->timerPeriodHR = (Uint32) (period * HRPWM_FRACTION_SCALE);
+    plan->modulationMode = params->modulationMode;
+
+#ifdef DDS_ROTATION
+    // Rotation coefficients of the phase leads and of one tuning word step
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        float lead = (float) plan->channelPhase[ch] * (2 * M_PI / DDS_PHASE_FULL_SCALE);
+        plan->leadSine[ch] = sinf(lead);
+        plan->leadCosine[ch] = cosf(lead);
+    }
+    plan->rotationWord = plan->tuningWord;
+    plan->stepSine = sinf((float) plan->tuningWord * (2 * M_PI / DDS_PHASE_FULL_SCALE));
+    plan->stepCosine = cosf((float) plan->tuningWord * (2 * M_PI / DDS_PHASE_FULL_SCALE));
+#endif
+}
 
-    // Clear the interrupt flag
-    EPwm1Regs.ETCLR.bit.INT = 1;
+/*
+ * Lowers the ISR decimation of a plan to what the given sine frequency allows. For plans whose tuning word
+ * is ramped later without a recompile (profiles), pass the highest sine frequency the ramp reaches.
+ */
+void limit_plan_decimation(WaveformPlan *plan, float sinWavFreq)
+{
+    Uint16 divisor = plan_decimation(plan, sinWavFreq);
 
-    // Acknowledge the interrupt in the PIE control register
-    PieCtrlRegs.PIEACK.all = PIEACK_GROUP3;
+    if (divisor < plan->interruptDivisor)
+    {
+        plan->interruptDivisor = divisor;
+        plan->isrFreq = plan->carrierFreq / divisor;
+    }
 }
 
-//same as epwm1
-__interrupt void epwm2_isr(void)
+// Highest modulation depth of the modulation mode, injection allows 2/sqrt(3) before the phases clip
+float modulation_depth_max(const EPwmParams *params)
 {
-    static float angle = 0;
+    return params->modulationMode == MODULATION_SINE ? MODULATION_DEPTH_MAX : MODULATION_DEPTH_INJECTED_MAX;
+}
 
-    float angleincrement = 2 * M_PI / (liveEpwmParams.pwmWavFreq / liveEpwmParams.sinWavFreq);
+// Highest offset magnitude that keeps the phase peaks within the period, (1 - phase peak) / 2
+float offset_limit(const EPwmParams *params)
+{
+    float peak = params->modulation_depth;
+    if (params->modulationMode != MODULATION_SINE)
+    {
+        peak *= INJECTED_PEAK_SCALE;
+    }
+    return (1 - peak) / 2;
+}
 
-    if (angle > 2 * M_PI)
-        angle -= 2 * M_PI;
+/*
+ * Checks every user facing parameter against its valid range, the same limits the ASCII parser enforces.
+ * Written as !(in range) so NaN values are rejected too.
+ * Returns 1 if all parameters are valid, 0 otherwise.
+ */
+int params_valid(const EPwmParams *params)
+{
+    Uint16 ch;
+    float offsetLimit = offset_limit(params);
+
+    if (params->modulationMode > MODULATION_SVPWM
+            || !(params->pwmWavFreq >= PWMWAVFREQ_MIN && params->pwmWavFreq <= PWMWAVFREQ_MAX)
+            || !(params->sinWavFreq >= SINWAVFREQ_MIN && params->sinWavFreq <= SINWAVFREQ_MAX)
+            || !(params->sinWavFreq < .5f * params->pwmWavFreq)     // One sample per half sine at least (Nyquist)
+            || !(params->modulation_depth >= MODULATION_DEPTH_MIN && params->modulation_depth <= modulation_depth_max(params))
+            || !(params->offset >= -offsetLimit && params->offset <= offsetLimit)
+            || !(params->waveform == WAVEFORM_SINE || (params->waveform == WAVEFORM_TABLE && waveform_table_ready())))
+    {
+        return 0;
+    }
+
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        if (!(params->phaseLead[ch] >= MIN_ANGLE && params->phaseLead[ch] <= MAX_ANGLE))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
 
-    float angle_rad = angle + liveEpwmParams.phaseLead2 * M_PI / 180.0;
-    float duty_cycle = (sinf(angle_rad) * liveEpwmParams.modulation_depth + 1) * .5 - liveEpwmParams.offset;
+// Sets the phase leads to the power up values of the channel descriptors (halEpwmChannels)
+void init_phase_leads(EPwmParams *params)
+{
+    Uint16 ch;
 
-    EPwm2Regs.CMPA.half.CMPA = (Uint32) ((1-duty_cycle) * ((float) liveEpwmParams.epwmTimerTBPRD));
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        params->phaseLead[ch] = halEpwmChannels[ch].phaseLead;
+    }
+}
 
-    angle += angleincrement;
+/*
+ * Applies liveEpwmParams to the outputs.
+ * The first call starts the outputs with Init_Epwmm(). After that the new plan is handed to the ISR,
+ * which switches to it at the next period boundary without stopping the timers or resetting the phase.
+ * With DMA_TABLE_MODE, ratios that fit a DMA table are then streamed by the DMA instead of the ISR,
+ * with CLA_OFFLOAD the CLA takes over the plans it can run.
+ */
+void apply_live_params(void)
+{
+    schedule_live_params(PLAN_APPLY_NEXT_PERIOD, 0);
+}
 
-    EPwm2Regs.ETCLR.bit.INT = 1;
-    PieCtrlRegs.PIEACK.all = PIEACK_GROUP3;
+// Copies a plan compiled beforehand or compiles liveEpwmParams, a table plan is always compiled as the table may have changed
+static void prepare_live_plan(const WaveformPlan *compiled, WaveformPlan *plan)
+{
+    if (compiled && liveEpwmParams.waveform == WAVEFORM_SINE)
+    {
+        *plan = *compiled;
+    }
+    else
+    {
+        compile_waveform_plan(&liveEpwmParams, plan);
+    }
 }
-//same as epwm1
-__interrupt void epwm3_isr(void)
+
+// Hands liveEpwmParams to the outputs with the plan compiled (0) or copied from compiled, see schedule_live_params()
+static Uint16 schedule_plan(const WaveformPlan *compiled, Uint16 when, Uint32 cycle)
 {
-    static float angle = 0;
+    // A manual change ends a running profile, the ISR must not ramp the new plan away.
+    // profile_start() schedules the plan of its own profile, that one stays with the ISR.
+    if (profileState != PROFILE_STARTING)
+    {
+        profile_stop();
+    }
+
+#ifdef DMA_TABLE_MODE
+    // The ISR takes over again while the plan changes, the DMA tables are rebuilt below if the new ratio fits
+    if (dmaTableModeActive)
+    {
+        dma_stop_table_mode();
+    }
+#endif
+#ifdef CLA_OFFLOAD
+    // Likewise for the CLA, it takes the new plan over again below if it can run it
+    if (claActive)
+    {
+        cla_stop();
+    }
+#endif
+
+    if (!epwmRunning)
+    {
+        // ePWM interrupts are not enabled yet, so the live plan can be written directly
+        prepare_live_plan(compiled, &liveWaveformPlan);
+        Init_Epwmm();
+        epwmRunning = 1;
+        return planAppliedSequence;
+    }
+
+#ifdef DMA_TABLE_MODE
+    // Only immediate updates go to the DMA, scheduled ones, a telemetry stream and a profile need the ISR
+    Uint16 tableLength = 0;
+    if (when == PLAN_APPLY_NEXT_PERIOD && !telemetryPeriods && profileState != PROFILE_STARTING)
+    {
+        tableLength = dma_table_length(&liveEpwmParams);
+    }
+#endif
+
+    planSequence++;     // Odd, the ISR leaves the mailbox alone while it is written
+    prepare_live_plan(compiled, &pendingWaveformPlan);
+#ifdef DMA_TABLE_MODE
+    if (tableLength)
+    {
+        // The ISR hands over to the DMA from an undecimated call, the ring must not start first
+        pendingWaveformPlan.interruptDivisor = 1;
+        pendingWaveformPlan.isrFreq = pendingWaveformPlan.carrierFreq;
+    }
+#endif
+    pendingApplyWhen = when;
+    pendingApplyCycle = cycle;
+    planSequence++;     // Even, complete
+
+#ifdef CLA_OFFLOAD
+    if (when == PLAN_APPLY_NEXT_PERIOD && cla_params_supported(&liveEpwmParams))
+    {
+        // Let the ISR switch to the new plan first, then hand the outputs to the CLA
+        wait_for_plan_update();
+        cla_start();
+        return planSequence;
+    }
+#endif
+
+#ifdef DMA_TABLE_MODE
+    if (tableLength)
+    {
+        // Let the ISR switch to the new plan and period first, then hand the outputs to the DMA
+        wait_for_plan_update();
+        dma_start_table_mode(&liveWaveformPlan, tableLength);
+    }
+#endif
+
+    return planSequence;
+}
 
-    float angleincrement = 2 * M_PI / (liveEpwmParams.pwmWavFreq / liveEpwmParams.sinWavFreq);
+/*
+ * Applies liveEpwmParams to the outputs at the given point: PLAN_APPLY_NEXT_PERIOD, PLAN_APPLY_ZERO_CROSSING
+ * or PLAN_APPLY_AT_CYCLE with the carrier cycle (carrierCycleCount) the new values take over in.
+ * Never waits for an earlier update, a new one replaces it. Only immediate updates hand the outputs to
+ * the CLA or the DMA tables, scheduled ones, a telemetry stream and a profile leave the ISR running.
+ * Returns the sequence number plan_applied_sequence() reports once the ISR has switched.
+ */
+Uint16 schedule_live_params(Uint16 when, Uint32 cycle)
+{
+#ifdef CONFIG_STORE
+    // Every confirmed change comes through here, config_service() saves it once the ISR runs it
+    config_request_save();
+#endif
 
-    if (angle > 2 * M_PI)
-        angle -= 2 * M_PI;
+    return schedule_plan(0, when, cycle);
+}
 
-    float angle_rad = angle + liveEpwmParams.phaseLead3 * M_PI / 180.0;
-    float duty_cycle = (sinf(angle_rad) * liveEpwmParams.modulation_depth + 1) * .5 - liveEpwmParams.offset;
+/*
+ * Like schedule_live_params() with plan, compiled from liveEpwmParams beforehand, instead of a compile
+ * (preset slots, see preset.h). Not saved as the boot configuration.
+ */
+Uint16 schedule_live_plan(const WaveformPlan *plan, Uint16 when, Uint32 cycle)
+{
+    return schedule_plan(plan, when, cycle);
+}
 
-    EPwm3Regs.CMPA.half.CMPA = (Uint32) ((1-duty_cycle) * ((float) liveEpwmParams.epwmTimerTBPRD));
+// Returns 1 while the ISR has not switched to the last applied plan
+Uint16 plan_update_pending(void)
+{
+    return planSequence != planAppliedSequence;
+}
 
-    angle += angleincrement;
+// Sequence number of the plan the ISR runs, see schedule_live_params()
+Uint16 plan_applied_sequence(void)
+{
+    return planAppliedSequence;
+}
 
-    EPwm3Regs.ETCLR.bit.INT = 1;
+// Waits until the ISR has picked up the last plan handed to it, liveWaveformPlan is then current.
+// A scheduled update is waited for until its point has passed.
+void wait_for_plan_update(void)
+{
+    while (planSequence != planAppliedSequence)
+    {
+        hal_busy_wait();
+    }
+}
 
-    PieCtrlRegs.PIEACK.all = PIEACK_GROUP3;
+/*
+ * Returns 1 if the pending plan is due in this ISR call. nextPhase is the phase of the compares that load
+ * at the next counter zero, periods the PWM periods between ISR calls.
+ */
+#pragma CODE_SECTION(plan_update_due, "ramfuncs");
+static inline Uint16 plan_update_due(Uint32 nextPhase, Uint16 periods)
+{
+    switch (pendingApplyWhen)
+    {
+    case PLAN_APPLY_ZERO_CROSSING:
+        // Channel 1 passed phase 0 (rising zero crossing of the sine) since the last call,
+        // a DC output (sine frequency 0) never crosses and switches at once
+        return liveWaveformPlan.tuningWord == 0
+                || nextPhase + liveWaveformPlan.channelPhase[0] < periods * liveWaveformPlan.tuningWord;
+    case PLAN_APPLY_AT_CYCLE:
+        // The values written now load at the next counter zero, which starts period carrierCycleCount + 1
+        return (int32) (carrierCycleCount + 1 - pendingApplyCycle) >= 0;
+    default:
+        return 1;
+    }
 }
 
+/**
+ * Interrupt service routine for the three-phase output.
+ * Triggered by ePWM1 only; the other channels count in lockstep with it, so a single
+ * shared DDS phase accumulator drives all channels and their phases can never drift apart.
+ * Calculates the duty cycle of each channel and sets its compare value.
+ * Interrupt occurs when counter is set to 0, every interruptDivisor-th time when the plan decimates;
+ * the DMA then writes the compares of the periods in between from a ring the ISR fills (see pwm_dma.h).
+ * Runs from RAM (ramfuncs), flash wait states would limit the highest usable PWM frequency.
+ */
+#pragma CODE_SECTION(epwm_three_phase_isr, "ramfuncs");
+__interrupt void epwm_three_phase_isr(void)
+{
+    // Phase accumulator shared by all channels, wraps naturally every sine period
+    // While decimating it holds the phase of the last compare in the ring
+    static Uint32 phase = 0;
+    // Set when the plan that took over runs on a new prescaler, switched in the next call (see below)
+    static Uint16 prescalerPending = 0;
+    Uint16 ch;
+    Uint16 sequence = planSequence;
+#ifndef HRPWM_MODE
+    static float lastCounts[HAL_EPWM_CHANNELS];    // Compares at phase, the start of the next interpolation
+    static Uint16 ringHalf = 0;                     // Ring half the DMA has just finished
+    Uint16 compare[HAL_EPWM_CHANNELS];
+#endif
+
+#ifdef ISR_PROFILING
+    isr_stats_enter(&liveWaveformPlan);
+#endif
+
+#ifdef CLA_OFFLOAD
+    // First call after cla_stop(), carry on from the phase the CLA reached
+    if (claResumePending)
+    {
+        phase = claResumePhase;
+        claResumePending = 0;
+    }
+#endif
+#ifdef DMA_TABLE_MODE
+    // First call after dma_stop_table_mode(), carry on from the table entry the DMA would have written next
+    if (dmaResumePending)
+    {
+        phase = dmaResumePhase;
+        dmaResumePending = 0;
+    }
+#endif
+
+    // Counter zeros since the last call
+    carrierCycleCount += dmaRingDivisor;
+
+    // The period and compares of a plan with a new prescaler have just loaded, the prescaler follows now.
+    // Only the few counts since the counter zero ran on the old one.
+    if (prescalerPending)
+    {
+        for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+        {
+            hal_epwm_write_prescaler(ch, liveWaveformPlan.hspClkDiv, liveWaveformPlan.clkDiv);
+        }
+        prescalerPending = 0;
+    }
+
+    // Switch to a newly confirmed plan once it is due, the phase accumulator carries on so the sine stays continuous.
+    // TBPRD is shadowed and loads at the next counter zero, together with the compare values written below.
+    // While decimating, the compare that loads next is the one dmaRingDivisor periods before the end of the ring.
+    if (!(sequence & 1) && sequence != planAppliedSequence
+            && plan_update_due(dmaRingDivisor > 1 ? phase - dmaRingDivisor * liveWaveformPlan.tuningWord : phase,
+                               dmaRingDivisor))
+    {
+#ifndef HRPWM_MODE
+        // The ring holds compares for the old plan, drop it and go back to the phase of the compare the DMA
+        // has just loaded, it is written again below with the new plan
+        if (dmaRingDivisor > 1)
+        {
+            phase -= dmaRingDivisor * liveWaveformPlan.tuningWord;
+            dma_stop_ring();
+        }
+#endif
+
+        // A new prescaler takes effect at once, while the period and compares written below load at the next
+        // counter zero; the prescaler is switched by the next call, right after that zero, so the period
+        // running now keeps the old time base throughout
+        prescalerPending = (pendingWaveformPlan.clockPrescale != liveWaveformPlan.clockPrescale);
+
+        liveWaveformPlan = pendingWaveformPlan;
+        for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+        {
+#ifdef HRPWM_MODE
+            hal_epwm_write_period_hr(ch, liveWaveformPlan.timerPeriodHR);
+#else
+            hal_epwm_write_period(ch, liveWaveformPlan.timerPeriod);
+#endif
+        }
+        planAppliedSequence = sequence;
+        planAppliedCycle = carrierCycleCount + 1;
+        planAppliedPhase = phase;
+        if (telemetryPeriods)
+        {
+            telemetry_isr_plan(&liveWaveformPlan, sequence);
+        }
+    }
+
+    // Set the compare value of each channel, phase shifted by its phase lead
+#ifdef HRPWM_MODE
+    // The fraction of each compare goes to CMPAHR
+    float counts[HAL_EPWM_CHANNELS];
+    compare_counts(&liveWaveformPlan, phase, counts);
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        hal_epwm_write_compare_hr(ch, hrpwm_compare(counts[ch], liveWaveformPlan.timerPeriod));
+    }
+    if (telemetry_isr_due(carrierCycleCount + 1))
+    {
+        Uint16 compare[HAL_EPWM_CHANNELS];
+        for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+        {
+            compare[ch] = (Uint16) counts[ch];
+        }
+        telemetry_isr_record(carrierCycleCount + 1, phase, &liveWaveformPlan, planAppliedSequence, compare);
+    }
+
+    // Advance the phase for the next cycle
+    phase += liveWaveformPlan.tuningWord;
+#else
+    if (dmaRingDivisor > 1)
+    {
+        // Refill the half the DMA has just finished, it plays again after the other half
+        phase = fill_ring_half(&liveWaveformPlan, ringHalf, phase, lastCounts);
+
+        // The new end of the ring loads two decimated intervals after the next counter zero
+        if (telemetry_isr_due(carrierCycleCount + 1 + 2 * dmaRingDivisor))
+        {
+            for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+            {
+                compare[ch] = dmaCmpaRing[ch][ringHalf * dmaRingDivisor + dmaRingDivisor - 1];
+            }
+            telemetry_isr_record(carrierCycleCount + 1 + 2 * dmaRingDivisor, phase, &liveWaveformPlan,
+                                 planAppliedSequence, compare);
+        }
+        ringHalf ^= 1;
+    }
+    else
+    {
+#ifdef DDS_ROTATION_INCREMENTAL
+        // At a steady tuning word the base sine / cosine pair moves on by one rotation per call,
+        // while a profile ramps the tuning word every call reads the pair from the table
+        if (liveWaveformPlan.sine && liveWaveformPlan.tuningWord == liveWaveformPlan.rotationWord)
+        {
+            float counts[HAL_EPWM_CHANNELS], baseSine, baseCosine;
+            dds_rotator_sine_cosine(&isrRotator, phase, liveWaveformPlan.tuningWord, liveWaveformPlan.stepSine,
+                                    liveWaveformPlan.stepCosine, &baseSine, &baseCosine);
+            compare_counts_rotated(&liveWaveformPlan, phase, baseSine, baseCosine, counts);
+            for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+            {
+                compare[ch] = (Uint16) counts[ch];
+            }
+        }
+        else
+#endif
+        compare_values(&liveWaveformPlan, phase, compare);
+        for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+        {
+            hal_epwm_write_compare(ch, compare[ch]);
+        }
+        if (telemetry_isr_due(carrierCycleCount + 1))
+        {
+            telemetry_isr_record(carrierCycleCount + 1, phase, &liveWaveformPlan, planAppliedSequence, compare);
+        }
+
+        if (liveWaveformPlan.interruptDivisor > 1 && !dmaTableModeActive && !prescalerPending)
+        {
+            // Start decimating: the compare above covers the next period, both ring halves the ones after it
+            // (not before the next call has switched a new prescaler)
+            compare_counts(&liveWaveformPlan, phase, lastCounts);
+            phase = fill_ring_half(&liveWaveformPlan, 0, phase, lastCounts);
+            phase = fill_ring_half(&liveWaveformPlan, 1, phase, lastCounts);
+            ringHalf = 0;
+            dma_start_ring(liveWaveformPlan.interruptDivisor);
+        }
+        else
+        {
+            // Advance the phase for the next cycle
+            phase += liveWaveformPlan.tuningWord;
+        }
+    }
+#endif
+
+#ifdef CLA_OFFLOAD
+    // Hand the outputs to the CLA once this ISR runs the live plan every period, phase is the next compare's
+    if (claStartPending && sequence == planAppliedSequence && dmaRingDivisor == 1 && !prescalerPending)
+    {
+        cla_take_over(phase, carrierCycleCount);
+    }
+#endif
+#ifdef DMA_TABLE_MODE
+    // Likewise for the DMA tables, they stream on from the next compare's phase
+    if (dmaTableStartPending && sequence == planAppliedSequence && dmaRingDivisor == 1 && !prescalerPending)
+    {
+        dma_take_over(phase, carrierCycleCount);
+    }
+#endif
+
+    // Ramp the frequency and depth while a profile is running
+    profile_isr_step(&liveWaveformPlan);
+
+#ifdef ISR_PROFILING
+    isr_stats_exit();
+#endif
+
+    // Clear the interrupt flag and acknowledge the interrupt in the PIE control register
+    hal_epwm_ack_interrupt();
+}
 
 void init_epwm_interrupts()
 {
@@ -110,9 +737,10 @@ void init_epwm_interrupts()
     InitPieVectTable();
 
     EALLOW; // Enables access to emulation and other protected registers
-    PieVectTable.EPWM1_INT = &epwm1_isr;
-    PieVectTable.EPWM2_INT = &epwm2_isr;
-    PieVectTable.EPWM3_INT = &epwm3_isr;
+    PieVectTable.EPWM1_INT = &epwm_three_phase_isr;
+#ifdef DMA_TABLE_MODE
+    PieVectTable.DINTCH1 = &dma_table_isr;
+#endif
     EDIS; // Disable access to emulation space and other protected registers
 
     // Initialize the ePWM modules, uncomment if you want epwm to initialize on startup
@@ -126,107 +754,89 @@ void init_epwm_interrupts()
 
     IER |= M_INT3; // Enable CPU INT3 which is connected to EPWM1-3 INT
 
-    // Enable EPWM INTn in the PIE: Group 3 interrupt 1-3
+    // Enable EPWM1 INT in the PIE: Group 3 interrupt 1 (the other channels are updated from the same ISR)
     PieCtrlRegs.PIEIER3.bit.INTx1 = 1;
-    PieCtrlRegs.PIEIER3.bit.INTx2 = 1;
-    PieCtrlRegs.PIEIER3.bit.INTx3 = 1;
+
+#ifdef DMA_TABLE_MODE
+    // DMA channel 1 counts the passes over the tables: Group 7 interrupt 1, only the tables interrupt
+    IER |= M_INT7;
+    PieCtrlRegs.PIEIER7.bit.INTx1 = 1;
+#endif
 
     EINT;    // Enable Global interrupt INTM
     ERTM;    // Enable Global real time interrupt DBGM
 }
 
-// Initialize registers for ePWM 1, 2, and 3
+// Initialize the registers of every ePWM channel in halEpwmChannels
 void Init_Epwmm()
 {
+    Uint16 ch;
+
     DINT; // Disable interrupts so no interrupts will interrupt the initialization of interrupts
 
-    //setup sync from EPWMxSYNC signal generated from PHSEN
-    EPwm1Regs.TBCTL.bit.SYNCOSEL = TB_SYNC_IN;  // Pass through
-    EPwm2Regs.TBCTL.bit.SYNCOSEL = TB_SYNC_IN;  // Pass through
-    EPwm3Regs.TBCTL.bit.SYNCOSEL = TB_SYNC_IN;  // Pass through
-
-    //allow sync
-    EPwm1Regs.TBCTL.bit.PHSEN = TB_ENABLE;
-    EPwm2Regs.TBCTL.bit.PHSEN = TB_ENABLE;
-    EPwm3Regs.TBCTL.bit.PHSEN = TB_ENABLE;
-
-    //The period register (TBPRD) is loaded from its shadow register
-    EPwm1Regs.TBCTL.bit.PRDLD  = TB_SHADOW;
-    EPwm2Regs.TBCTL.bit.PRDLD  = TB_SHADOW;
-    EPwm3Regs.TBCTL.bit.PRDLD  = TB_SHADOW;
-
-    // Count up/down mode
-    EPwm1Regs.TBCTL.bit.CTRMODE = TB_COUNT_UPDOWN;
-    EPwm2Regs.TBCTL.bit.CTRMODE = TB_COUNT_UPDOWN;
-    EPwm3Regs.TBCTL.bit.CTRMODE = TB_COUNT_UPDOWN;
-
-    // Clock ratio to SYSCLKOUT
-    EPwm1Regs.TBCTL.bit.HSPCLKDIV = TB_DIV1;
-    EPwm2Regs.TBCTL.bit.HSPCLKDIV = TB_DIV1;
-    EPwm3Regs.TBCTL.bit.HSPCLKDIV = TB_DIV1;
-
-    // Clock ratio to SYSCLKOUT
-    EPwm1Regs.TBCTL.bit.CLKDIV = TB_DIV1;
-    EPwm2Regs.TBCTL.bit.CLKDIV = TB_DIV1;
-    EPwm3Regs.TBCTL.bit.CLKDIV = TB_DIV1;
-
-    // Clear counter
-    EPwm1Regs.TBCTR = 0x0000;
-    EPwm2Regs.TBCTR = 0x0000;
-    EPwm3Regs.TBCTR = 0x0000;
-
-    //sets the phase angle for each wave
-    EPwm1Regs.TBPHS.half.TBPHS =
-            (Uint16) (liveEpwmParams.phaseLead1 / (360) * (liveEpwmParams.epwmTimerTBPRD));
-    EPwm2Regs.TBPHS.half.TBPHS =
-            (Uint16) (liveEpwmParams.phaseLead1 / (360) * (liveEpwmParams.epwmTimerTBPRD));
-    EPwm3Regs.TBPHS.half.TBPHS =
-            (Uint16) (liveEpwmParams.phaseLead1 / (360) * (liveEpwmParams.epwmTimerTBPRD));
-
-    // These bits determine the period of the time-base counter (sets the PWM frequency)
-    EPwm1Regs.TBPRD = liveEpwmParams.epwmTimerTBPRD;
-    EPwm2Regs.TBPRD = liveEpwmParams.epwmTimerTBPRD;
-    EPwm3Regs.TBPRD = liveEpwmParams.epwmTimerTBPRD;
-
-    // Sets compare A value to 0
-    EPwm1Regs.CMPA.half.CMPA = 0;
-    EPwm2Regs.CMPA.half.CMPA = 0;
-    EPwm3Regs.CMPA.half.CMPA = 0;
-
-    // Interrupt when counter = 0
-    EPwm1Regs.ETSEL.bit.INTSEL = ET_CTR_ZERO;
-    EPwm2Regs.ETSEL.bit.INTSEL = ET_CTR_ZERO;
-    EPwm3Regs.ETSEL.bit.INTSEL = ET_CTR_ZERO;
-
-    // Enable INT generation
-    EPwm1Regs.ETSEL.bit.INTEN = 1;
-    EPwm2Regs.ETSEL.bit.INTEN = 1;
-    EPwm3Regs.ETSEL.bit.INTEN = 1;
-
-    // Generate INT on 1st event
-    EPwm1Regs.ETPS.bit.INTPRD = ET_1ST;
-    EPwm2Regs.ETPS.bit.INTPRD = ET_1ST;
-    EPwm3Regs.ETPS.bit.INTPRD = ET_1ST;
-
-    // Enable shadow mode for Compare A registers of ePWMx (Operates as a double buffer.)
-    EPwm1Regs.CMPCTL.bit.SHDWAMODE = CC_SHADOW;
-    EPwm2Regs.CMPCTL.bit.SHDWAMODE = CC_SHADOW;
-    EPwm3Regs.CMPCTL.bit.SHDWAMODE = CC_SHADOW;
-
-    // Load From Shadow Select Mode when counter = Zero
-    EPwm1Regs.CMPCTL.bit.LOADAMODE = CC_CTR_ZERO;
-    EPwm2Regs.CMPCTL.bit.LOADAMODE = CC_CTR_ZERO;
-    EPwm3Regs.CMPCTL.bit.LOADAMODE = CC_CTR_ZERO;
-
-    // Set PWMxA on event A, up count
-    EPwm1Regs.AQCTLA.bit.CAU = AQ_SET;
-    EPwm2Regs.AQCTLA.bit.CAU = AQ_SET;
-    EPwm3Regs.AQCTLA.bit.CAU = AQ_SET;
-
-    // Clear PWMxA on event A, down count
-    EPwm1Regs.AQCTLA.bit.CAD = AQ_CLEAR;
-    EPwm2Regs.AQCTLA.bit.CAD = AQ_CLEAR;
-    EPwm3Regs.AQCTLA.bit.CAD = AQ_CLEAR;
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        volatile struct EPWM_REGS *regs = halEpwmChannels[ch].regs;
+
+        //setup sync from EPWMxSYNC signal generated from PHSEN
+        regs->TBCTL.bit.SYNCOSEL = TB_SYNC_IN;  // Pass through
+
+        //allow sync
+        regs->TBCTL.bit.PHSEN = TB_ENABLE;
+
+        //The period register (TBPRD) is loaded from its shadow register
+        regs->TBCTL.bit.PRDLD  = TB_SHADOW;
+
+        // Count up/down mode
+        regs->TBCTL.bit.CTRMODE = TB_COUNT_UPDOWN;
+
+        // Clock ratio to SYSCLKOUT, chosen by the timer planner (see plan_timebase())
+        regs->TBCTL.bit.HSPCLKDIV = liveWaveformPlan.hspClkDiv;
+        regs->TBCTL.bit.CLKDIV = liveWaveformPlan.clkDiv;
+
+        // Clear counter
+        regs->TBCTR = 0x0000;
+
+        //sets the phase angle for each wave
+        regs->TBPHS.half.TBPHS =
+                (Uint16) (liveEpwmParams.phaseLead[0] / (360) * (liveEpwmParams.epwmTimerTBPRD));
+
+        // These bits determine the period of the time-base counter (sets the PWM frequency)
+        regs->TBPRD = liveEpwmParams.epwmTimerTBPRD;
+
+        // Sets compare A value to 0
+        regs->CMPA.half.CMPA = 0;
+
+        // Interrupt when counter = 0
+        regs->ETSEL.bit.INTSEL = ET_CTR_ZERO;
+
+        // Enable INT generation on ePWM1 only, its ISR updates every channel
+        regs->ETSEL.bit.INTEN = (ch == 0);
+
+        // Generate INT on 1st event, the ISR switches ePWM1 to every 2nd / 3rd event itself when it decimates
+        regs->ETPS.bit.INTPRD = ET_1ST;
+
+        // Enable shadow mode for Compare A registers of ePWMx (Operates as a double buffer.)
+        regs->CMPCTL.bit.SHDWAMODE = CC_SHADOW;
+
+        // Load From Shadow Select Mode when counter = Zero
+        regs->CMPCTL.bit.LOADAMODE = CC_CTR_ZERO;
+
+        // Set PWMxA on event A, up count
+        regs->AQCTLA.bit.CAU = AQ_SET;
+
+        // Clear PWMxA on event A, down count
+        regs->AQCTLA.bit.CAD = AQ_CLEAR;
+    }
+
+#ifdef HRPWM_MODE
+    // High resolution compare and period, the fractional period is loaded with TBPRD
+    hrpwm_init();
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        hal_epwm_write_period_hr(ch, liveWaveformPlan.timerPeriodHR);
+    }
+#endif
 
     EINT;  //   Enable interrupts
 
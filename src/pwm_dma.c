@@ -0,0 +1,280 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include "pwm_dma.h"
+
+// One sine period of compare values per channel, twice, in the DMA accessible RAM blocks reserved in F28069M.cmd.
+// The second copy lets the DMA start at any index and still stream one whole period without a wrap.
+#pragma DATA_SECTION(dmaCmpaTable1, "DMARAML5");
+#pragma DATA_SECTION(dmaCmpaTable2, "DMARAML6");
+#pragma DATA_SECTION(dmaCmpaTable3, "DMARAML7");
+Uint16 dmaCmpaTable1[2 * DMA_TABLE_MAX_SIZE];
+Uint16 dmaCmpaTable2[2 * DMA_TABLE_MAX_SIZE];
+Uint16 dmaCmpaTable3[2 * DMA_TABLE_MAX_SIZE];
+
+// Set while the DMA (not the ISR) is writing the compare values
+Uint16 dmaTableModeActive = 0;
+
+// Set by dma_start_table_mode(), cleared by the ISR once it has handed the outputs over
+volatile Uint16 dmaTableStartPending = 0;
+
+// Phase the ISR resumes from after dma_stop_table_mode()
+Uint16 dmaResumePending = 0;
+Uint32 dmaResumePhase = 0;
+
+// Tables the DMA streams: phase word of entry 0, entries per period, entry of the first compare streamed,
+// carrierCycleCount at the handover and passes over the tables so far (dma_table_isr())
+static Uint32 dmaTableBase;
+static Uint16 dmaTableLength;
+static Uint16 dmaTableStart;
+static Uint32 dmaTableCycle;
+static volatile Uint32 dmaTablePasses;
+
+// Ring of interpolated compares the decimated ISR fills, two halves of dmaRingDivisor entries per channel
+#pragma DATA_SECTION(dmaCmpaRing, "DMARAML8");
+Uint16 dmaCmpaRing[HAL_EPWM_CHANNELS][DMA_RING_SIZE];
+
+// PWM periods per ISR call the ePWM1 interrupt and the ring are set up for, 1 while the ring is stopped
+Uint16 dmaRingDivisor = 1;
+
+/*
+ * Checks whether one sine period of the given parameters fits a DMA table.
+ * Returns the number of PWM periods per sine period, or 0 if the ratio is not a whole number
+ * or does not fit (the ISR is used then).
+ */
+Uint16 dma_table_length(const EPwmParams *params)
+{
+    if (params->sinWavFreq <= 0 || HAL_EPWM_CHANNELS != DMA_CHANNELS)
+    {
+        return 0;
+    }
+
+    float ratio = params->pwmWavFreq / params->sinWavFreq;
+    Uint32 length = (Uint32) (ratio + 0.5);
+
+    if (length < DMA_TABLE_MIN_SIZE || length > DMA_TABLE_MAX_SIZE
+            || fabsf(ratio - (float) length) > DMA_RATIO_TOLERANCE * ratio)
+    {
+        return 0;
+    }
+
+    return (Uint16) length;
+}
+
+/*
+ * Configures DMA channels 1-6 once, channels 1-3 and 4-6 each write the CMPA shadow register of ePWM 1-3, one
+ * word per ePWM1 SOCA (counter zero). They stay stopped until dma_stream() points them at a source, so the ISR never has to reset
+ * or reconfigure the DMA. Call before the ePWM interrupt is enabled.
+ */
+void dma_init(void)
+{
+    EALLOW;
+    SysCtrlRegs.PCLKCR3.bit.DMAENCLK = 1;  // Enable the DMA clock
+    EDIS;
+
+    DMAInitialize();
+
+    // One word per burst (one burst per SOCA), source steps through the block, destination stays on CMPA
+    // In continuous mode the addresses reload from the shadow registers (the start of the block) after each full transfer
+    // Channels 1-3 stream the tables, channel 1 interrupts after every pass over them (dma_table_isr())
+    DMACH1AddrConfig(&EPwm1Regs.CMPA.half.CMPA, dmaCmpaTable1);
+    DMACH1BurstConfig(0, 0, 0);
+    DMACH1TransferConfig(DMA_TABLE_MAX_SIZE - 1, 1, 0);
+    DMACH1WrapConfig(0xFFFF, 0, 0xFFFF, 0);
+    DMACH1ModeConfig(DMA_EPWM1A, PERINT_ENABLE, ONESHOT_DISABLE, CONT_ENABLE, SYNC_DISABLE,
+                     SYNC_SRC, OVRFLOW_DISABLE, SIXTEEN_BIT, CHINT_END, CHINT_ENABLE);
+
+    DMACH2AddrConfig(&EPwm2Regs.CMPA.half.CMPA, dmaCmpaTable2);
+    DMACH2BurstConfig(0, 0, 0);
+    DMACH2TransferConfig(DMA_TABLE_MAX_SIZE - 1, 1, 0);
+    DMACH2WrapConfig(0xFFFF, 0, 0xFFFF, 0);
+    DMACH2ModeConfig(DMA_EPWM1A, PERINT_ENABLE, ONESHOT_DISABLE, CONT_ENABLE, SYNC_DISABLE,
+                     SYNC_SRC, OVRFLOW_DISABLE, SIXTEEN_BIT, CHINT_END, CHINT_DISABLE);
+
+    DMACH3AddrConfig(&EPwm3Regs.CMPA.half.CMPA, dmaCmpaTable3);
+    DMACH3BurstConfig(0, 0, 0);
+    DMACH3TransferConfig(DMA_TABLE_MAX_SIZE - 1, 1, 0);
+    DMACH3WrapConfig(0xFFFF, 0, 0xFFFF, 0);
+    DMACH3ModeConfig(DMA_EPWM1A, PERINT_ENABLE, ONESHOT_DISABLE, CONT_ENABLE, SYNC_DISABLE,
+                     SYNC_SRC, OVRFLOW_DISABLE, SIXTEEN_BIT, CHINT_END, CHINT_DISABLE);
+
+    // Channels 4-6 stream the decimation ring, without interrupts
+    DMACH4AddrConfig(&EPwm1Regs.CMPA.half.CMPA, dmaCmpaRing[0]);
+    DMACH4BurstConfig(0, 0, 0);
+    DMACH4TransferConfig(DMA_RING_SIZE - 1, 1, 0);
+    DMACH4WrapConfig(0xFFFF, 0, 0xFFFF, 0);
+    DMACH4ModeConfig(DMA_EPWM1A, PERINT_ENABLE, ONESHOT_DISABLE, CONT_ENABLE, SYNC_DISABLE,
+                     SYNC_SRC, OVRFLOW_DISABLE, SIXTEEN_BIT, CHINT_END, CHINT_DISABLE);
+
+    DMACH5AddrConfig(&EPwm2Regs.CMPA.half.CMPA, dmaCmpaRing[1]);
+    DMACH5BurstConfig(0, 0, 0);
+    DMACH5TransferConfig(DMA_RING_SIZE - 1, 1, 0);
+    DMACH5WrapConfig(0xFFFF, 0, 0xFFFF, 0);
+    DMACH5ModeConfig(DMA_EPWM1A, PERINT_ENABLE, ONESHOT_DISABLE, CONT_ENABLE, SYNC_DISABLE,
+                     SYNC_SRC, OVRFLOW_DISABLE, SIXTEEN_BIT, CHINT_END, CHINT_DISABLE);
+
+    DMACH6AddrConfig(&EPwm3Regs.CMPA.half.CMPA, dmaCmpaRing[2]);
+    DMACH6BurstConfig(0, 0, 0);
+    DMACH6TransferConfig(DMA_RING_SIZE - 1, 1, 0);
+    DMACH6WrapConfig(0xFFFF, 0, 0xFFFF, 0);
+    DMACH6ModeConfig(DMA_EPWM1A, PERINT_ENABLE, ONESHOT_DISABLE, CONT_ENABLE, SYNC_DISABLE,
+                     SYNC_SRC, OVRFLOW_DISABLE, SIXTEEN_BIT, CHINT_END, CHINT_DISABLE);
+}
+
+/*
+ * Streams length words from each source into CMPA of ePWM 1-3 through three DMA channels from first on, starting
+ * at the next ePWM1 SOCA, the sources repeat from their start after length words. Only the source and transfer
+ * size change, dma_init() set up the rest, so the ISR can call this.
+ */
+#pragma CODE_SECTION(dma_stream, "ramfuncs");
+static void dma_stream(Uint16 first, const Uint16 *source1, const Uint16 *source2, const Uint16 *source3,
+                       Uint16 length)
+{
+    hal_dma_start(first, source1, length);
+    hal_dma_start(first + 1, source2, length);
+    hal_dma_start(first + 2, source3, length);
+
+    // SOCA on every counter zero triggers the DMA
+    EPwm1Regs.ETSEL.bit.SOCASEL = ET_CTR_ZERO;
+    EPwm1Regs.ETPS.bit.SOCAPRD = ET_1ST;
+    EPwm1Regs.ETSEL.bit.SOCAEN = 1;
+}
+
+// Stops the SOCA and the three DMA channels from first on
+#pragma CODE_SECTION(dma_halt, "ramfuncs");
+static void dma_halt(Uint16 first)
+{
+    EPwm1Regs.ETSEL.bit.SOCAEN = 0;
+    hal_dma_halt(first);
+    hal_dma_halt(first + 1);
+    hal_dma_halt(first + 2);
+}
+
+// Phase word of table entry index, the entries spread exactly one period over the table
+static Uint32 table_phase(Uint16 index)
+{
+    return dmaTableBase + (Uint32) (((Uint64) index << 32) / dmaTableLength);
+}
+
+/*
+ * Fills the compare tables with one period of the live plan and hands the outputs from the ISR to DMA channels
+ * 1-3. The tables start at the phase of the plan's first compare (planAppliedPhase), so every phase the ISR
+ * reaches afterwards falls on a table entry; the ISR hands over at its next call (dma_take_over()), the DMA
+ * carries on from the entry of the ISR's phase. The ISR has to run the plan already (wait_for_plan_update()),
+ * one ISR call per period (no decimation). Waits for the handover, at most two PWM periods.
+ */
+void dma_start_table_mode(const WaveformPlan *plan, Uint16 length)
+{
+    Uint16 i;
+
+    dmaTableBase = planAppliedPhase;
+    dmaTableLength = length;
+    for (i = 0; i < length; i++)
+    {
+        Uint16 compare[HAL_EPWM_CHANNELS];
+        compare_values(plan, table_phase(i), compare);
+        dmaCmpaTable1[i] = dmaCmpaTable1[length + i] = compare[0];
+        dmaCmpaTable2[i] = dmaCmpaTable2[length + i] = compare[1];
+        dmaCmpaTable3[i] = dmaCmpaTable3[length + i] = compare[2];
+    }
+
+    dmaTableStartPending = 1;
+    while (dmaTableStartPending)
+    {
+        hal_busy_wait();
+    }
+}
+
+/*
+ * Called from the ISR right after it wrote the compares of the next period and advanced the phase. The DMA
+ * writes the compares from phase on into the shadow registers at the next SOCA, they load a period later
+ * like the ones the ISR would have written next. The ePWM1 interrupt is disabled while the DMA runs.
+ */
+#pragma CODE_SECTION(dma_take_over, "ramfuncs");
+void dma_take_over(Uint32 phase, Uint32 cycleCount)
+{
+    // Nearest entry, phase - dmaTableBase is a whole number of tuning words and those step one entry each
+    Uint16 start = (((phase - dmaTableBase) >> 16) * dmaTableLength + 0x8000) >> 16;
+    if (start >= dmaTableLength)
+    {
+        start -= dmaTableLength;
+    }
+
+    EPwm1Regs.ETSEL.bit.INTEN = 0;
+    dma_stream(0, &dmaCmpaTable1[start], &dmaCmpaTable2[start], &dmaCmpaTable3[start], dmaTableLength);
+
+    dmaTableStart = start;
+    dmaTableCycle = cycleCount;
+    dmaTablePasses = 0;
+    dmaTableModeActive = 1;
+    dmaTableStartPending = 0;
+}
+
+// DMA channel 1 finished one pass over the tables, one sine period
+#pragma CODE_SECTION(dma_table_isr, "ramfuncs");
+__interrupt void dma_table_isr(void)
+{
+    dmaTablePasses++;
+    hal_dma_ack_interrupt();
+}
+
+// Periods the DMA has written since the handover, call with interrupts disabled: a pass that has just ended
+// is still flagged in the PIE then, not yet counted by dma_table_isr()
+static Uint32 table_periods(void)
+{
+    return (dmaTablePasses + PieCtrlRegs.PIEIFR7.bit.INTx1) * dmaTableLength + hal_dma_transfer_position(0);
+}
+
+// carrierCycleCount as the ISR would have counted it, the ISR does not run while the DMA streams the tables
+Uint32 dma_table_cycle_count(void)
+{
+    Uint32 cycle;
+
+    DINT;
+    cycle = dmaTableCycle + table_periods();
+    EINT;
+    return cycle;
+}
+
+/*
+ * Stops the DMA channels and re-enables the ePWM1 interrupt. The ISR resumes from the phase of the next table
+ * entry, carrierCycleCount moves on by the periods the DMA wrote, so the sine and the cycle count carry on.
+ */
+void dma_stop_table_mode(void)
+{
+    Uint32 periods;
+
+    DINT;
+    dma_halt(0);
+    periods = table_periods();
+    EINT;
+
+    // The n-th word was written at counter zero n after the handover and loads one period later
+    carrierCycleCount = dmaTableCycle + periods;
+    dmaResumePhase = table_phase((dmaTableStart + periods) % dmaTableLength);
+    dmaResumePending = 1;
+    dmaTableModeActive = 0;
+
+    EPwm1Regs.ETCLR.bit.INT = 1;
+    EPwm1Regs.ETSEL.bit.INTEN = 1;
+}
+
+/*
+ * Streams the decimation ring into CMPA and switches the ePWM1 interrupt to every divisor-th period.
+ * Called from the ISR right after a counter zero, once both ring halves hold the next compares.
+ */
+#pragma CODE_SECTION(dma_start_ring, "ramfuncs");
+void dma_start_ring(Uint16 divisor)
+{
+    dma_stream(3, dmaCmpaRing[0], dmaCmpaRing[1], dmaCmpaRing[2], 2 * divisor);
+    hal_epwm_write_interrupt_divisor(divisor);
+    dmaRingDivisor = divisor;
+}
+
+// Stops the decimation ring, the ePWM1 interrupt fires every period again and the ISR writes CMPA itself
+#pragma CODE_SECTION(dma_stop_ring, "ramfuncs");
+void dma_stop_ring(void)
+{
+    dma_halt(3);
+
+    hal_epwm_write_interrupt_divisor(1);
+    dmaRingDivisor = 1;
+}
@@ -1,269 +1,181 @@
 #include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
 #include "sci.h"
+#include "hal.h"
 
 // Data from serial communications writes to live structure once processed and confirmed
 
+// Ring buffers between the SCI FIFO interrupts and the main loop (single producer, single consumer).
+// Each index is only written by one side, head by the producer and tail by the consumer.
+static char sciaRxRing[SCIA_RX_RING_SIZE];
+static volatile Uint16 sciaRxHead = 0;
+static volatile Uint16 sciaRxTail = 0;
+static char sciaTxRing[SCIA_TX_RING_SIZE];
+static volatile Uint16 sciaTxHead = 0;
+static volatile Uint16 sciaTxTail = 0;
+
+// Baud rate register waiting for the TX ring buffer to drain, 0 if none
+static Uint16 pendingBaudRegister = 0;
+
+// Characters dropped because a ring buffer (or the RX FIFO) was full
+volatile Uint32 sciaRxOverflowCount = 0;
+volatile Uint32 sciaTxOverflowCount = 0;
+
+// Set while waiting for the Y/N answer to the confirmation prompt, bufferEpwmParams then holds the values to confirm
+static Uint16 awaitingConfirmation = 0;
+
 /*
- * Handles a received character from SCI, builds a command buffer, and processes it.
- * Echoes back user input and manages parameter confirmation and update.
+ * Handles a received character from SCI, feeds it straight to the command parser and
+ * asks for confirmation once the terminator completes a valid command.
  */
 void handle_received_char(Uint16 ReceivedChar)
 {
-    // Buffer for incoming data and buffer index
-    static char buffer[MAX_BUFFER_SIZE];
-    static Uint16 bufferIndex = 0;
+    // Parses the command as it arrives, the state starts zeroed which is the idle state
+    static CommandParser parser;
+
+    // Set after the answer until its terminator has arrived, the rest of the answer line is no command
+    static Uint16 awaitingTerminator = 0;
+
+    Uint16 result;
 
-    // Check to see if final charcater was processed (always end with terminating character)
-    if (ReceivedChar == '\0')
+    if (awaitingTerminator)
     {
-        //echo back user input
-        buffer[bufferIndex] = '\0';
-        scia_msg(NEWLINE NEWLINE "You sent: ");
-        scia_msg(buffer);
+        awaitingTerminator = (ReceivedChar != COMMAND_TERMINATOR);
+        return;
+    }
 
-        // Check for errors and user confirmation of values
-        if (process_buffer(buffer) && confirm_values())
-        {
-            scia_msg(NEWLINE NEWLINE"Values confirmed and set.");
-            memcpy(&liveEpwmParams, &bufferEpwmParams, sizeof(EPwmParams)); // Copy new values to original
-            liveEpwmParams.epwmTimerTBPRD = (Uint32)(0.5 * (PWMCLKFREQ / liveEpwmParams.pwmWavFreq));
-            Init_Epwmm();
-        }
-        else
+    if (awaitingConfirmation)
+    {
+        int confirm = confirm_values(ReceivedChar);
+        if (confirm == 2)
         {
-            scia_msg(NEWLINE NEWLINE"Values reset to:");
-            print_params(&liveEpwmParams);  // Print the original values
-            memcpy(&bufferEpwmParams, &liveEpwmParams, sizeof(EPwmParams)); // Copy old values
+            return; // Not Y or N, keep waiting
         }
 
-        // Reset the buffer for the next input
-        bufferIndex = 0;
-        memset(buffer, 0, MAX_BUFFER_SIZE);
+        awaitingConfirmation = 0;
+        awaitingTerminator = 1;
+        set_or_reset_params(confirm);
         clear_scia_rx_buffer();
         print_welcome_screen();  // Print the welcome message again
+        return;
     }
-    else
+
+    // A new command starts on top of the live parameters, echo back user input as it arrives
+    if (command_parser_idle(&parser))
+    {
+        command_parser_reset(&parser, &liveEpwmParams);
+        scia_msg(NEWLINE NEWLINE "You sent: ");
+    }
+    if (ReceivedChar != COMMAND_TERMINATOR)
     {
-        // Populates buffer array if there's space
-        if (bufferIndex < MAX_BUFFER_SIZE - 1)
+        scia_xmit(ReceivedChar);
+    }
+
+    result = command_parser_feed(&parser, (char) ReceivedChar);
+    if (result == COMMAND_FAILED)
+    {
+        // Report the first error right away, the rest of the command is ignored
+        if (parser.error == COMMAND_ERROR_CHARACTER)
         {
-            buffer[bufferIndex++] = ReceivedChar;
+            report_invalid_input(parser.errorChar);
         }
         else
         {
-            // Handle buffer overflow error
-            scia_msg(
-                 NEWLINE NEWLINE"Error: Input buffer overflow. Buffer reset.");
-            bufferIndex = 0; // Reset buffer index to avoid overflow
-            memset(buffer, 0, MAX_BUFFER_SIZE);
-            clear_scia_rx_buffer();
-            print_welcome_screen();  // Print the welcome message again
+            scia_msg(NEWLINE NEWLINE);
+            scia_msg(command_parser_error_message(parser.error));
         }
     }
-}
-
-/*
- * Processes the input buffer to extract and update PWM parameters.
- * Returns 1 if successful, 0 if errors occurred during processing.
- */
-int process_buffer(const char *buffer)
-{
-
-    int i = 0, error = 0;
-    while (buffer[i] != '\0' && error == 0) // Loops until null character is found
+    else if (result == COMMAND_VALID)
     {
-        // Skips white space and skips to parameter
-        if (buffer[i] == ',' || buffer[i] == '.')
-            i++;
-        while (buffer[i] == ' ')
-            i++;
-
-        // Identify the parameter and populate its value
-        switch (buffer[i])
-        {
-        case 'P':
-        case 'p':
-            error = populate_variable(&(buffer[i]),
-                                      &bufferEpwmParams.pwmWavFreq,
-                                      PWMWAVFREQ_MIN,
-                                      PWMWAVFREQ_MAX, &i);
-            break;
-        case 'S':
-        case 's':
-            error = populate_variable(&(buffer[i]),
-                                      &bufferEpwmParams.sinWavFreq,
-                                      SINWAVFREQ_MIN,
-                                      SINWAVFREQ_MAX, &i);
-            break;
-        case 'M':
-        case 'm':
-            error = populate_variable(&(buffer[i]),
-                                      &bufferEpwmParams.modulation_depth,
-                                      MODULATION_DEPTH_MIN,
-                                      MODULATION_DEPTH_MAX, &i);
-            break;
-        case 'O':
-        case 'o':
-            error = populate_variable(&(buffer[i]), &bufferEpwmParams.offset, -1,
-                                      1, &i);
-            break;
-        case 'A':
-        case 'a':
-            i++;
-            if (buffer[i] == '1')
-            {
-                error = populate_variable(&buffer[i], &bufferEpwmParams.phaseLead1,
-                MIN_ANGLE,
-                                          MAX_ANGLE, &i);
-            }
-            else if (buffer[i] == '2')
-            {
-                error = populate_variable(&buffer[i], &bufferEpwmParams.phaseLead2,
-                MIN_ANGLE,
-                                          MAX_ANGLE, &i);
-            }
-            else if (buffer[i] == '3')
-            {
-                error = populate_variable(&buffer[i], &bufferEpwmParams.phaseLead3,
-                MIN_ANGLE,
-                                          MAX_ANGLE, &i);
-            }
-            else
-            {
-                report_invalid_input(buffer[i]);
-                error = 1;
-            }
-            break;
-
-        default:
-            report_invalid_input(buffer[i]);
-            error = 1;
-            break;
-        }
+        // The parameter set is already validated, ask for user confirmation of values
+        memcpy(&bufferEpwmParams, &parser.params, sizeof(EPwmParams));
+        prompt_confirmation();
+        awaitingConfirmation = 1;
     }
-
-    // Check offset range (since offset depends on modulation depth
-    if (bufferEpwmParams.offset > (1 - bufferEpwmParams.modulation_depth) / 2
-            || bufferEpwmParams.offset < -(1 - bufferEpwmParams.modulation_depth) / 2)
+    else if (result == COMMAND_INVALID)
     {
-        bufferEpwmParams.offset = liveEpwmParams.offset;
-        scia_msg(NEWLINE NEWLINE"Offset out of range");
-        error = 1;
+        // Errors found at the terminator have not been reported yet
+        if (parser.errorChar == COMMAND_TERMINATOR)
+        {
+            scia_msg(NEWLINE NEWLINE);
+            scia_msg(command_parser_error_message(parser.error));
+        }
+        set_or_reset_params(0);
+        clear_scia_rx_buffer();
+        print_welcome_screen();  // Print the welcome message again
     }
-
-    return error ? 0 : 1;    //Returns 0 if there was an error
 }
 
 /*
- * Parses a portion of the input buffer to populate a float variable.
- * Checks if the value is within specified range.
- * Returns 0 if successful, 1 if error occurred (out of range or invalid input).
+ * Applies the buffered parameters to the outputs if confirmed,
+ * otherwise restores the buffered parameters from the live ones.
  */
-int populate_variable(const char *arr, float *var, const float min, const float max,
-                      int *pindex)
+void set_or_reset_params(int confirmed)
 {
-    char temp[5] = { '\0' };  // Temporary array to hold input value
-
-    int i = 1, j = 0, periodCount = 0;
-
-    // Check for invalid input (multiple letters)
-    if (arr[i] > '@' && arr[i] < 'z')
+    if (confirmed)
     {
-        scia_msg("\r\nInvalid input : ");
-        scia_msg(&arr[i - 1]);
-        return 1;
+        scia_msg(NEWLINE NEWLINE"Values confirmed and set.");
+        memcpy(&liveEpwmParams, &bufferEpwmParams, sizeof(EPwmParams)); // Copy new values to original, the ISR only sees them once apply_live_params() hands it the compiled plan
+        apply_live_params();
+        wait_for_plan_update();
+        print_achieved(&liveWaveformPlan);
     }
-
-    // Skips space between letter and number
-    while (arr[i] == ' ')
-        i++;
-
-    // Copies number from arr (buffer) to temp array
-    while (arr[i] != '\0' && (arr[i] == '.' || arr[i] == '-' || (arr[i] >= '0' && arr[i] <= '9')))
-    {
-        // Check if number is too many digits, 5 because max digits is 5 (10000)
-        if (j > 5)
-        {
-            scia_msg(NEWLINE"Number input has too many digits");
-            report_invalid_input(*temp);
-            return 1;
-        }
-
-        if (arr[i] == '.')
-        {
-            periodCount++;  // Increment period count
-        }
-
-        temp[j++] = arr[i++];   // Copy the character to the temporary array
-    }
-
-    // Check if there are multiple periods
-    if (periodCount > 1)
-    {
-        scia_msg(NEWLINE"Input has too many decimal points");
-        report_invalid_input(*temp);
-        return 1;
-    }
-
-    // Convert the temporary array to a float and check its range
-    *var = atof(temp);
-    if (*var < min || *var > max)
+    else
     {
-        scia_msg(NEWLINE"Value out of bound: ");
-        scia_msg(temp);
-        return 1;
+        scia_msg(NEWLINE NEWLINE"Values reset to:");
+        print_params(&liveEpwmParams);  // Print the original values
+        memcpy(&bufferEpwmParams, &liveEpwmParams, sizeof(EPwmParams)); // Copy old values
     }
-
-    // Update the index and return success
-    *pindex += i;
-    return 0;
 }
 
 /*
- * Prompts the user to confirm the new PWM values and returns the confirmation status.
- * Returns 1 if confirmed, 0 if not confirmed.
+ * Call after a binary command, a profile or a preset changed liveEpwmParams. A pending Y/N confirmation
+ * was asked for values built on the old live parameters, so it is cancelled rather than applied over
+ * the new ones, and the buffered parameters follow the live ones again.
  */
-int confirm_values(void)
+void live_params_changed(void)
 {
+    if (awaitingConfirmation)
+    {
+        awaitingConfirmation = 0;
+        scia_msg(NEWLINE NEWLINE "Parameters changed by a binary command, confirmation cancelled.");
+    }
+    memcpy(&bufferEpwmParams, &liveEpwmParams, sizeof(EPwmParams));
+}
 
-    Uint16 confirm = 2;
-    Uint16 RecivedChar = 0;
-
+// Prompts the user to confirm the new PWM values, the answer is checked by confirm_values().
+void prompt_confirmation(void)
+{
     // Ask the user to confirm the values
     scia_msg(NEWLINE NEWLINE"PLEASE CONFIRM THE VALUES (Y/N):  ");
     print_params(&bufferEpwmParams);
+}
 
-    // Wait for a valid response
-    while (confirm == 2)
+/*
+ * Checks the user's answer to the confirmation prompt.
+ * Returns 1 if confirmed, 0 if not confirmed, 2 if the answer was not Y or N.
+ */
+int confirm_values(Uint16 ReceivedChar)
+{
+    // Check the response
+    if (ReceivedChar == 'Y' || ReceivedChar == 'y')
     {
-        while (SciaRegs.SCIFFRX.bit.RXFFST < 1)
-        {
-            // Wait for a character
-        }
-        RecivedChar = SciaRegs.SCIRXBUF.all;    // Read received character
-
-        // Check the response
-        if (RecivedChar == 'Y' || RecivedChar == 'y')
-        {
-            confirm = 1;
-        }
-        else if (RecivedChar == 'N' || RecivedChar == 'n')
-        {
-            confirm = 0;
-        }
-        else
-        {
-            scia_msg(NEWLINE "Invalid input. Please enter Y or N.");
-            SciaRegs.SCIRXBUF.all;
-        }
-
+        return 1;
     }
-    return confirm; //if Y in input, return 1 to handle receive char, N returns 0 as false
+    else if (ReceivedChar == 'N' || ReceivedChar == 'n')
+    {
+        return 0;
+    }
+
+    scia_msg(NEWLINE "Invalid input. Please enter Y or N.");
+    return 2;
 }
 
 // Prints the given PWM parameters to the serial terminal.
 void print_params(const EPwmParams *arr)
 {
+    char angleLabel[] = "Angle 1 = ";
+    Uint16 ch;
+
     scia_msg(NEWLINE NEWLINE "PWM frequency = ");
     float_to_string(arr->pwmWavFreq);
 
@@ -273,17 +185,41 @@ void print_params(const EPwmParams *arr)
     scia_msg(NEWLINE "Modulation depth = ");
     float_to_string(arr->modulation_depth);
 
+    scia_msg(NEWLINE "Modulation mode = ");
+    float_to_string(arr->modulationMode);
+
     scia_msg(NEWLINE "Offset = ");
     float_to_string(arr->offset);
 
-    scia_msg(NEWLINE "Angle 1 = ");
-    float_to_string(arr->phaseLead1);
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        angleLabel[6] = '1' + ch;
+        scia_msg(NEWLINE);
+        scia_msg(angleLabel);
+        float_to_string(arr->phaseLead[ch]);
+    }
+}
+
+/*
+ * Prints the carrier and sine frequencies the timer planner achieved for the requested ones,
+ * the time base prescaler and TBPRD, and how many PWM periods pass per ISR call.
+ */
+void print_achieved(const WaveformPlan *plan)
+{
+    scia_msg(NEWLINE "Achieved PWM frequency = ");
+    float_to_string(plan->carrierFreq);
+
+    scia_msg(NEWLINE "Achieved sin wave frequency = ");
+    float_to_string(plan->sineFreq);
 
-    scia_msg(NEWLINE "Angle 2 = ");
-    float_to_string(arr->phaseLead2);
+    scia_msg(NEWLINE "Clock prescaler = ");
+    float_to_string(plan->clockPrescale);
 
-    scia_msg(NEWLINE "Angle 3 = ");
-    float_to_string(arr->phaseLead3);
+    scia_msg(NEWLINE "Timer period = ");
+    float_to_string(plan->timerPeriod);
+
+    scia_msg(NEWLINE "PWM periods per interrupt = ");
+    float_to_string(plan->interruptDivisor);
 }
 
 // Converts a float value to a string and sends it via SCI.
@@ -324,23 +260,100 @@ void report_invalid_input(const char invalid_char)
     scia_msg(msg);
 }
 
-// Clears the SCI A RX buffer to remove any remaining data.
+// Clears the SCI A RX ring buffer to remove any remaining data.
 void clear_scia_rx_buffer()
 {
-    while (SciaRegs.SCIFFRX.bit.RXFFST != 0)
+    sciaRxTail = sciaRxHead;
+}
+
+/*
+ * Reads one received character from the RX ring buffer without waiting.
+ * Returns 1 and stores the character if one was available, 0 otherwise.
+ */
+int scia_read(Uint16 *ReceivedChar)
+{
+    Uint16 tail = sciaRxTail;
+    if (tail == sciaRxHead)
+    {
+        return 0;
+    }
+
+    *ReceivedChar = sciaRxRing[tail] & 0xFF;  // Bytes above 0x7F (binary frames) stay positive where char is signed
+    sciaRxTail = (tail + 1) & (SCIA_RX_RING_SIZE - 1);
+    return 1;
+}
+
+/*
+ * Queues a single ASCII character for transmission via the SCI from micro to terminal, without waiting.
+ * Returns 1 if queued, 0 if the TX ring buffer was full and the character was dropped.
+ */
+int scia_xmit(int asciiValue)
+{
+    Uint16 head = sciaTxHead;
+    Uint16 next = (head + 1) & (SCIA_TX_RING_SIZE - 1);
+    if (next == sciaTxTail)
+    {
+        sciaTxOverflowCount++;
+        return 0;
+    }
+
+    sciaTxRing[head] = asciiValue;
+    sciaTxHead = next;
+
+    // (Re)enable the TX FIFO interrupt, it fires right away if the FIFO is empty
+    hal_scia_tx_interrupt_enable(1);
+    return 1;
+}
+
+// Returns the number of characters that can be queued before the TX ring buffer is full
+Uint16 scia_tx_free(void)
+{
+    return (sciaTxTail - sciaTxHead - 1) & (SCIA_TX_RING_SIZE - 1);
+}
+
+// Returns the baud rate register value for the requested baud rate, 0 if it cannot be reached within SCIA_BAUD_TOLERANCE
+static Uint16 scia_baud_register(Uint32 baud)
+{
+    if (baud == 0)
+    {
+        return 0;
+    }
+
+    float brr = (float) SCIA_LSPCLK / (baud * 8.0) - 1;
+    if (brr < 1 || brr > 0xFFFF)
     {
-        char temp = SciaRegs.SCIRXBUF.all;
+        return 0;
     }
+
+    Uint16 rounded = (Uint16) (brr + 0.5);
+    float actual = (float) SCIA_LSPCLK / ((rounded + 1) * 8.0);
+    if (fabsf(actual - baud) > SCIA_BAUD_TOLERANCE * baud)
+    {
+        return 0;
+    }
+    return rounded;
+}
+
+// Returns 1 if the baud rate can be generated within SCIA_BAUD_TOLERANCE
+int scia_baud_valid(Uint32 baud)
+{
+    return scia_baud_register(baud) != 0;
 }
 
-// Transmits a single ASCII character via the SCI from terminal to micro.
-void scia_xmit(int asciiValue)
+// Switches the baud rate once everything queued so far (including the reply to the request) has been sent
+void scia_request_baud(Uint32 baud)
 {
-    while (SciaRegs.SCIFFTX.bit.TXFFST != 0)
+    pendingBaudRegister = scia_baud_register(baud);
+}
+
+// Background SCI work for the main loop, applies a requested baud rate once the transmitter is idle
+void scia_service(void)
+{
+    if (pendingBaudRegister && sciaTxTail == sciaTxHead && hal_scia_tx_idle())
     {
-        // Wait for the transmit buffer to be empty
+        hal_scia_set_baud_register(pendingBaudRegister);
+        pendingBaudRegister = 0;
     }
-    SciaRegs.SCITXBUF = asciiValue; // Placed below to ensure that the transmit buffer is empty before attempting to send data
 }
 
 // Sends string char by char to transmit function
@@ -356,25 +369,36 @@ void scia_msg(const char *msg)
 // Prints the welcome screen message to the serial terminal.
 void print_welcome_screen(void)
 {
+    char line[160];
+
     scia_msg(
             NEWLINE "-------------------------------------------------------------------------------------------------"
 
-            NEWLINE "Please Enter a string in the format PARAMATER1 VALUE1,PARAMATER2 VALUE2 (for example: P 2500, S 60,M .13)"
+            NEWLINE "Please Enter a string in the format PARAMATER1 VALUE1,PARAMATER2 VALUE2 (for example: P 2500, S 60,M .13)");
 
-            NEWLINE NEWLINE "P = PWM frequency (in Hz,ACCEPTABLE INPUTS: 687 - 10000)"
+    // The ranges are the limits params_valid() checks in this build, the injected depth cut to three decimals
+    sprintf(line, NEWLINE NEWLINE "P = PWM frequency (in Hz, ACCEPTABLE INPUTS: %ld - %ld)", (long) PWMWAVFREQ_MIN,
+            (long) PWMWAVFREQ_MAX);
+    scia_msg(line);
 
-            NEWLINE "S = Sin wave frequency (in Hz, ACCEPTABLE INPUTS: 1 - 300)"
+    sprintf(line, NEWLINE "S = Sin wave frequency (in Hz, ACCEPTABLE INPUTS: %ld - %ld, below half the PWM frequency)",
+            (long) SINWAVFREQ_MIN, (long) SINWAVFREQ_MAX);
+    scia_msg(line);
 
-            NEWLINE "M = Modulation depth (ACCEPTABLE INPUTS: 0.0 - 1.0, up to three decimal points)"
+    sprintf(line, NEWLINE "M = Modulation depth (ACCEPTABLE INPUTS: %.1f - %.1f, up to %.3f in modulation mode 1 or 2, "
+            "up to three decimal points)", MODULATION_DEPTH_MIN, MODULATION_DEPTH_MAX,
+            floor(MODULATION_DEPTH_INJECTED_MAX * 1000) / 1000);
+    scia_msg(line);
 
-            NEWLINE "O = Offset (volts, ACCEPTABLE INPUTS: +-((1-Modulation depth) / 2), up to three decimal points )"
+    scia_msg(NEWLINE "V = Modulation mode (ACCEPTABLE INPUTS: 0 sine, 1 third harmonic injection, 2 space vector (min-max injection))");
 
-            NEWLINE "A1 = Angle 1 offset (in degrees, ACCEPTABLE INPUTS: -360 to 360)"
-
-            NEWLINE "A2 = Angle 2 offset (in degrees, ACCEPTABLE INPUTS:  -360 to 360)"
-
-            NEWLINE "A3 = Angle 3 offset (in degrees, ACCEPTABLE INPUTS:  -360 to 360)");
+    sprintf(line, NEWLINE "O = Offset (volts, ACCEPTABLE INPUTS: +-(1 - M) / 2, +-(1 - M * %.3f) / 2 in modulation mode 1 or 2, "
+            "up to three decimal points)", INJECTED_PEAK_SCALE);
+    scia_msg(line);
 
+    sprintf(line, NEWLINE "A1 - A%d = Angle offset of each channel (in degrees, ACCEPTABLE INPUTS: %d to %d)",
+            HAL_EPWM_CHANNELS, MIN_ANGLE, MAX_ANGLE);
+    scia_msg(line);
 }
 
 // SCI register initialization (Communication)
@@ -398,7 +422,74 @@ void scia_echoback_init()
 // Initialize registers the SCI FIFO
 void scia_fifo_init()
 {
-    SciaRegs.SCIFFTX.all = 0xE040;
-    SciaRegs.SCIFFRX.all = 0x2044;
+    SciaRegs.SCIFFTX.all = 0xE040;  // TX FIFO interrupt when empty, enabled by scia_xmit() once there is data
+    SciaRegs.SCIFFRX.all = 0x2061;  // RX FIFO interrupt enabled, fires on the first received character
     SciaRegs.SCIFFCT.all = 0x0;
 }
+
+// Initialize the SCI A RX and TX FIFO interrupts, call after the PIE vector table is initialized
+void init_scia_interrupts()
+{
+    EALLOW; // Enables access to emulation and other protected registers
+    PieVectTable.SCIRXINTA = &scia_rx_isr;
+    PieVectTable.SCITXINTA = &scia_tx_isr;
+    EDIS; // Disable access to emulation space and other protected registers
+
+    // Enable SCIA RX and TX INT in the PIE: Group 9 interrupt 1-2
+    PieCtrlRegs.PIEIER9.bit.INTx1 = 1;
+    PieCtrlRegs.PIEIER9.bit.INTx2 = 1;
+
+    IER |= M_INT9; // Enable CPU INT9 which is connected to SCIA RX/TX INT
+}
+
+/*
+ * Interrupt service routine for the SCI A RX FIFO.
+ * Moves every received character from the FIFO into the RX ring buffer.
+ */
+__interrupt void scia_rx_isr(void)
+{
+    while (hal_scia_rx_level() != 0)
+    {
+        Uint16 ReceivedChar = hal_scia_read();
+        Uint16 head = sciaRxHead;
+        Uint16 next = (head + 1) & (SCIA_RX_RING_SIZE - 1);
+
+        if (next == sciaRxTail)
+        {
+            sciaRxOverflowCount++;  // Ring buffer full, main loop is not keeping up
+        }
+        else
+        {
+            sciaRxRing[head] = ReceivedChar;
+            sciaRxHead = next;
+        }
+    }
+
+    // Count characters lost in the 4 level hardware FIFO
+    if (hal_scia_rx_overflowed())
+    {
+        sciaRxOverflowCount++;
+    }
+
+    hal_scia_ack_rx_interrupt();   // Clear the interrupt flag
+}
+
+/*
+ * Interrupt service routine for the SCI A TX FIFO.
+ * Refills the FIFO from the TX ring buffer, disables itself once the ring buffer is empty.
+ */
+__interrupt void scia_tx_isr(void)
+{
+    while (hal_scia_tx_level() < SCIA_FIFO_DEPTH && sciaTxTail != sciaTxHead)
+    {
+        hal_scia_write(sciaTxRing[sciaTxTail]);
+        sciaTxTail = (sciaTxTail + 1) & (SCIA_TX_RING_SIZE - 1);
+    }
+
+    if (sciaTxTail == sciaTxHead)
+    {
+        hal_scia_tx_interrupt_enable(0);  // Nothing left to send
+    }
+
+    hal_scia_ack_tx_interrupt();   // Clear the interrupt flag
+}
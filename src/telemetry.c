@@ -0,0 +1,229 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include "telemetry.h"
+#include "protocol.h"
+#include "sci.h"
+#include "pwm_dma.h"
+#include "cla_shared.h"
+
+// Records written by the PWM ISR, sent by the main loop (single producer, single consumer)
+#pragma DATA_SECTION(telemetryRing, "pwmdata");
+#pragma DATA_SECTION(telemetryPlans, "pwmdata");
+TelemetryRecord telemetryRing[TELEMETRY_RING_SIZE];
+TelemetryPlan telemetryPlans[TELEMETRY_PLAN_SLOTS];
+Uint16 telemetryPlanHead = 0;
+volatile Uint16 telemetryHead = 0;
+volatile Uint16 telemetryTail = 0;
+volatile Uint16 telemetryPeriods = 0;
+Uint32 telemetryNextCycle = 0;
+Uint16 telemetryDropped = 0;
+
+// Plan sequence of the last parameter frame, and whether one has been sent since the stream started
+static Uint16 paramsSequence;
+static Uint16 paramsSent = 0;
+
+// Records dropped by the main loop because the parameters of their sequence were no longer kept
+static Uint16 staleDropped = 0;
+
+// Frame being sent and its running CRC
+static Uint16 frameCrc;
+
+// Reinterprets the bits of a float as a Uint32
+typedef union
+{
+    float f;
+    Uint32 u;
+} FloatBits;
+
+// Sends one frame byte and adds it to the frame CRC
+static void frame_byte(Uint16 byte)
+{
+    byte &= 0xFF;
+    frameCrc = crc16_update(frameCrc, byte);
+    scia_xmit(byte);
+}
+
+static void frame_u16(Uint16 value)
+{
+    frame_byte(value);
+    frame_byte(value >> 8);
+}
+
+static void frame_u32(Uint32 value)
+{
+    frame_u16(value);
+    frame_u16(value >> 16);
+}
+
+static void frame_float(float value)
+{
+    FloatBits bits;
+    bits.f = value;
+    frame_u32(bits.u);
+}
+
+// Starts a telemetry frame, unlike a reply the payload carries no request opcode
+static void frame_begin(Uint16 opcode, Uint16 length)
+{
+    scia_xmit(PROTOCOL_SYNC);
+    frameCrc = 0xFFFF;
+    frame_byte(length);
+    frame_byte(opcode);
+}
+
+static void frame_end(void)
+{
+    Uint16 crc = frameCrc;
+    scia_xmit(crc >> 8);
+    scia_xmit(crc & 0xFF);
+}
+
+/*
+ * Streams a record every periods PWM periods from the next period on, 0 stops the stream.
+ * The records come from the PWM ISR, so it takes the outputs back from the DMA tables and the CLA;
+ * they stay with the ISR until the next parameter change after the stream has stopped.
+ */
+void telemetry_start(Uint16 periods)
+{
+    telemetryPeriods = 0;   // The ISR stops recording before the ring is reset
+
+#ifdef DMA_TABLE_MODE
+    if (periods && dmaTableModeActive)
+    {
+        dma_stop_table_mode();
+    }
+#endif
+#ifdef CLA_OFFLOAD
+    if (periods && claActive)
+    {
+        cla_stop();
+    }
+#endif
+
+    telemetryTail = telemetryHead;
+    telemetryDropped = 0;
+    paramsSent = 0;
+    staleDropped = 0;
+
+    // The plan running now is the first one the records refer to, the ISR adds every one it switches to
+    DINT;
+    telemetry_isr_plan(&liveWaveformPlan, plan_applied_sequence());
+    telemetryNextCycle = carrierCycleCount;
+    telemetryPeriods = periods;
+    EINT;
+}
+
+/*
+ * Copies the parameters kept for a plan sequence (see telemetry_isr_plan()).
+ * Returns 1 if found, 0 if the ISR has switched plans TELEMETRY_PLAN_SLOTS times since that sequence.
+ */
+static Uint16 find_plan(Uint16 sequence, TelemetryPlan *plan)
+{
+    Uint16 slot, found = 0;
+
+    DINT;   // The ISR reuses the oldest slot at its next switch
+    for (slot = 0; slot < TELEMETRY_PLAN_SLOTS; slot++)
+    {
+        if (telemetryPlans[slot].sequence == sequence)
+        {
+            *plan = telemetryPlans[slot];
+            found = 1;
+            break;
+        }
+    }
+    EINT;
+    return found;
+}
+
+/*
+ * Sends the parameter set of a plan sequence: Uint16 sequence, float carrier and sine frequency (achieved),
+ * float modulation depth and offset, one float phase lead (degrees) per channel, Uint16 TBPRD, clock
+ * prescaler, modulation mode and waveform. These are the values the plan started with, a running profile
+ * ramps the depth and frequency without a new sequence (the records carry its tuning word).
+ */
+static void send_params(const TelemetryPlan *plan)
+{
+    Uint16 ch;
+    float period = (float) plan->timerPeriod;
+
+    frame_begin(OPCODE_TELEMETRY_PARAMS, 26 + 4 * HAL_EPWM_CHANNELS);
+    frame_u16(plan->sequence);
+    frame_float(plan->carrierFreq);
+    frame_float(plan->sineFreq);
+    frame_float(-plan->amplitude * SINE_TABLE_AMPLITUDE / (.5 * period));
+    frame_float(plan->bias / period - .5);
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        frame_float((float) ((long double) plan->channelPhase[ch] * 360 / DDS_PHASE_FULL_SCALE));
+    }
+    frame_u16(plan->timerPeriod);
+    frame_u16(plan->clockPrescale);
+    frame_u16(plan->modulationMode);
+    frame_u16(plan->waveform);
+    frame_end();
+}
+
+/*
+ * Sends one record: Uint32 carrier cycle, Uint32 phase word, Uint32 tuning word, Uint16 plan sequence,
+ * Uint16 records dropped right before this one (saturates), one Uint16 CMPA per channel.
+ */
+static void send_record(const TelemetryRecord *record, Uint16 dropped)
+{
+    Uint16 ch;
+
+    frame_begin(OPCODE_TELEMETRY_SAMPLE, 16 + 2 * HAL_EPWM_CHANNELS);
+    frame_u32(record->cycle);
+    frame_u32(record->phase);
+    frame_u32(record->tuningWord);
+    frame_u16(record->sequence);
+    frame_u16(dropped);
+    for (ch = 0; ch < HAL_EPWM_CHANNELS; ch++)
+    {
+        frame_u16(record->compare[ch]);
+    }
+    frame_end();
+}
+
+/*
+ * Background telemetry work for the main loop: sends the queued records while the TX ring has room for
+ * the frames and TELEMETRY_TX_RESERVE more, so the stream never crowds out replies and echoes.
+ * A record of a new plan sequence is preceded by the parameter frame of that sequence. Records whose
+ * parameters are no longer kept are dropped and counted in the next record sent.
+ */
+void telemetry_service(void)
+{
+    TelemetryPlan plan;
+
+    while (telemetryTail != telemetryHead)
+    {
+        const TelemetryRecord *record = &telemetryRing[telemetryTail];
+        Uint16 newParams = !paramsSent || record->sequence != paramsSequence;
+        Uint16 needed = 22 + 2 * HAL_EPWM_CHANNELS + TELEMETRY_TX_RESERVE;
+        Uint32 dropped;
+
+        if (newParams)
+        {
+            needed += 32 + 4 * HAL_EPWM_CHANNELS;
+        }
+        if (scia_tx_free() < needed)
+        {
+            return;
+        }
+
+        dropped = (Uint32) staleDropped + record->dropped;
+        if (newParams)
+        {
+            if (!find_plan(record->sequence, &plan))
+            {
+                staleDropped = dropped + 1 > 0xFFFF ? 0xFFFF : dropped + 1;
+                telemetryTail = (telemetryTail + 1) & (TELEMETRY_RING_SIZE - 1);
+                continue;
+            }
+            send_params(&plan);
+            paramsSequence = plan.sequence;
+            paramsSent = 1;
+        }
+        send_record(record, dropped > 0xFFFF ? 0xFFFF : dropped);
+        staleDropped = 0;
+        telemetryTail = (telemetryTail + 1) & (TELEMETRY_RING_SIZE - 1);
+    }
+}
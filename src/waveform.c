@@ -0,0 +1,114 @@
+#include "DSP28x_Project.h"     // Device Headerfile and Examples Include File
+#include "waveform.h"
+#include "sci.h"
+
+// Double buffered waveform tables, one is played while the other one is uploaded
+#pragma DATA_SECTION(waveformTables, "wavetables");
+static int16 waveformTables[2][WAVEFORM_TABLE_MAX_SIZE];
+
+// Committed table the plans point at
+static Uint16 activeTable = 0;
+static Uint16 activeBits = 0;           // 0 until a table has been committed
+
+// Upload in progress into the other buffer
+static Uint16 uploadBits = 0;           // 0 when no upload is in progress
+static Uint16 uploadReceived = 0;       // Samples received so far, chunks arrive in order
+
+// Returns 1 while the ISR still plays the buffer the next upload goes into, the one of the previous commit
+int waveform_upload_busy(void)
+{
+    return liveWaveformPlan.table == waveformTables[activeTable ^ 1];
+}
+
+/*
+ * Starts an upload of a table with length samples (a power of two between 2^WAVEFORM_TABLE_MIN_BITS
+ * and WAVEFORM_TABLE_MAX_SIZE) into the buffer that is not playing.
+ * Returns 1 if started, 0 if the length is not valid or the ISR still plays that buffer (waveform_upload_busy()).
+ */
+int waveform_upload_begin(Uint16 length)
+{
+    Uint16 bits;
+
+    for (bits = WAVEFORM_TABLE_MIN_BITS; bits <= WAVEFORM_TABLE_MAX_BITS; bits++)
+    {
+        if (length == (1 << bits) && !waveform_upload_busy())
+        {
+            uploadBits = bits;
+            uploadReceived = 0;
+            return 1;
+        }
+    }
+
+    uploadBits = 0;
+    return 0;
+}
+
+/*
+ * Stores count samples, sent as little endian byte pairs, at the given sample offset.
+ * Chunks have to arrive in order, a chunk that does not continue the table is rejected.
+ * Returns 1 if stored, 0 otherwise.
+ */
+int waveform_upload_chunk(Uint16 offset, const Uint16 *bytes, Uint16 count)
+{
+    Uint16 i;
+    int16 *table = waveformTables[activeTable ^ 1];
+
+    if (!uploadBits || offset != uploadReceived || count > (1 << uploadBits) - offset)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        table[offset + i] = (int16) (bytes[2 * i] | (bytes[2 * i + 1] << 8));
+    }
+    uploadReceived += count;
+    return 1;
+}
+
+/*
+ * Makes the completely uploaded table the active one and selects it, the ISR switches to it
+ * at the next period boundary. The previously active buffer then takes the next upload.
+ * Returns 1 if switched, 0 if no complete table has been uploaded.
+ */
+int waveform_upload_commit(void)
+{
+    if (!uploadBits || uploadReceived != (1 << uploadBits))
+    {
+        return 0;
+    }
+
+    activeTable ^= 1;
+    activeBits = uploadBits;
+    uploadBits = 0;
+
+    liveEpwmParams.waveform = WAVEFORM_TABLE;
+    live_params_changed();
+    apply_live_params();
+    return 1;
+}
+
+// Returns 1 once a table has been committed
+int waveform_table_ready(void)
+{
+    return activeBits != 0;
+}
+
+// Points a plan at the sine table or at the committed waveform table
+void waveform_select_table(Uint16 waveform, WaveformPlan *plan)
+{
+    if (waveform == WAVEFORM_TABLE && activeBits)
+    {
+        plan->table = waveformTables[activeTable];
+        plan->tableShift = 32 - activeBits;
+        plan->tableMask = (1 << activeBits) - 1;
+        plan->sine = 0;
+    }
+    else
+    {
+        plan->table = sineTable;
+        plan->tableShift = SINE_TABLE_SHIFT;
+        plan->tableMask = SINE_TABLE_MASK;
+        plan->sine = 1;
+    }
+}
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+Decodes a capture of the telemetry stream (see include/telemetry.h) into CSV for plotting.
+
+Capture the raw bytes of the serial port after sending OPCODE_TELEMETRY, e.g. with the terminal's
+"save received data" or `cat /dev/ttyUSB0 > capture.bin`, then run
+
+    python3 telemetry_decode.py capture.bin > telemetry.csv
+
+Frames with a bad CRC, other replies and ASCII text in the capture are skipped. Each sample row carries the
+parameter set of the last OPCODE_TELEMETRY_PARAMS frame. The time column counts carrier cycles at the
+carrier frequency they ran at, starting from the first sample.
+"""
+import argparse
+import csv
+import struct
+import sys
+
+SYNC = 0xA5
+OPCODE_TELEMETRY_PARAMS = 0x60
+OPCODE_TELEMETRY_SAMPLE = 0x61
+PHASE_FULL_SCALE = 2.0 ** 32
+
+
+def crc16_update(crc, byte):
+    """CRC16 CCITT (polynomial 0x1021), as crc16_update() in protocol.c."""
+    crc ^= byte << 8
+    for _ in range(8):
+        crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def frames(data):
+    """Yields (opcode, payload) of every frame with a valid CRC, resyncing on the next sync byte otherwise."""
+    i = 0
+    while True:
+        i = data.find(bytes([SYNC]), i)
+        if i < 0 or i + 5 > len(data):
+            return
+        length = data[i + 1]
+        end = i + 3 + length
+        if end + 2 > len(data):
+            return
+        crc = 0xFFFF
+        for byte in data[i + 1:end]:
+            crc = crc16_update(crc, byte)
+        if crc == (data[end] << 8 | data[end + 1]):
+            yield data[i + 2], data[i + 3:end]
+            i = end + 2
+        else:
+            i += 1
+
+
+def decode_params(payload):
+    channels = (len(payload) - 26) // 4
+    sequence, carrier, sine, depth, offset = struct.unpack_from("<Hffff", payload, 0)
+    leads = struct.unpack_from("<%df" % channels, payload, 18)
+    tbprd, prescale, mode, waveform = struct.unpack_from("<HHHH", payload, 18 + 4 * channels)
+    return {
+        "sequence": sequence, "carrier_hz": carrier, "sine_hz": sine, "modulation_depth": depth,
+        "offset": offset, "phase_leads": leads, "tbprd": tbprd, "clock_prescale": prescale,
+        "modulation_mode": mode, "waveform": waveform,
+    }
+
+
+def decode_sample(payload):
+    channels = (len(payload) - 16) // 2
+    cycle, phase, tuning_word, sequence, dropped = struct.unpack_from("<IIIHH", payload, 0)
+    compares = struct.unpack_from("<%dH" % channels, payload, 16)
+    return cycle, phase, tuning_word, sequence, dropped, compares
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a telemetry capture into CSV")
+    parser.add_argument("capture", help="raw serial capture, - for stdin")
+    parser.add_argument("-o", "--output", help="CSV file, stdout if omitted")
+    args = parser.parse_args()
+
+    if args.capture == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    writer = None
+    params = None
+    time_base = None        # (cycle, seconds) the time column counts on from, at the current carrier
+    last = None             # (cycle, seconds) of the last sample
+    samples = 0
+
+    for opcode, payload in frames(data):
+        if opcode == OPCODE_TELEMETRY_PARAMS and len(payload) >= 26:
+            params = decode_params(payload)
+            if last is not None:
+                time_base = last
+            continue
+        if opcode != OPCODE_TELEMETRY_SAMPLE or len(payload) < 16:
+            continue
+
+        cycle, phase, tuning_word, sequence, dropped, compares = decode_sample(payload)
+        channels = len(compares)
+        if writer is None:
+            writer = csv.writer(out)
+            writer.writerow(["time_s", "cycle", "sequence", "dropped", "phase_deg", "sine_hz"]
+                            + ["cmpa%d" % (ch + 1) for ch in range(channels)]
+                            + ["duty%d" % (ch + 1) for ch in range(channels)]
+                            + ["carrier_hz", "modulation_depth", "offset", "tbprd", "modulation_mode", "waveform"])
+
+        if params is None:
+            row_time = ""
+            sine = ""
+            duties = [""] * channels
+            settings = [""] * 6
+        else:
+            if time_base is None:
+                time_base = (cycle, 0.0)
+            # Carrier cycles wrap after 2^32
+            seconds = time_base[1] + ((cycle - time_base[0]) & 0xFFFFFFFF) / params["carrier_hz"]
+            last = (cycle, seconds)
+            row_time = "%.9f" % seconds
+            sine = "%.6f" % (tuning_word / PHASE_FULL_SCALE * params["carrier_hz"])
+            # compare = (1 - duty) * TBPRD
+            duties = ["%.6f" % (1 - value / params["tbprd"]) for value in compares]
+            settings = ["%.3f" % params["carrier_hz"], "%.6f" % params["modulation_depth"],
+                        "%.6f" % params["offset"], params["tbprd"], params["modulation_mode"], params["waveform"]]
+
+        writer.writerow([row_time, cycle, sequence, dropped, "%.6f" % (phase * 360 / PHASE_FULL_SCALE), sine]
+                        + list(compares) + duties + settings)
+        samples += 1
+
+    if args.output:
+        out.close()
+    print("%d samples" % samples, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()